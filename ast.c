@@ -4,13 +4,21 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "jit.h"
+
 
 void ast_init(ast_t *ast) {
     assert(ast != NULL);
     ast->arena = arena_new();
+    ast->loops = NULL;
 }
 void ast_destroy(ast_t *ast) {
     assert(ast != NULL);
+    for (NodeStmtWhile *loop = ast->loops; loop != NULL; loop = loop->next) {
+        if (loop->jit != NULL) {
+            jit_free_loop(loop->jit);
+        }
+    }
     arena_free(ast->arena);
 }
 
@@ -50,6 +58,39 @@ size_t ast_nodelist_length(NodeList *list) {
     return list->length;
 }
 
+/*! Returns the name of a node type, for diagnostics. */
+const char *ast_node_type_to_str(NodeType type) {
+    switch (type) {
+        case STMT_SEQUENCE:           return "STMT_SEQUENCE";
+        case STMT_ASSIGN:             return "STMT_ASSIGN";
+        case STMT_ASSIGN_INCREMENT:   return "STMT_ASSIGN_INCREMENT";
+        case STMT_DEL:                return "STMT_DEL";
+        case STMT_IF:                 return "STMT_IF";
+        case STMT_WHILE:              return "STMT_WHILE";
+
+        case EXPR_LITERAL_STRING:     return "EXPR_LITERAL_STRING";
+        case EXPR_LITERAL_INTEGER:    return "EXPR_LITERAL_INTEGER";
+        case EXPR_LITERAL_FLOAT:      return "EXPR_LITERAL_FLOAT";
+        case EXPR_LITERAL_LIST:       return "EXPR_LITERAL_LIST";
+        case EXPR_LITERAL_DICT:       return "EXPR_LITERAL_DICT";
+        case EXPR_LITERAL_SINGLETON:  return "EXPR_LITERAL_SINGLETON";
+
+        case EXPR_IDENTIFIER:         return "EXPR_IDENTIFIER";
+        case EXPR_NOT_TEST:           return "EXPR_NOT_TEST";
+        case EXPR_AND_TEST:           return "EXPR_AND_TEST";
+        case EXPR_OR_TEST:            return "EXPR_OR_TEST";
+        case EXPR_BUILTIN:            return "EXPR_BUILTIN";
+        case EXPR_CALL:               return "EXPR_CALL";
+        case EXPR_SUBSCRIPT:          return "EXPR_SUBSCRIPT";
+
+        case EXPR_BUILTIN_INT:        return "EXPR_BUILTIN_INT";
+        case EXPR_COMPARE_SUBSCRIPTS: return "EXPR_COMPARE_SUBSCRIPTS";
+        case EXPR_COMPARE_LEN:        return "EXPR_COMPARE_LEN";
+
+        default:                      return "<unknown>";
+    }
+}
+
 #define AST_NODE_DECL(TYPENAME, TYPE) \
     TYPENAME *node = (TYPENAME *) ast_alloc_node(ast, sizeof(TYPENAME), TYPE)
 
@@ -69,8 +110,26 @@ Node *ast_alloc_sequence(ast_t *ast, NodeList *statements) {
     return (Node *) node;
 }
 
+/*!
+ * Returns true if an assignment is of the form `x = x + n` or `x = x - n`,
+ * where n is an integer literal.
+ */
+static bool is_increment(Node *left, Node *right) {
+    if (left == NULL || right == NULL ||
+            left->type != EXPR_IDENTIFIER || right->type != EXPR_BUILTIN) {
+        return false;
+    }
+
+    NodeExprBuiltin *builtin = (NodeExprBuiltin *) right;
+    return (builtin->builtin_type == OP_ADD || builtin->builtin_type == OP_SUBTRACT) &&
+        builtin->left != NULL && builtin->left->type == EXPR_IDENTIFIER &&
+        builtin->right != NULL && builtin->right->type == EXPR_LITERAL_INTEGER &&
+        strcmp(((NodeExprIdentifier *) left)->name,
+               ((NodeExprIdentifier *) builtin->left)->name) == 0;
+}
+
 Node *ast_alloc_assign(ast_t *ast, Node *left, Node *right) {
-    AST_NODE_DECL(NodeStmtAssign, STMT_ASSIGN);
+    AST_NODE_DECL(NodeStmtAssign, is_increment(left, right) ? STMT_ASSIGN_INCREMENT : STMT_ASSIGN);
     if (node) {
         node->left = left;
         node->right = right;
@@ -98,6 +157,11 @@ Node *ast_alloc_while(ast_t *ast, Node *cond, Node *body) {
     if (node) {
         node->cond = cond;
         node->body = body;
+        node->iterations = 0;
+        node->jit = NULL;
+        node->jit_failed = false;
+        node->next = ast->loops;
+        ast->loops = node;
     }
     return (Node *) node;
 }
@@ -128,6 +192,8 @@ Node *ast_alloc_literal_dict(ast_t *ast, NodeList *keys, NodeList *values) {
     if (node) {
         node->keys = keys;
         node->values = values;
+        node->shape = NULL;
+        node->unshapeable = false;
     }
     return (Node *) node;
 }
@@ -171,12 +237,40 @@ Node *ast_alloc_or_test(ast_t *ast, Node *left, Node *right) {
     return (Node *) node;
 }
 
+/*!
+ * Picks the node type for a builtin operator. Comparisons between two
+ * subscripts, and comparisons against `len(...)`, get their own
+ * superinstructions.
+ */
+static NodeType builtin_node_type(NodeExprBuiltinType type, Node *left, Node *right) {
+    if (type < COMP_EQUALS || left == NULL || right == NULL) {
+        return EXPR_BUILTIN;
+    }
+
+    if (left->type == EXPR_SUBSCRIPT && right->type == EXPR_SUBSCRIPT) {
+        return EXPR_COMPARE_SUBSCRIPTS;
+    }
+
+    if (right->type == EXPR_CALL) {
+        NodeExprCall *call = (NodeExprCall *) right;
+        if (call->func->type == EXPR_IDENTIFIER &&
+                strcmp(((NodeExprIdentifier *) call->func)->name, "len") == 0 &&
+                call->args != NULL && ast_nodelist_length(call->args) == 1) {
+            return EXPR_COMPARE_LEN;
+        }
+    }
+
+    return EXPR_BUILTIN;
+}
+
 Node *ast_alloc_builtin(ast_t *ast, NodeExprBuiltinType type, Node *left, Node *right) {
-    AST_NODE_DECL(NodeExprBuiltin, EXPR_BUILTIN);
+    AST_NODE_DECL(NodeExprBuiltin, builtin_node_type(type, left, right));
     if (node) {
         node->builtin_type = type;
         node->left = left;
         node->right = right;
+        node->cache.type = NUM_TYPES;
+        node->int_streak = 0;
     }
     return (Node *) node;
 }
@@ -195,6 +289,9 @@ Node *ast_alloc_subscript(ast_t *ast, Node *obj, Node *index) {
     if (node) {
         node->obj = obj;
         node->index = index;
+        node->cache_shape = NULL;
+        node->cache_slot = -1;
+        node->cache.type = NUM_TYPES;
     }
     return (Node *) node;
 }
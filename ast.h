@@ -11,6 +11,9 @@ typedef enum NodeType {
     STMT_SEQUENCE,
 
     STMT_ASSIGN,
+    STMT_ASSIGN_INCREMENT,  /*!< Superinstruction for `x = x + n` and
+                             *   `x = x - n` with an integer literal n.
+                             *   Uses NodeStmtAssign. */
     STMT_DEL,
     STMT_IF,
     STMT_WHILE,
@@ -31,7 +34,21 @@ typedef enum NodeType {
     EXPR_OR_TEST,
     EXPR_BUILTIN,
     EXPR_CALL,
-    EXPR_SUBSCRIPT
+    EXPR_SUBSCRIPT,
+
+    EXPR_BUILTIN_INT,       /*!< A NodeExprBuiltin that has been quickened
+                             *   for integer operands. The parser never
+                             *   produces these; eval rewrites nodes in
+                             *   place. */
+
+    EXPR_COMPARE_SUBSCRIPTS,/*!< Superinstruction for comparing two
+                             *   subscripts, as in `a[i] < a[j]`.
+                             *   Uses NodeExprBuiltin. */
+    EXPR_COMPARE_LEN,       /*!< Superinstruction for comparing against a
+                             *   length, as in `i < len(a)`.
+                             *   Uses NodeExprBuiltin. */
+
+    NUM_NODE_TYPES
 } NodeType;
 
 static inline bool is_statement(NodeType type) {
@@ -81,6 +98,20 @@ typedef struct NodeStmtWhile {
     NodeType type;
     Node *cond;
     Node *body;
+
+    /*! How many iterations of this loop have been interpreted since it was
+     *  last considered for the JIT. */
+    unsigned iterations;
+
+    /*! The compiled form of this loop, or NULL if it hasn't been compiled.
+     *  jit_failed is set once compiling it has been tried and failed, or
+     *  once the compiled code has had to give up. */
+    struct jit_loop *jit;
+    bool jit_failed;
+
+    /*! The next while loop in the same AST, so that compiled loops can be
+     *  freed along with it. */
+    struct NodeStmtWhile *next;
 } NodeStmtWhile;
 
 typedef struct NodeExprLiteralString {
@@ -102,6 +133,15 @@ typedef struct NodeExprLiteralDict {
     NodeType type;
     NodeList *keys;
     NodeList *values;
+
+    /*! The shape of the dicts and records built from this literal, or NULL
+     *  if it hasn't been computed. Only used when all the keys are distinct
+     *  string literals. */
+    struct shape *shape;
+
+    /*! Set once the literal is known not to have a shape, so that its keys
+     *  are only examined the first time it is evaluated. */
+    bool unshapeable;
 } NodeExprLiteralDict;
 
 typedef enum SingletonType {
@@ -159,11 +199,35 @@ static inline bool is_unary_builtin(NodeExprBuiltinType type) {
     return type == UOP_NEGATE || type == UOP_IDENTITY;
 }
 
+/*!
+ * A monomorphic inline cache for the type dispatch done by an operator or
+ * subscript node. It remembers the operand type seen the last time the node
+ * was evaluated and the handler that type resolved to, so that evaluating the
+ * node again only needs a type check. An empty cache has type NUM_TYPES.
+ */
+typedef struct InlineCache {
+    value_type_t type;
+
+    /*! Which member is used depends on the operation the node performs. */
+    union {
+        reference_t (*builtin)(value_t *l, value_t *r);
+        int (*cmp)(value_t *l, value_t *r);
+        bool (*eq)(value_t *l, value_t *r);
+        reference_t (*subscr_get)(value_t *obj, reference_t subscript);
+        void (*subscr_set)(value_t *obj, reference_t subscript, reference_t value);
+    };
+} InlineCache;
+
 typedef struct NodeExprBuiltin {
     NodeType type;
     NodeExprBuiltinType builtin_type;
     Node *left;
     Node *right;
+
+    InlineCache cache;
+
+    /*! How many times in a row this node has seen integer operands. */
+    unsigned int_streak;
 } NodeExprBuiltin;
 
 typedef struct NodeExprCall {
@@ -176,11 +240,23 @@ typedef struct NodeExprSubscript {
     NodeType type;
     Node *obj;
     Node *index;
+
+    /*! When index is a string literal and obj evaluates to a record, the
+     *  last record shape seen and the slot the literal resolved to in it. */
+    struct shape *cache_shape;
+    int64_t cache_slot;
+
+    /*! The dispatch cache for reading, or assigning to, this subscript.
+     *  A subscript node is only ever used for one of the two. */
+    InlineCache cache;
 } NodeExprSubscript;
 
 typedef struct ast {
     arena_t *arena;
     Node *root;
+
+    /*! Every while loop in the AST, chained through their next fields. */
+    NodeStmtWhile *loops;
 } ast_t;
 
 void ast_init(ast_t *ast);
@@ -191,6 +267,8 @@ NodeList *ast_alloc_nodelist(ast_t *ast);
 void ast_nodelist_append(ast_t *ast, NodeList *list, Node *node);
 size_t ast_nodelist_length(NodeList *list);
 
+const char *ast_node_type_to_str(NodeType type);
+
 Node *ast_alloc_sequence(ast_t *ast, NodeList *statements);
 Node *ast_alloc_assign(ast_t *ast, Node *left, Node *right);
 Node *ast_alloc_del(ast_t *ast, Node *arg);
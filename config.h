@@ -16,6 +16,18 @@
 /*! Default initial size for realloc-growing arrays. */
 #define INITIAL_SIZE 8
 
+/*!
+ * Number of consecutive evaluations with integer operands after which an
+ * operator node is rewritten into its integer-specialized form.
+ */
+#define QUICKEN_THRESHOLD 4
+
+/*!
+ * Number of interpreted iterations after which a while loop is compiled to
+ * native code, if the JIT supports it.
+ */
+#define JIT_THRESHOLD 100
+
 /* A handy macro to delineate an unreachable branch in switches. */
 #define UNREACHABLE() \
     do { \
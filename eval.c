@@ -1,17 +1,31 @@
 #include "eval.h"
 
 #include <assert.h>
+#include <ctype.h>
 #include <math.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "ast.h"
 #include "config.h"
+#include "eval_array.h"
+#include "eval_bigint.h"
+#include "eval_bytes.h"
 #include "eval_dict.h"
+#include "eval_list.h"
+#include "eval_pmap.h"
+#include "eval_record.h"
+#include "eval_set.h"
+#include "eval_tuple.h"
 #include "eval_types.h"
 #include "eval_refs.h"
+#include "eval_vector.h"
+#include "eval_weakref.h"
 #include "exception.h"
+#include "jit.h"
 #include "mm.h"
 #include "refs.h"
+#include "shape.h"
 
 /* Global variable information. */
 
@@ -29,6 +43,7 @@ static size_t max_vars = 0;
 
 //// GLOBAL VARIABLES ////
 
+static global_variable_t *globals_find(const char *name);
 static reference_t globals_get(const char *name);
 static void globals_set(const char *name, reference_t value);
 static void globals_delete(const char *name);
@@ -36,24 +51,127 @@ static void globals_delete(const char *name);
 //// AST EVALUATION FUNCTIONS ////
 
 static reference_t eval_stmt(Node *node);
+static reference_t eval_stmt_node(Node *node);
 
 static reference_t eval_stmt_sequence(NodeStmtSequence *sequence);
 static void eval_stmt_assign(NodeStmtAssign *assign);
+static void eval_stmt_increment(NodeStmtAssign *assign);
 static void eval_stmt_del(NodeStmtDel *del);
 static void eval_stmt_if(NodeStmtIf *ifn);
 static void eval_stmt_while(NodeStmtWhile *ifn);
 
 static reference_t eval_expr(Node *node);
+static reference_t eval_expr_node(Node *node);
+static bool eval_cond(Node *node);
 
 static reference_t eval_identifier(NodeExprIdentifier *ident);
 static reference_t eval_not_test(NodeExprNotTest *test);
 static reference_t eval_and_test(NodeExprAndTest *test);
 static reference_t eval_or_test(NodeExprOrTest *test);
 static reference_t eval_builtin(NodeExprBuiltin *builtin);
+static reference_t eval_builtin_int(NodeExprBuiltin *builtin);
+static reference_t eval_compare_subscripts(NodeExprBuiltin *builtin);
+static reference_t eval_compare_len(NodeExprBuiltin *builtin);
+static bool eval_cond_builtin(NodeExprBuiltin *builtin);
+static bool eval_cond_builtin_int(NodeExprBuiltin *builtin);
+static bool eval_cond_compare_subscripts(NodeExprBuiltin *builtin);
+static bool eval_cond_compare_len(NodeExprBuiltin *builtin);
 static reference_t eval_call(NodeExprCall *call);
 static reference_t eval_subscript(NodeExprSubscript *subscript);
 static reference_t eval_literal_list(NodeExprLiteralList *list);
 static reference_t eval_literal_dict(NodeExprLiteralDict *dist);
+static reference_t eval_literal_dict_hashed(NodeExprLiteralDict *dict,
+        reference_t ref_dict, size_t length);
+static reference_t eval_literal_record(NodeExprLiteralDict *dict);
+
+static bool eval_stmt_while_jit(NodeStmtWhile *whilen);
+
+static bool int_arithmetic(NodeExprBuiltinType type, int64_t l, int64_t r, int64_t *result);
+static bool int_comparison(NodeExprBuiltinType type, int64_t l, int64_t r);
+static bool eval_unboxed(Node *node, int64_t *result);
+static void globals_store_int(global_variable_t *var, int64_t value);
+
+static int64_t record_literal_slot(NodeExprSubscript *subscript, value_t *obj);
+static shape_t *literal_dict_shape(NodeExprLiteralDict *dict);
+
+//// PROFILING ////
+
+/*!
+ * When profiling, profile_counts[p][c] is the number of times a node of type
+ * c was evaluated as a child of a node of type p. The row NUM_NODE_TYPES
+ * counts nodes evaluated at the top level. NULL when profiling is off.
+ */
+static uint64_t (*profile_counts)[NUM_NODE_TYPES] = NULL;
+
+/*! The type of the node currently being evaluated, while profiling. */
+static NodeType profile_parent = NUM_NODE_TYPES;
+
+/*! The number of node pairs eval_profile_print reports. */
+#define PROFILE_TOP_PAIRS 25
+
+typedef struct {
+    NodeType parent;
+    NodeType child;
+    uint64_t count;
+} profile_pair_t;
+
+static int profile_pair_cmp(const void *l, const void *r) {
+    uint64_t lcount = ((const profile_pair_t *) l)->count;
+    uint64_t rcount = ((const profile_pair_t *) r)->count;
+    return (lcount < rcount) - (lcount > rcount);
+}
+
+/*!
+ * Prints the most frequently evaluated parent/child node type pairs. These
+ * are the candidates for new superinstructions.
+ */
+static void eval_profile_print(void) {
+    profile_pair_t pairs[(NUM_NODE_TYPES + 1) * NUM_NODE_TYPES];
+    size_t num_pairs = 0;
+    for (int parent = 0; parent <= NUM_NODE_TYPES; parent++) {
+        for (int child = 0; child < NUM_NODE_TYPES; child++) {
+            if (profile_counts[parent][child] > 0) {
+                pairs[num_pairs++] = (profile_pair_t) {
+                    parent, child, profile_counts[parent][child]
+                };
+            }
+        }
+    }
+    qsort(pairs, num_pairs, sizeof(profile_pair_t), profile_pair_cmp);
+
+    fprintf(stderr, "\nMost frequent node pairs (parent > child):\n");
+    for (size_t i = 0; i < num_pairs && i < PROFILE_TOP_PAIRS; i++) {
+        fprintf(stderr, "%12llu  %s > %s\n",
+                (unsigned long long) pairs[i].count,
+                pairs[i].parent == NUM_NODE_TYPES ?
+                    "<top>" : ast_node_type_to_str(pairs[i].parent),
+                ast_node_type_to_str(pairs[i].child));
+    }
+}
+
+/*!
+ * Turns on counting of evaluated node pairs. The most frequent pairs are
+ * printed to stderr when the interpreter exits.
+ */
+void eval_profile_start(void) {
+    profile_counts = calloc(NUM_NODE_TYPES + 1, sizeof(*profile_counts));
+    if (profile_counts == NULL) {
+        fprintf(stderr, "Failed to allocate profile counters\n");
+        return;
+    }
+    atexit(eval_profile_print);
+}
+
+/*! Evaluates a node with f, counting it as a child of the current node. */
+static reference_t eval_profiled(reference_t (*f)(Node *), Node *node) {
+    NodeType parent = profile_parent;
+    profile_counts[parent][node->type]++;
+
+    profile_parent = node->type;
+    reference_t result = f(node);
+    profile_parent = parent;
+    return result;
+}
 
 //// AST EVALUATION ////
 
@@ -95,6 +213,14 @@ reference_t eval_root(Node *root) {
     return result;
 }
 
+static reference_t eval_stmt(Node *node) {
+    /* Expressions are counted by eval_expr. */
+    if (profile_counts != NULL && is_statement(node->type)) {
+        return eval_profiled(eval_stmt_node, node);
+    }
+    return eval_stmt_node(node);
+}
+
 /*!
  * Evaluates the provided AST node as a statement. If the AST node is a sequence
  * then returns a reference to the result of the final statement in the
@@ -108,7 +234,7 @@ reference_t eval_root(Node *root) {
  * value. Otherwise, this function will return NULL_REF and the reference
  * should not be decremented.
  */
-static reference_t eval_stmt(Node *node) {
+static reference_t eval_stmt_node(Node *node) {
     assert(node != NULL);
 
     switch (node->type) {
@@ -119,6 +245,10 @@ static reference_t eval_stmt(Node *node) {
             eval_stmt_assign((NodeStmtAssign *) node);
             break;
 
+        case STMT_ASSIGN_INCREMENT:
+            eval_stmt_increment((NodeStmtAssign *) node);
+            break;
+
         case STMT_DEL:
             eval_stmt_del((NodeStmtDel *) node);
             break;
@@ -172,9 +302,22 @@ static void eval_stmt_assign(NodeStmtAssign *assign) {
             break;
 
         case EXPR_IDENTIFIER: {
+            const char *name = ((NodeExprIdentifier *) assign->left)->name;
+
+            /* Integer arithmetic is computed unboxed, and only boxed once it
+             * is stored into the variable. */
+            int64_t value;
+            global_variable_t *var;
+            if (assign->right->type == EXPR_BUILTIN_INT &&
+                    (var = globals_find(name)) != NULL &&
+                    eval_unboxed(assign->right, &value)) {
+                globals_store_int(var, value);
+                break;
+            }
+
             reference_t right = eval_expr(assign->right);
             if (!exception_occurred()) {
-                globals_set(((NodeExprIdentifier *) assign->left)->name, right);
+                globals_set(name, right);
                 decref(right);
             }
             break;
@@ -184,6 +327,8 @@ static void eval_stmt_assign(NodeStmtAssign *assign) {
         case EXPR_AND_TEST:
         case EXPR_OR_TEST:
         case EXPR_BUILTIN:
+        case EXPR_COMPARE_SUBSCRIPTS:
+        case EXPR_COMPARE_LEN:
             exception_set(EXC_SYNTAX_ERROR, "can't assign to operator");
             break;
 
@@ -198,10 +343,17 @@ static void eval_stmt_assign(NodeStmtAssign *assign) {
             if (!exception_occurred()) {
                 reference_t target = eval_expr(subscript->obj);
                 if (!exception_occurred()) {
-                    reference_t index = eval_expr(subscript->index);
-                    if (!exception_occurred()) {
-                        ref_subscr_set(target, index, right);
-                        decref(index);
+                    /* Assigning a record field by a literal name doesn't need
+                     * the name to be materialized as a string. */
+                    int64_t slot = record_literal_slot(subscript, deref(target));
+                    if (slot >= 0) {
+                        record_set_slot(deref(target), slot, right);
+                    } else {
+                        reference_t index = eval_expr(subscript->index);
+                        if (!exception_occurred()) {
+                            ref_subscr_set_cached(&subscript->cache, target, index, right);
+                            decref(index);
+                        }
                     }
                     decref(target);
                 }
@@ -219,6 +371,32 @@ static void eval_stmt_assign(NodeStmtAssign *assign) {
     }
 }
 
+/*!
+ * Evaluates `x = x + n` or `x = x - n` for an integer literal n. When x is an
+ * integer, this looks the variable up once and doesn't evaluate the operator
+ * node at all. Anything else, including a result that overflows, goes through
+ * the regular assignment.
+ */
+static void eval_stmt_increment(NodeStmtAssign *assign) {
+    const char *name = ((NodeExprIdentifier *) assign->left)->name;
+    global_variable_t *var = globals_find(name);
+    value_t *obj = var != NULL ? deref(var->ref) : NULL;
+    if (obj == NULL || obj->type != VAL_INTEGER) {
+        eval_stmt_assign(assign);
+        return;
+    }
+
+    NodeExprBuiltin *builtin = (NodeExprBuiltin *) assign->right;
+    int64_t delta = ((NodeExprLiteralInteger *) builtin->right)->value;
+    int64_t result;
+    if (!int_arithmetic(builtin->builtin_type,
+            ((integer_value_t *) obj)->integer_value, delta, &result)) {
+        eval_stmt_assign(assign);
+        return;
+    }
+    globals_store_int(var, result);
+}
+
 static void eval_stmt_del(NodeStmtDel *del) {
     /* For the deletion statement, we need to check the type of the right
      * hand parse in order to know what to do. */
@@ -243,6 +421,8 @@ static void eval_stmt_del(NodeStmtDel *del) {
         case EXPR_AND_TEST:
         case EXPR_OR_TEST:
         case EXPR_BUILTIN:
+        case EXPR_COMPARE_SUBSCRIPTS:
+        case EXPR_COMPARE_LEN:
             exception_set(EXC_SYNTAX_ERROR, "can't delete operator");
             break;
 
@@ -275,15 +455,12 @@ static void eval_stmt_del(NodeStmtDel *del) {
 }
 
 static void eval_stmt_if(NodeStmtIf *ifn) {
-    /* First evaluate the condition and coerce it to a boolean. */
-    reference_t cond_ref = eval_expr(ifn->cond);
+    /* First evaluate the condition as a boolean. */
+    bool cond = eval_cond(ifn->cond);
     if (exception_occurred()) {
         return;
     }
 
-    bool cond = ref_bool(cond_ref);
-    decref(cond_ref);
-
     /* If the condition is true, then execute the body. */
     if (cond) {
         eval_stmt(ifn->left);
@@ -297,20 +474,91 @@ static void eval_stmt_if(NodeStmtIf *ifn) {
 
 static void eval_stmt_while(NodeStmtWhile *whilen) {
     while (true) {
-        /* First evaluate the condition and coerce it to a boolean. */
-        reference_t cond_ref = eval_expr(whilen->cond);
-        if (exception_occurred()) {
+        /* Once the loop is hot, try to finish it in native code instead. */
+        if (whilen->iterations >= JIT_THRESHOLD && eval_stmt_while_jit(whilen)) {
             break;
         }
 
-        bool cond = ref_bool(cond_ref);
-        decref(cond_ref);
-
-        if (!cond) {
+        /* First evaluate the condition as a boolean. */
+        if (!eval_cond(whilen->cond)) {
             break;
         }
+
+        /* Stop at an exception in the body, since the fast paths in eval_cond
+         * wouldn't notice it. */
         eval_stmt(whilen->body);
+        if (exception_occurred()) {
+            break;
+        }
+        whilen->iterations++;
+    }
+}
+
+/*!
+ * Runs the rest of a hot while loop as native code, compiling it first if
+ * necessary. The compiled code keeps every variable unboxed, so this only
+ * succeeds if each variable the loop uses already holds an integer, apart
+ * from the containers it reads from, whose references are passed as they
+ * are. Returns false if the loop must keep being interpreted instead.
+ */
+static bool eval_stmt_while_jit(NodeStmtWhile *whilen) {
+    if (whilen->jit_failed) {
+        return false;
+    }
+    if (whilen->jit == NULL) {
+        whilen->jit = jit_compile_loop(whilen);
+        if (whilen->jit == NULL) {
+            whilen->jit_failed = true;
+            return false;
+        }
+    }
+
+    jit_loop_t *loop = whilen->jit;
+    global_variable_t *vars[JIT_MAX_VARS];
+    int64_t slots[JIT_MAX_VARS];
+    int64_t initial[JIT_MAX_VARS];
+
+    for (size_t i = 0; i < loop->num_vars; i++) {
+        vars[i] = globals_find(loop->vars[i]);
+        if (vars[i] != NULL && loop->is_ref[i]) {
+            /* The code never assigns these, so they aren't stored back. */
+            slots[i] = initial[i] = vars[i]->ref;
+            continue;
+        }
+
+        value_t *obj = vars[i] == NULL ? NULL : deref(vars[i]->ref);
+        if (obj == NULL || obj->type != VAL_INTEGER) {
+            /* Don't check again until the loop has been hot for a while. */
+            whilen->iterations = 0;
+            return false;
+        }
+        slots[i] = initial[i] = ((integer_value_t *) obj)->integer_value;
+    }
+
+    /* If the code gave up, nothing has been stored yet, so the interpreter
+     * can run the loop from here. It would most likely give up again, so it
+     * isn't entered again either. */
+    if (!loop->entry(slots)) {
+        whilen->jit_failed = true;
+        return false;
+    }
+
+    for (size_t i = 0; i < loop->num_vars; i++) {
+        if (slots[i] != initial[i]) {
+            globals_store_int(vars[i], slots[i]);
+            if (exception_occurred()) {
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+static reference_t eval_expr(Node *node) {
+    if (profile_counts != NULL) {
+        return eval_profiled(eval_expr_node, node);
     }
+    return eval_expr_node(node);
 }
 
 /*!
@@ -318,7 +566,7 @@ static void eval_stmt_while(NodeStmtWhile *whilen) {
  * value that it generates as a reference. This returned reference is a new
  * reference to the result value.
  */
-static reference_t eval_expr(Node *node) {
+static reference_t eval_expr_node(Node *node) {
     assert(node != NULL);
 
     switch (node->type) {
@@ -351,6 +599,13 @@ static reference_t eval_expr(Node *node) {
         case EXPR_SUBSCRIPT:
             return eval_subscript((NodeExprSubscript *) node);
 
+        case EXPR_BUILTIN_INT:
+            return eval_builtin_int((NodeExprBuiltin *) node);
+        case EXPR_COMPARE_SUBSCRIPTS:
+            return eval_compare_subscripts((NodeExprBuiltin *) node);
+        case EXPR_COMPARE_LEN:
+            return eval_compare_len((NodeExprBuiltin *) node);
+
         default:
             exception_set_format(EXC_INTERNAL, "ast node type '%d' not implemented", node->type);
     }
@@ -364,21 +619,17 @@ static reference_t eval_identifier(NodeExprIdentifier *ident) {
     return globals_get(ident->name);
 }
 
-static reference_t eval_not_test(NodeExprNotTest *test) {
-    /* First evaluate the operand. */
-    reference_t operand = eval_expr(test->operand);
-
-    /* Ensure that no exception has occurred. */
+/*! Boxes the result of a condition, unless evaluating it raised an exception. */
+static reference_t bool_result(bool value) {
     if (exception_occurred()) {
         return NULL_REF;
     }
+    return bool_ref(value);
+}
 
-    /* Then invert the truth value to get the result. */
-    reference_t result = bool_ref(!ref_bool(operand));
-    decref(operand);
-
-    /* Then pop the operand and push the result. */
-    return result;
+static reference_t eval_not_test(NodeExprNotTest *test) {
+    /* Only the operand's truth value is needed, so it is never boxed. */
+    return bool_result(!eval_cond(test->operand));
 }
 
 static reference_t eval_and_test(NodeExprAndTest *test) {
@@ -417,252 +668,1617 @@ static reference_t eval_or_test(NodeExprOrTest *test) {
     return eval_expr(test->right);
 }
 
-static reference_t eval_builtin(NodeExprBuiltin *builtin) {
-    /* First evaluate the operands to the builtin in order. */
-    reference_t left = eval_expr(builtin->left);
+/*!
+ * Evaluates an expression for its truth value, as the condition of an if or
+ * while statement or the operand of not. Comparisons and the boolean
+ * operators are evaluated straight to a C bool, without ever making a
+ * reference to True or False; other expressions are evaluated as usual and
+ * then coerced. Returns false if an exception occurs, so that and and or
+ * stop there.
+ */
+static bool eval_cond(Node *node) {
+    /* The profiler counts nodes as eval_expr evaluates them, so it takes the
+     * ordinary path. */
+    if (profile_counts == NULL) {
+        switch (node->type) {
+            case EXPR_NOT_TEST: {
+                bool operand = eval_cond(((NodeExprNotTest *) node)->operand);
+                return !operand && !exception_occurred();
+            }
+            case EXPR_AND_TEST: {
+                NodeExprAndTest *test = (NodeExprAndTest *) node;
+                return eval_cond(test->left) && eval_cond(test->right);
+            }
+            case EXPR_OR_TEST: {
+                NodeExprOrTest *test = (NodeExprOrTest *) node;
+                return eval_cond(test->left) ||
+                    (!exception_occurred() && eval_cond(test->right));
+            }
+
+            case EXPR_BUILTIN:
+                if (((NodeExprBuiltin *) node)->builtin_type >= COMP_EQUALS) {
+                    return eval_cond_builtin((NodeExprBuiltin *) node);
+                }
+                break;
+            case EXPR_BUILTIN_INT:
+                if (((NodeExprBuiltin *) node)->builtin_type >= COMP_EQUALS) {
+                    return eval_cond_builtin_int((NodeExprBuiltin *) node);
+                }
+                break;
+            case EXPR_COMPARE_SUBSCRIPTS:
+                return eval_cond_compare_subscripts((NodeExprBuiltin *) node);
+            case EXPR_COMPARE_LEN:
+                return eval_cond_compare_len((NodeExprBuiltin *) node);
+
+            case EXPR_IDENTIFIER: {
+                /* Test the variable's value without taking a reference. */
+                global_variable_t *var = globals_find(((NodeExprIdentifier *) node)->name);
+                if (var != NULL) {
+                    bool cond = ref_bool(var->ref);
+                    return cond && !exception_occurred();
+                }
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+
+    reference_t ref = eval_expr(node);
     if (exception_occurred()) {
-        return NULL_REF;
+        return false;
+    }
+
+    bool cond = ref_bool(ref);
+    decref(ref);
+    return cond && !exception_occurred();
+}
+
+/*!
+ * Evaluates the operands of a builtin operator into *left and *right.
+ * Unary operators use the same value for both. Returns false if an exception
+ * occurred, in which case no references are held.
+ */
+static bool eval_builtin_operands(NodeExprBuiltin *builtin,
+        reference_t *left, reference_t *right) {
+    *left = eval_expr(builtin->left);
+    if (exception_occurred()) {
+        return false;
     }
 
     /* If this builtin is unary then the right operand will be NULL and we just
      * set the right operand to be the same as the left for simplicity. */
-    reference_t right;
     if (builtin->right) {
-        right = eval_expr(builtin->right);
+        *right = eval_expr(builtin->right);
         if (exception_occurred()) {
-            decref(left);
-            return NULL_REF;
+            decref(*left);
+            return false;
         }
     } else {
-        incref(left);
-        right = left;
+        incref(*left);
+        *right = *left;
     }
+    return true;
+}
 
-    /* Then, once we have the operands, we can dispatch to the particular
-     * types being operated on. */
+/*!
+ * Dispatches a comparison operator on already evaluated operands, returning
+ * its result as a C bool. Returns false if an exception occurs.
+ */
+static bool eval_compare_dispatch(NodeExprBuiltin *builtin,
+        reference_t left, reference_t right) {
     NodeExprBuiltinType type = builtin->builtin_type;
-    reference_t result;
+    bool result;
     if (type == COMP_EQUALS) {
-        result = bool_ref(ref_eq(left, right));
+        result = ref_eq_cached(&builtin->cache, left, right);
     } else {
-        result = (type > COMP_EQUALS ? ref_compare : ref_builtin)(type, left, right);
+        /* A three-way comparison compares to 0 like the operands compare. */
+        int comparison = compare_cached(&builtin->cache, left, right);
+        result = comparison != COMPARE_UNORDERED && int_comparison(type, comparison, 0);
     }
+    return result && !exception_occurred();
+}
 
-    decref(left);
-    decref(right);
-    return result;
+/*!
+ * Dispatches a builtin operator on already evaluated operands to the
+ * particular types being operated on. This goes through the node's inline
+ * cache, so an operator that always sees the same type skips the table lookup.
+ */
+static reference_t eval_builtin_dispatch(NodeExprBuiltin *builtin,
+        reference_t left, reference_t right) {
+    NodeExprBuiltinType type = builtin->builtin_type;
+    if (type >= COMP_EQUALS) {
+        return bool_result(eval_compare_dispatch(builtin, left, right));
+    }
+    return ref_builtin_cached(&builtin->cache, type, left, right);
 }
 
-static reference_t eval_subscript(NodeExprSubscript *subscript) {
-    /* First evaluate the subscript target and the subscript itself. */
-    reference_t target = eval_expr(subscript->obj);
-    if (exception_occurred()) {
-        return NULL_REF;
+/*!
+ * Once an operator has seen nothing but integers for a while, quicken it so
+ * that later evaluations skip the generic dispatch.
+ */
+static void eval_builtin_quicken(NodeExprBuiltin *builtin,
+        reference_t left, reference_t right) {
+    if (ref_type(left) == VAL_INTEGER && ref_type(right) == VAL_INTEGER) {
+        if (++builtin->int_streak >= QUICKEN_THRESHOLD) {
+            builtin->type = EXPR_BUILTIN_INT;
+        }
+    } else {
+        builtin->int_streak = 0;
     }
+}
 
-    reference_t index = eval_expr(subscript->index);
-    if (exception_occurred()) {
-        decref(target);
+static reference_t eval_builtin(NodeExprBuiltin *builtin) {
+    /* First evaluate the operands to the builtin in order. */
+    reference_t left, right;
+    if (!eval_builtin_operands(builtin, &left, &right)) {
         return NULL_REF;
     }
+    eval_builtin_quicken(builtin, left, right);
 
-    /* Then dispatch to the object for accessing the subscript value. */
-    reference_t result = ref_subscr_get(target, index);
-    decref(target);
-    decref(index);
-
+    reference_t result = eval_builtin_dispatch(builtin, left, right);
+    decref(left);
+    decref(right);
     return result;
 }
 
-static reference_t eval_literal_list(NodeExprLiteralList *list) {
-    /* First figure out the number of elements. */
-    size_t length = list->values ? ast_nodelist_length(list->values) : 0;
-
-    /* Then allocate space for the references. */
-    reference_t ref_array = make_reference_refarray(length);
-    if (exception_occurred()) {
-        return NULL_REF;
+/*! Evaluates a comparison operator as a condition. See eval_cond. */
+static bool eval_cond_builtin(NodeExprBuiltin *builtin) {
+    reference_t left, right;
+    if (!eval_builtin_operands(builtin, &left, &right)) {
+        return false;
     }
-    ref_array_value_t *val_array = (ref_array_value_t *) deref(ref_array);
+    eval_builtin_quicken(builtin, left, right);
 
-    /* Then create a new list. */
-    reference_t ref_list = make_reference_list();
-    if (exception_occurred()) {
-        decref(ref_array);
-        return NULL_REF;
-    }
-    list_value_t *val_list = (list_value_t *) deref(ref_list);
-    val_list->values = ref_array;
-    val_list->size = length;
+    bool result = eval_compare_dispatch(builtin, left, right);
+    decref(left);
+    decref(right);
+    return result;
+}
 
-    /* Then compute and store the elements. */
-    if (list->values) {
-        size_t idx = 0;
-        for (NodeListEntry *entry = list->values->head; entry; entry = entry->next) {
-            val_array->values[idx++] = eval_expr(entry->node);
-            if (exception_occurred()) {
-                decref(ref_list);
-                return NULL_REF;
+/*!
+ * Applies an arithmetic builtin operator to two unboxed integers. Returns
+ * false if the result would overflow, or for division by zero; the boxed
+ * operators handle those by falling back to bigints or raising an error.
+ */
+static bool int_arithmetic(NodeExprBuiltinType type, int64_t l, int64_t r, int64_t *result) {
+    switch (type) {
+        case UOP_NEGATE:   return !__builtin_sub_overflow(0, l, result);
+        case UOP_IDENTITY: *result = l; return true;
+
+        case OP_ADD:       return !__builtin_add_overflow(l, r, result);
+        case OP_SUBTRACT:  return !__builtin_sub_overflow(l, r, result);
+        case OP_MULTIPLY:  return !__builtin_mul_overflow(l, r, result);
+
+        case OP_DIVIDE:
+        case OP_MODULO:
+            if (r == 0 || r == -1) {
+                return false;
             }
-        }
+            *result = type == OP_DIVIDE ? l / r : l % r;
+            return true;
+
+        default:
+            UNREACHABLE();
     }
+}
 
-    /* If all is well, then we have a new list. */
-    return ref_list;
+/*! Applies a comparison builtin operator to two unboxed integers. */
+static bool int_comparison(NodeExprBuiltinType type, int64_t l, int64_t r) {
+    switch (type) {
+        case COMP_EQUALS:  return l == r;
+        case COMP_LT:      return l < r;
+        case COMP_GT:      return l > r;
+        case COMP_LE:      return l <= r;
+        case COMP_GE:      return l >= r;
+
+        default:
+            UNREACHABLE();
+    }
 }
 
-static reference_t eval_literal_dict(NodeExprLiteralDict *dict) {
-    /* First figure out the number of elements. */
-    size_t length = dict->keys ? ast_nodelist_length(dict->keys) : 0;
+/*!
+ * Boxes the result of applying any builtin operator to two integers. Results
+ * that don't fit in 64 bits go through the generic dispatch instead.
+ */
+static reference_t int_builtin_result(NodeExprBuiltinType type, int64_t l, int64_t r) {
+    if (type >= COMP_EQUALS) {
+        return bool_ref(int_comparison(type, l, r));
+    }
 
-    /* Initial capacity should be twice the number of elements, minimum 16. */
-    size_t capacity = length * 2;
-    if (capacity < 16) {
-        capacity = 16;
+    int64_t result;
+    if (int_arithmetic(type, l, r, &result)) {
+        return make_reference_int(result);
     }
 
-    /* Then allocate space for the key references. */
-    reference_t ref_key_array = make_reference_refarray(capacity);
-    if (exception_occurred()) {
+    reference_t left = make_reference_int(l);
+    if (left == NULL_REF) {
         return NULL_REF;
     }
-
-    /* Then allocate space for the value references. */
-    reference_t ref_value_array = make_reference_refarray(capacity);
-    if (exception_occurred()) {
-        decref(ref_key_array);
+    reference_t right = make_reference_int(r);
+    if (right == NULL_REF) {
+        decref(left);
         return NULL_REF;
     }
 
-    /* Then create a new dict. */
-    reference_t ref_dict = make_reference_dict();
-    if (exception_occurred()) {
-        decref(ref_value_array);
-        decref(ref_key_array);
-        return NULL_REF;
+    reference_t boxed = ref_builtin(type, left, right);
+    decref(left);
+    decref(right);
+    return boxed;
+}
+
+/*!
+ * Evaluates the operands of a builtin operator with eval_unboxed. Unary
+ * operators use the same value for both. Returns false if either operand
+ * can't be evaluated unboxed.
+ */
+static bool eval_unboxed_operands(NodeExprBuiltin *builtin, int64_t *l, int64_t *r) {
+    if (!eval_unboxed(builtin->left, l)) {
+        return false;
     }
-    dict_value_t *val_dict = (dict_value_t *) deref(ref_dict);
-    val_dict->keys = ref_key_array;
-    val_dict->values = ref_value_array;
-    val_dict->size = 0;
-    val_dict->occupied = 0;
+    if (builtin->right == NULL) {
+        *r = *l;
+        return true;
+    }
+    return eval_unboxed(builtin->right, r);
+}
 
-    /* Then compute and store the elements. */
-    if (dict->keys) {
-        NodeListEntry *key_entry = dict->keys->head;
-        NodeListEntry *value_entry = dict->values->head;
+/*!
+ * Evaluates a builtin operator that has been quickened for integers. When
+ * the operands can be evaluated unboxed, only the result is allocated.
+ * Otherwise the operands are evaluated normally, and the arithmetic is still
+ * done inline on their values. If the operands turn out not to be integers,
+ * the node is turned back into a generic EXPR_BUILTIN.
+ */
+static reference_t eval_builtin_int(NodeExprBuiltin *builtin) {
+    int64_t l, r;
+    if (eval_unboxed_operands(builtin, &l, &r)) {
+        return int_builtin_result(builtin->builtin_type, l, r);
+    }
 
-        while (key_entry && value_entry) {
-            reference_t key = eval_expr(key_entry->node);
-            if (!exception_occurred()) {
-                reference_t value = eval_expr(value_entry->node);
-                if (!exception_occurred()) {
-                    dict_subscr_set((value_t *) val_dict, key, value);
-                    decref(value);
-                }
-                decref(key);
-            }
+    reference_t left, right;
+    if (!eval_builtin_operands(builtin, &left, &right)) {
+        return NULL_REF;
+    }
 
-            if (exception_occurred()) {
-                decref(ref_dict);
-                return NULL_REF;
-            }
+    value_t *lobj = deref(left);
+    value_t *robj = deref(right);
+    if (lobj->type != VAL_INTEGER || robj->type != VAL_INTEGER) {
+        builtin->type = EXPR_BUILTIN;
+        builtin->int_streak = 0;
 
-            key_entry = key_entry->next;
-            value_entry = value_entry->next;
-        }
+        reference_t result = eval_builtin_dispatch(builtin, left, right);
+        decref(left);
+        decref(right);
+        return result;
     }
 
-    return ref_dict;
+    l = ((integer_value_t *) lobj)->integer_value;
+    r = ((integer_value_t *) robj)->integer_value;
+    decref(left);
+    decref(right);
+    return int_builtin_result(builtin->builtin_type, l, r);
 }
 
-static reference_t eval_call_exit(size_t arity, reference_t *args) {
-    if (arity > 1) {
-        exception_set_format(EXC_TYPE_ERROR,
-                "exit() takes from 0 to 1 positional arguments but %d were given", arity);
-        return NULL_REF;
+/*!
+ * Evaluates a comparison operator that has been quickened for integers as a
+ * condition, like eval_builtin_int but without boxing the result.
+ */
+static bool eval_cond_builtin_int(NodeExprBuiltin *builtin) {
+    int64_t l, r;
+    if (eval_unboxed_operands(builtin, &l, &r)) {
+        return int_comparison(builtin->builtin_type, l, r);
     }
 
-    int code = 0;
-    if (arity == 1) {
-        reference_t code_reference = args[0];
-        value_t *code_value = deref(code_reference);
+    reference_t left, right;
+    if (!eval_builtin_operands(builtin, &left, &right)) {
+        return false;
+    }
 
-        if (code_value->type == VAL_INTEGER) {
-            code = ((integer_value_t *) code_value)->integer_value;
-        } else {
+    value_t *lobj = deref(left);
+    value_t *robj = deref(right);
+    bool result;
+    if (lobj->type != VAL_INTEGER || robj->type != VAL_INTEGER) {
+        builtin->type = EXPR_BUILTIN;
+        builtin->int_streak = 0;
+        result = eval_compare_dispatch(builtin, left, right);
+    } else {
+        result = int_comparison(builtin->builtin_type,
+                ((integer_value_t *) lobj)->integer_value,
+                ((integer_value_t *) robj)->integer_value);
+    }
+
+    decref(left);
+    decref(right);
+    return result;
+}
+
+/*!
+ * Tries to compute the value of an integer expression without allocating or
+ * taking any references. This handles integer literals, variables holding
+ * integers, `len(x)` of a variable, and quickened arithmetic on any of
+ * those. None of these have side effects, so if this returns false the
+ * caller can simply evaluate the expression normally instead.
+ */
+static bool eval_unboxed(Node *node, int64_t *result) {
+    switch (node->type) {
+        case EXPR_LITERAL_INTEGER:
+            *result = ((NodeExprLiteralInteger *) node)->value;
+            return true;
+
+        case EXPR_IDENTIFIER: {
+            /* Read the variable's value without incrementing its count. */
+            global_variable_t *var = globals_find(((NodeExprIdentifier *) node)->name);
+            if (var == NULL) {
+                return false;
+            }
+
+            value_t *obj = deref(var->ref);
+            if (obj->type != VAL_INTEGER) {
+                return false;
+            }
+            *result = ((integer_value_t *) obj)->integer_value;
+            return true;
+        }
+
+        case EXPR_CALL: {
+            NodeExprCall *call = (NodeExprCall *) node;
+            if (call->func->type != EXPR_IDENTIFIER ||
+                    strcmp(((NodeExprIdentifier *) call->func)->name, "len") != 0 ||
+                    call->args == NULL || ast_nodelist_length(call->args) != 1 ||
+                    call->args->head->node->type != EXPR_IDENTIFIER) {
+                return false;
+            }
+
+            global_variable_t *var = globals_find(
+                    ((NodeExprIdentifier *) call->args->head->node)->name);
+            if (var == NULL) {
+                return false;
+            }
+
+            /* Leave unsized values to eval_call_len to report. */
+            *result = ref_len(var->ref);
+            if (exception_occurred()) {
+                exception_clear();
+                return false;
+            }
+            return true;
+        }
+
+        case EXPR_BUILTIN_INT: {
+            NodeExprBuiltin *builtin = (NodeExprBuiltin *) node;
+            int64_t l, r;
+            return builtin->builtin_type < COMP_EQUALS &&
+                eval_unboxed_operands(builtin, &l, &r) &&
+                int_arithmetic(builtin->builtin_type, l, r, result);
+        }
+
+        default:
+            return false;
+    }
+}
+
+/*!
+ * Evaluates one side of EXPR_COMPARE_SUBSCRIPTS. The container is stored in
+ * *target, and the element is returned. List elements are borrowed from the
+ * container, so no reference is taken; other containers go through the
+ * regular subscript lookup, and *owned is set. Returns NULL_REF with nothing
+ * held if an exception occurs.
+ */
+static reference_t eval_subscript_operand(NodeExprSubscript *subscript,
+        reference_t *target, bool *owned) {
+    *target = eval_expr(subscript->obj);
+    if (exception_occurred()) {
+        return NULL_REF;
+    }
+
+    reference_t index = eval_expr(subscript->index);
+    if (exception_occurred()) {
+        decref(*target);
+        return NULL_REF;
+    }
+
+    value_t *obj = deref(*target);
+    reference_t result;
+    if (obj->type == VAL_LIST) {
+        *owned = false;
+        result = list_subscr_peek(obj, index);
+    } else {
+        *owned = true;
+        result = ref_subscr_get_cached(&subscript->cache, *target, index);
+    }
+    decref(index);
+
+    if (exception_occurred()) {
+        decref(*target);
+        return NULL_REF;
+    }
+    return result;
+}
+
+/*!
+ * Evaluates a comparison between two subscripts, such as `a[i] < a[j]`.
+ * When the containers are lists, the elements are compared without taking
+ * references to them.
+ */
+static reference_t eval_compare_subscripts(NodeExprBuiltin *builtin) {
+    return bool_result(eval_cond_compare_subscripts(builtin));
+}
+
+/*! Evaluates a comparison between two subscripts as a condition. */
+static bool eval_cond_compare_subscripts(NodeExprBuiltin *builtin) {
+    reference_t ltarget, rtarget;
+    bool lowned, rowned;
+
+    reference_t left = eval_subscript_operand(
+            (NodeExprSubscript *) builtin->left, &ltarget, &lowned);
+    if (exception_occurred()) {
+        return false;
+    }
+
+    reference_t right = eval_subscript_operand(
+            (NodeExprSubscript *) builtin->right, &rtarget, &rowned);
+    if (exception_occurred()) {
+        if (lowned) {
+            decref(left);
+        }
+        decref(ltarget);
+        return false;
+    }
+
+    bool result = eval_compare_dispatch(builtin, left, right);
+
+    if (lowned) {
+        decref(left);
+    }
+    if (rowned) {
+        decref(right);
+    }
+    decref(ltarget);
+    decref(rtarget);
+    return result;
+}
+
+/*!
+ * Evaluates a comparison against the length of a value, such as
+ * `i < len(a)`. If the left operand is an integer, the length is compared
+ * directly instead of being boxed.
+ */
+static reference_t eval_compare_len(NodeExprBuiltin *builtin) {
+    return bool_result(eval_cond_compare_len(builtin));
+}
+
+/*! Evaluates a comparison against the length of a value as a condition. */
+static bool eval_cond_compare_len(NodeExprBuiltin *builtin) {
+    int64_t l, length;
+    if (eval_unboxed(builtin->left, &l) && eval_unboxed(builtin->right, &length)) {
+        return int_comparison(builtin->builtin_type, l, length);
+    }
+
+    reference_t left = eval_expr(builtin->left);
+    if (exception_occurred()) {
+        return false;
+    }
+
+    NodeExprCall *call = (NodeExprCall *) builtin->right;
+    reference_t arg = eval_expr(call->args->head->node);
+    if (exception_occurred()) {
+        decref(left);
+        return false;
+    }
+
+    length = ref_len(arg);
+    decref(arg);
+    if (exception_occurred()) {
+        decref(left);
+        return false;
+    }
+
+    value_t *lobj = deref(left);
+    if (lobj->type != VAL_INTEGER) {
+        reference_t right = make_reference_int(length);
+        if (exception_occurred()) {
+            decref(left);
+            return false;
+        }
+
+        bool result = eval_compare_dispatch(builtin, left, right);
+        decref(left);
+        decref(right);
+        return result;
+    }
+
+    l = ((integer_value_t *) lobj)->integer_value;
+    decref(left);
+    return int_comparison(builtin->builtin_type, l, length);
+}
+
+static reference_t eval_subscript(NodeExprSubscript *subscript) {
+    /* First evaluate the subscript target. */
+    reference_t target = eval_expr(subscript->obj);
+    if (exception_occurred()) {
+        return NULL_REF;
+    }
+
+    /* Reading a record field by a literal name is just an indexed load once
+     * the slot has been resolved for the record's shape. */
+    int64_t slot = record_literal_slot(subscript, deref(target));
+    if (slot >= 0) {
+        reference_t result = record_get_slot(deref(target), slot);
+        decref(target);
+        return result;
+    }
+
+    reference_t index = eval_expr(subscript->index);
+    if (exception_occurred()) {
+        decref(target);
+        return NULL_REF;
+    }
+
+    /* Then dispatch to the object for accessing the subscript value. */
+    reference_t result = ref_subscr_get_cached(&subscript->cache, target, index);
+    decref(target);
+    decref(index);
+
+    return result;
+}
+
+static reference_t eval_literal_list(NodeExprLiteralList *list) {
+    /* First figure out the number of elements. */
+    size_t length = list->values ? ast_nodelist_length(list->values) : 0;
+
+    /* Then allocate space for the references. */
+    reference_t ref_array = make_reference_refarray(length);
+    if (exception_occurred()) {
+        return NULL_REF;
+    }
+    ref_array_value_t *val_array = (ref_array_value_t *) deref(ref_array);
+
+    /* Then create a new list. */
+    reference_t ref_list = make_reference_list();
+    if (exception_occurred()) {
+        decref(ref_array);
+        return NULL_REF;
+    }
+    list_value_t *val_list = (list_value_t *) deref(ref_list);
+    val_list->values = ref_array;
+    val_list->size = length;
+
+    /* Then compute and store the elements. */
+    if (list->values) {
+        size_t idx = 0;
+        for (NodeListEntry *entry = list->values->head; entry; entry = entry->next) {
+            val_array->values[idx++] = eval_expr(entry->node);
+            if (exception_occurred()) {
+                decref(ref_list);
+                return NULL_REF;
+            }
+        }
+    }
+
+    /* If all is well, then we have a new list. */
+    return ref_list;
+}
+
+static reference_t eval_literal_dict(NodeExprLiteralDict *dict) {
+    /* First figure out the number of elements. */
+    size_t length = dict->keys ? ast_nodelist_length(dict->keys) : 0;
+
+    /* Then create a new dict. */
+    reference_t ref_dict = make_reference_dict();
+    if (exception_occurred()) {
+        return NULL_REF;
+    }
+
+    /* A literal whose keys are distinct string literals produces the same
+     * shape every time, so its values can be stored directly in slot order. */
+    shape_t *shape = length <= DICT_MAX_SHAPED_KEYS ? literal_dict_shape(dict) : NULL;
+    if (exception_occurred()) {
+        decref(ref_dict);
+        return NULL_REF;
+    }
+    if (shape != NULL) {
+        if (!dict_init_shaped(deref(ref_dict), shape, length)) {
+            decref(ref_dict);
+            return NULL_REF;
+        }
+
+        size_t slot = 0;
+        for (NodeListEntry *entry = dict->values ? dict->values->head : NULL;
+                entry; entry = entry->next) {
+            reference_t value = eval_expr(entry->node);
+            if (exception_occurred()) {
+                decref(ref_dict);
+                return NULL_REF;
+            }
+
+            dict_value_t *val_dict = (dict_value_t *) deref(ref_dict);
+            ((ref_array_value_t *) deref(val_dict->values))->values[slot++] = value;
+        }
+        return ref_dict;
+    }
+
+    /* If the literal is sure to need a hash table, evaluate all the pairs
+     * first and then build the table in bulk, sized for every element. */
+    bool hashed = length > DICT_MAX_SHAPED_KEYS;
+    for (NodeListEntry *entry = dict->keys ? dict->keys->head : NULL;
+            entry && !hashed; entry = entry->next) {
+        NodeType key_type = entry->node->type;
+        hashed = key_type == EXPR_LITERAL_INTEGER || key_type == EXPR_LITERAL_SINGLETON;
+    }
+    if (hashed) {
+        return eval_literal_dict_hashed(dict, ref_dict, length);
+    }
+
+    /* Otherwise compute and store the elements one at a time. */
+    if (dict->keys) {
+        NodeListEntry *key_entry = dict->keys->head;
+        NodeListEntry *value_entry = dict->values->head;
+
+        while (key_entry && value_entry) {
+            reference_t key = eval_expr(key_entry->node);
+            if (!exception_occurred()) {
+                reference_t value = eval_expr(value_entry->node);
+                if (!exception_occurred()) {
+                    dict_subscr_set(deref(ref_dict), key, value);
+                    decref(value);
+                }
+                decref(key);
+            }
+
+            if (exception_occurred()) {
+                decref(ref_dict);
+                return NULL_REF;
+            }
+
+            key_entry = key_entry->next;
+            value_entry = value_entry->next;
+        }
+    }
+
+    return ref_dict;
+}
+
+/*!
+ * Evaluates the pairs of a dict literal in order, then stores them all into
+ * a hash table sized for them with dict_build_hashed. Consumes ref_dict, and
+ * returns it on success or NULL_REF on error.
+ */
+static reference_t eval_literal_dict_hashed(NodeExprLiteralDict *dict,
+        reference_t ref_dict, size_t length) {
+    if (!dict_init_hashed(deref(ref_dict), length)) {
+        decref(ref_dict);
+        return NULL_REF;
+    }
+
+    /* Allocate space for the pairs (hopefully on the stack). */
+    reference_t keys[length];
+    reference_t values[length];
+    size_t evaluated = 0;
+
+    NodeListEntry *key_entry = dict->keys->head;
+    NodeListEntry *value_entry = dict->values->head;
+    for (; evaluated < length; evaluated++) {
+        keys[evaluated] = eval_expr(key_entry->node);
+        if (exception_occurred()) {
+            break;
+        }
+        values[evaluated] = eval_expr(value_entry->node);
+        if (exception_occurred()) {
+            decref(keys[evaluated]);
+            break;
+        }
+
+        key_entry = key_entry->next;
+        value_entry = value_entry->next;
+    }
+
+    if (!exception_occurred()) {
+        dict_build_hashed(deref(ref_dict), keys, values, length);
+    }
+
+    for (size_t i = 0; i < evaluated; i++) {
+        decref(keys[i]);
+        decref(values[i]);
+    }
+
+    if (exception_occurred()) {
+        decref(ref_dict);
+        return NULL_REF;
+    }
+    return ref_dict;
+}
+
+/*!
+ * If a subscript node indexes a record by a string literal, returns the slot
+ * the literal names in that record. The slot is cached on the node for the
+ * record's shape, so repeated accesses don't need to look the name up again.
+ * Returns -1 if the fast path doesn't apply.
+ */
+static int64_t record_literal_slot(NodeExprSubscript *subscript, value_t *obj) {
+    if (obj->type != VAL_RECORD || subscript->index->type != EXPR_LITERAL_STRING) {
+        return -1;
+    }
+
+    shape_t *shape = ((record_value_t *) obj)->shape;
+    if (subscript->cache_shape != shape) {
+        subscript->cache_shape = shape;
+        subscript->cache_slot = shape_find(shape,
+                ((NodeExprLiteralString *) subscript->index)->value);
+    }
+    return subscript->cache_slot;
+}
+
+/*!
+ * Returns the shape of a dict literal whose keys are all distinct string
+ * literals, caching it on the node. This is shared by dicts and records
+ * built from the literal. Returns NULL if the keys aren't all literals, the
+ * shapes they lead through have no room for more transitions, or an
+ * exception occurs. All but the last are remembered on the node too.
+ */
+static shape_t *literal_dict_shape(NodeExprLiteralDict *dict) {
+    if (dict->shape != NULL || dict->unshapeable) {
+        return dict->shape;
+    }
+
+    shape_t *shape = shape_root();
+    for (NodeListEntry *entry = dict->keys ? dict->keys->head : NULL;
+            entry && shape != NULL; entry = entry->next) {
+        if (entry->node->type != EXPR_LITERAL_STRING) {
+            shape = NULL;
+            break;
+        }
+
+        const char *name = ((NodeExprLiteralString *) entry->node)->value;
+        shape = shape_find(shape, name) >= 0 ? NULL : dict_shape_add_key(shape, name);
+        if (exception_occurred()) {
+            return NULL;
+        }
+    }
+
+    dict->shape = shape;
+    dict->unshapeable = shape == NULL;
+    return shape;
+}
+
+/*!
+ * Evaluates a dict literal directly into a record, without building the
+ * dict first. The record is the only allocation made.
+ */
+static reference_t eval_literal_record(NodeExprLiteralDict *dict) {
+    size_t length = dict->keys ? ast_nodelist_length(dict->keys) : 0;
+
+    /* When the keys are all distinct literals, entry i is stored in slot i
+     * and the shape doesn't have to be recomputed. */
+    shape_t *shape = literal_dict_shape(dict);
+    if (exception_occurred()) {
+        return NULL_REF;
+    }
+    if (shape != NULL) {
+        reference_t ref_record = make_reference_record(shape);
+        if (exception_occurred()) {
+            return NULL_REF;
+        }
+
+        size_t slot = 0;
+        for (NodeListEntry *entry = dict->values ? dict->values->head : NULL;
+                entry; entry = entry->next) {
+            reference_t value = eval_expr(entry->node);
+            if (exception_occurred()) {
+                decref(ref_record);
+                return NULL_REF;
+            }
+            ((record_value_t *) deref(ref_record))->values[slot++] = value;
+        }
+        return ref_record;
+    }
+
+    /* Otherwise, evaluate all of the keys and values and then work out which
+     * slot each entry belongs in. Later entries override earlier ones. */
+    reference_t keys[length], values[length];
+    size_t slots[length];
+    size_t evaluated = 0;
+    shape = shape_root();
+
+    NodeListEntry *key_entry = dict->keys->head;
+    NodeListEntry *value_entry = dict->values->head;
+    for (; key_entry && value_entry; key_entry = key_entry->next,
+            value_entry = value_entry->next) {
+        keys[evaluated] = eval_expr(key_entry->node);
+        if (exception_occurred()) {
+            break;
+        }
+        values[evaluated] = eval_expr(value_entry->node);
+        if (exception_occurred()) {
+            decref(keys[evaluated]);
+            break;
+        }
+        evaluated++;
+
+        value_t *key = deref(keys[evaluated - 1]);
+        if (key->type != VAL_STRING) {
+            exception_set(EXC_TYPE_ERROR, "record field names must be strings");
+            break;
+        }
+
+        const char *name = ((string_value_t *) key)->string_value;
+        int64_t slot = shape_find(shape, name);
+        if (slot < 0) {
+            shape = shape_add_key(shape, name);
+            if (shape == NULL) {
+                break;
+            }
+            slot = shape->num_keys - 1;
+        }
+        slots[evaluated - 1] = slot;
+    }
+
+    reference_t ref_record = NULL_REF;
+    if (!exception_occurred()) {
+        ref_record = make_reference_record(shape);
+    }
+    if (!exception_occurred()) {
+        record_value_t *record = (record_value_t *) deref(ref_record);
+        for (size_t i = 0; i < evaluated; i++) {
+            decref(record->values[slots[i]]);
+            incref(values[i]);
+            record->values[slots[i]] = values[i];
+        }
+    }
+
+    for (size_t i = 0; i < evaluated; i++) {
+        decref(keys[i]);
+        decref(values[i]);
+    }
+    return ref_record;
+}
+
+static reference_t eval_call_record(NodeExprCall *node) {
+    size_t arity = node->args ? ast_nodelist_length(node->args) : 0;
+    if (arity != 1) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "record() takes 1 positional argument but %zu were given", arity);
+        return NULL_REF;
+    }
+
+    /* The common case of record({...}) doesn't need the dict at all. */
+    Node *arg = node->args->head->node;
+    if (arg->type == EXPR_LITERAL_DICT) {
+        return eval_literal_record((NodeExprLiteralDict *) arg);
+    }
+
+    reference_t dict = eval_expr(arg);
+    if (exception_occurred()) {
+        return NULL_REF;
+    }
+
+    reference_t result = NULL_REF;
+    if (ref_type(dict) == VAL_DICT) {
+        result = dict_to_record(deref(dict));
+    } else {
+        exception_set_format(EXC_TYPE_ERROR,
+                "record() argument must be a dict, not '%s'",
+                type_to_str(ref_type(dict)));
+    }
+
+    decref(dict);
+    return result;
+}
+
+static reference_t eval_call_exit(size_t arity, reference_t *args) {
+    if (arity > 1) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "exit() takes from 0 to 1 positional arguments but %zu were given", arity);
+        return NULL_REF;
+    }
+
+    int code = 0;
+    if (arity == 1) {
+        reference_t code_reference = args[0];
+        value_t *code_value = deref(code_reference);
+
+        if (code_value->type == VAL_INTEGER) {
+            code = ((integer_value_t *) code_value)->integer_value;
+        } else {
             ref_println(code_reference, stderr, MAX_DEPTH);
             code = 1;
         }
     }
 
-    // TODO: Try to cleanup Subpython memory before exiting.
-    exit(code);
+    // TODO: Try to cleanup Subpython memory before exiting.
+    exit(code);
+}
+
+static reference_t eval_call_mem(size_t arity, reference_t *args) {
+    (void) args;
+
+    if (arity > 0) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "mem() takes 0 positional arguments but %zu were given", arity);
+        return NULL_REF;
+    }
+
+    printf("%zu bytes in use; %zu refs in use\n", mem_used(), refs_used());
+
+    incref(NONE_REF);
+    return NONE_REF;
+}
+
+static reference_t eval_call_gc(size_t arity, reference_t *args) {
+    (void) args;
+
+    if (arity > 0) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "gc() takes 0 positional arguments but %zu were given", arity);
+        return NULL_REF;
+    }
+
+    collect_garbage();
+
+    incref(NONE_REF);
+    return NONE_REF;
+}
+
+static reference_t eval_call_print(size_t arity, reference_t *args) {
+    if (arity > 0) {
+        ref_print(args[0], stdout, MAX_DEPTH);
+        for (size_t i = 1; i < arity; i++) {
+            putc(' ', stdout);
+            ref_print(args[i], stdout, MAX_DEPTH);
+        }
+    }
+
+    putc('\n', stdout);
+
+    incref(NONE_REF);
+    return NONE_REF;
+}
+
+static reference_t eval_call_len(size_t arity, reference_t *args) {
+    if (arity != 1) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "len() takes 1 positional argument but %zu were given", arity);
+        return NULL_REF;
+    }
+
+    return make_reference_int(ref_len(args[0]));
+}
+
+static reference_t eval_call_bool(size_t arity, reference_t *args) {
+    if (arity != 1) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "bool() takes 1 positional argument but %zu were given", arity);
+        return NULL_REF;
+    }
+
+    return bool_ref(ref_bool(args[0]));
+}
+
+static reference_t eval_call_str(size_t arity, reference_t *args) {
+    if (arity != 1) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "str() takes 1 positional argument but %zu were given", arity);
+        return NULL_REF;
+    }
+
+    return ref_str(args[0]);
+}
+
+static reference_t eval_call_repr(size_t arity, reference_t *args) {
+    if (arity != 1) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "repr() takes 1 positional argument but %zu were given", arity);
+        return NULL_REF;
+    }
+
+    return ref_repr(args[0]);
+}
+
+static reference_t eval_call_contains(size_t arity, reference_t *args) {
+    if (arity != 2) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "contains() takes 2 positional arguments but %zu were given", arity);
+        return NULL_REF;
+    }
+
+    bool result = ref_contains(args[0], args[1]);
+    if (exception_occurred()) {
+        return NULL_REF;
+    }
+    return bool_ref(result);
+}
+
+/*!
+ * Implements get(d, k, default), which looks up a key in a dict or persistent
+ * map, returning default (or None) instead of raising a KeyError if it is
+ * missing.
+ */
+static reference_t eval_call_get(size_t arity, reference_t *args) {
+    if (arity < 2 || arity > 3) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "get() takes from 2 to 3 positional arguments but %zu were given", arity);
+        return NULL_REF;
+    }
+
+    value_t *obj = deref(args[0]);
+    if (obj->type != VAL_DICT && obj->type != VAL_PMAP) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "get() argument must be a dict, not '%s'", type_to_str(obj->type));
+        return NULL_REF;
+    }
+
+    reference_t value = obj->type == VAL_DICT ?
+        dict_subscr_peek(obj, args[1]) : pmap_peek(obj, args[1]);
+    if (exception_occurred()) {
+        return NULL_REF;
+    }
+    if (value == NULL_REF) {
+        value = arity == 3 ? args[2] : NONE_REF;
+    }
+
+    incref(value);
+    return value;
+}
+
+/*!
+ * Implements dict(n), which makes an empty dict. A size hint n, for dicts
+ * that are about to be filled in a loop, presizes a hash table for n keys
+ * if that many can't be kept in the shaped representation anyway.
+ */
+static reference_t eval_call_dict(size_t arity, reference_t *args) {
+    if (arity > 1) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "dict() takes from 0 to 1 positional arguments but %zu were given", arity);
+        return NULL_REF;
+    }
+
+    int64_t size = 0;
+    if (arity == 1) {
+        value_t *obj = deref(args[0]);
+        if (obj->type != VAL_INTEGER) {
+            exception_set_format(EXC_TYPE_ERROR,
+                    "dict() argument must be an int, not '%s'", type_to_str(obj->type));
+            return NULL_REF;
+        }
+        size = ((integer_value_t *) obj)->integer_value;
+        if (size < 0) {
+            exception_set(EXC_VALUE_ERROR, "dict() size must not be negative");
+            return NULL_REF;
+        }
+    }
+
+    /* No dict can hold more keys than there are references, so larger hints
+     * would only overflow the sizing arithmetic. */
+    if (size > INT32_MAX) {
+        size = INT32_MAX;
+    }
+
+    reference_t ref_dict = make_reference_dict();
+    if (ref_dict == NULL_REF) {
+        return NULL_REF;
+    }
+    if (size > DICT_MAX_SHAPED_KEYS && !dict_init_hashed(deref(ref_dict), size)) {
+        decref(ref_dict);
+        return NULL_REF;
+    }
+    return ref_dict;
+}
+
+/*!
+ * Implements copy(x), which makes a shallow copy of a list or dict. The copy
+ * shares the original's storage until one of them is modified.
+ */
+static reference_t eval_call_copy(size_t arity, reference_t *args) {
+    if (arity != 1) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "copy() takes 1 positional argument but %zu were given", arity);
+        return NULL_REF;
+    }
+
+    value_t *obj = deref(args[0]);
+    if (obj->type == VAL_LIST) {
+        return list_copy(obj);
+    } else if (obj->type == VAL_DICT) {
+        return dict_copy(obj);
+    }
+
+    exception_set_format(EXC_TYPE_ERROR,
+            "copy() argument must be a list or dict, not '%s'", type_to_str(obj->type));
+    return NULL_REF;
 }
 
-static reference_t eval_call_mem(size_t arity, reference_t *args) {
-    (void) args;
+/*!
+ * Implements set() and set(l), which makes a set of the elements of list l.
+ * The table is sized for the whole list before any element is added.
+ */
+static reference_t eval_call_set(size_t arity, reference_t *args) {
+    if (arity > 1) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "set() takes from 0 to 1 positional arguments but %zu were given", arity);
+        return NULL_REF;
+    }
 
-    if (arity > 0) {
+    list_value_t *list = NULL;
+    if (arity == 1) {
+        value_t *obj = deref(args[0]);
+        if (obj->type != VAL_LIST) {
+            exception_set_format(EXC_TYPE_ERROR,
+                    "set() argument must be a list, not '%s'", type_to_str(obj->type));
+            return NULL_REF;
+        }
+        list = (list_value_t *) obj;
+    }
+
+    reference_t ref_set = make_reference_set();
+    if (ref_set == NULL_REF || list == NULL || list->size == 0) {
+        return ref_set;
+    }
+
+    value_t *set = deref(ref_set);
+    if (!set_reserve(set, list->size)) {
+        decref(ref_set);
+        return NULL_REF;
+    }
+
+    ref_array_value_t *elements = (ref_array_value_t *) deref(list->values);
+    for (int64_t idx = 0; idx < list->size; idx++) {
+        set_add(set, elements->values[idx]);
+        if (exception_occurred()) {
+            decref(ref_set);
+            return NULL_REF;
+        }
+    }
+    return ref_set;
+}
+
+/*!
+ * Checks that the arguments to a set builtin are a set followed by arity - 1
+ * other values, and that the rest are sets too if all_sets is true. Sets an
+ * exception and returns false otherwise.
+ */
+static bool check_set_args(const char *func, size_t arity, reference_t *args,
+        size_t expected, bool all_sets) {
+    if (arity != expected) {
         exception_set_format(EXC_TYPE_ERROR,
-                "mem() takes 0 positional arguments but %d were given", arity);
+                "%s() takes %zu positional arguments but %zu were given",
+                func, expected, arity);
+        return false;
+    }
+
+    for (size_t i = 0; i < (all_sets ? arity : 1); i++) {
+        value_t *obj = deref(args[i]);
+        if (obj->type != VAL_SET) {
+            exception_set_format(EXC_TYPE_ERROR,
+                    "%s() argument must be a set, not '%s'", func, type_to_str(obj->type));
+            return false;
+        }
+    }
+    return true;
+}
+
+/*! Implements add(s, x), which adds x to set s. */
+static reference_t eval_call_add(size_t arity, reference_t *args) {
+    if (!check_set_args("add", arity, args, 2, false)) {
         return NULL_REF;
     }
 
-    printf("%zu bytes in use; %zu refs in use\n", mem_used(), refs_used());
+    set_add(deref(args[0]), args[1]);
+    if (exception_occurred()) {
+        return NULL_REF;
+    }
 
     incref(NONE_REF);
     return NONE_REF;
 }
 
-static reference_t eval_call_gc(size_t arity, reference_t *args) {
+/*! Implements remove(s, x), which removes x from set s. */
+static reference_t eval_call_remove(size_t arity, reference_t *args) {
+    if (!check_set_args("remove", arity, args, 2, false)) {
+        return NULL_REF;
+    }
+
+    set_remove(deref(args[0]), args[1]);
+    if (exception_occurred()) {
+        return NULL_REF;
+    }
+
+    incref(NONE_REF);
+    return NONE_REF;
+}
+
+static reference_t eval_call_union(size_t arity, reference_t *args) {
+    if (!check_set_args("union", arity, args, 2, true)) {
+        return NULL_REF;
+    }
+    return set_union(deref(args[0]), deref(args[1]));
+}
+
+static reference_t eval_call_intersection(size_t arity, reference_t *args) {
+    if (!check_set_args("intersection", arity, args, 2, true)) {
+        return NULL_REF;
+    }
+    return set_intersection(deref(args[0]), deref(args[1]));
+}
+
+/*!
+ * Implements tuple(a, b, ...), which packs its arguments into a tuple. This
+ * stands in for the (a, b, ...) syntax, which the grammar doesn't have.
+ */
+static reference_t eval_call_tuple(size_t arity, reference_t *args) {
+    return tuple_pack(args, arity);
+}
+
+/*!
+ * Implements vector() and vector(l), which makes a persistent vector of the
+ * elements of list l.
+ */
+static reference_t eval_call_vector(size_t arity, reference_t *args) {
+    if (arity > 1) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "vector() takes from 0 to 1 positional arguments but %zu were given", arity);
+        return NULL_REF;
+    }
+
+    list_value_t *list = NULL;
+    if (arity == 1) {
+        value_t *obj = deref(args[0]);
+        if (obj->type != VAL_LIST) {
+            exception_set_format(EXC_TYPE_ERROR,
+                    "vector() argument must be a list, not '%s'", type_to_str(obj->type));
+            return NULL_REF;
+        }
+        list = (list_value_t *) obj;
+    }
+
+    reference_t ref_vector = make_reference_vector();
+    if (ref_vector == NULL_REF || list == NULL || list->size == 0) {
+        return ref_vector;
+    }
+
+    ref_array_value_t *elements = (ref_array_value_t *) deref(list->values);
+    if (!vector_build(deref(ref_vector), elements->values, list->size)) {
+        decref(ref_vector);
+        return NULL_REF;
+    }
+    return ref_vector;
+}
+
+/*! Implements pmap(), which makes an empty persistent map. */
+static reference_t eval_call_pmap(size_t arity, reference_t *args) {
     (void) args;
+    if (arity != 0) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "pmap() takes 0 positional arguments but %zu were given", arity);
+        return NULL_REF;
+    }
+    return make_reference_pmap();
+}
 
-    if (arity > 0) {
+/*!
+ * Checks that the first argument to a persistent collection builtin has one
+ * of the given types. Sets an exception and returns false otherwise.
+ */
+static bool check_persistent_arg(const char *func, reference_t arg, bool vector, bool pmap) {
+    value_type_t type = deref(arg)->type;
+    if ((vector && type == VAL_VECTOR) || (pmap && type == VAL_PMAP)) {
+        return true;
+    }
+
+    exception_set_format(EXC_TYPE_ERROR, "%s() argument must be a %s, not '%s'",
+            func, vector && pmap ? "vector or pmap" : vector ? "vector" : "pmap",
+            type_to_str(type));
+    return false;
+}
+
+/*! Implements push(v, x), which returns v with x appended. */
+static reference_t eval_call_push(size_t arity, reference_t *args) {
+    if (arity != 2) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "push() takes 2 positional arguments but %zu were given", arity);
+        return NULL_REF;
+    }
+    if (!check_persistent_arg("push", args[0], true, false)) {
+        return NULL_REF;
+    }
+    return vector_push(deref(args[0]), args[1]);
+}
+
+/*! Implements pop(v), which returns v without its last element. */
+static reference_t eval_call_pop(size_t arity, reference_t *args) {
+    if (arity != 1) {
         exception_set_format(EXC_TYPE_ERROR,
-                "gc() takes 0 positional arguments but %d were given", arity);
+                "pop() takes 1 positional argument but %zu were given", arity);
+        return NULL_REF;
+    }
+    if (!check_persistent_arg("pop", args[0], true, false)) {
         return NULL_REF;
     }
+    return vector_pop(deref(args[0]));
+}
 
-    collect_garbage();
+/*!
+ * Implements assoc(c, k, x), which returns vector or map c with the element
+ * at index or key k set to x.
+ */
+static reference_t eval_call_assoc(size_t arity, reference_t *args) {
+    if (arity != 3) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "assoc() takes 3 positional arguments but %zu were given", arity);
+        return NULL_REF;
+    }
+    if (!check_persistent_arg("assoc", args[0], true, true)) {
+        return NULL_REF;
+    }
 
-    incref(NONE_REF);
-    return NONE_REF;
+    value_t *obj = deref(args[0]);
+    if (obj->type == VAL_VECTOR) {
+        return vector_assoc(obj, args[1], args[2]);
+    }
+    return pmap_assoc(obj, args[1], args[2]);
 }
 
-static reference_t eval_call_print(size_t arity, reference_t *args) {
-    if (arity > 0) {
-        ref_print(args[0], stdout, MAX_DEPTH);
-        for (size_t i = 1; i < arity; i++) {
-            fprintf(stdout, " ");
-            ref_print(args[i], stdout, MAX_DEPTH);
+/*! Implements dissoc(m, k), which returns map m without key k. */
+static reference_t eval_call_dissoc(size_t arity, reference_t *args) {
+    if (arity != 2) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "dissoc() takes 2 positional arguments but %zu were given", arity);
+        return NULL_REF;
+    }
+    if (!check_persistent_arg("dissoc", args[0], false, true)) {
+        return NULL_REF;
+    }
+    return pmap_dissoc(deref(args[0]), args[1]);
+}
+
+/*!
+ * Implements bytes(x) and bytearray(x), which make a value of the given type
+ * from x, or an empty one if x is missing. See bytes_from for what x may be.
+ */
+static reference_t eval_call_bytes(value_type_t type, size_t arity, reference_t *args) {
+    if (arity > 1) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "%s() takes from 0 to 1 positional arguments but %zu were given",
+                type_to_str(type), arity);
+        return NULL_REF;
+    }
+
+    if (arity == 0) {
+        return make_reference_bytes(type);
+    }
+    return bytes_from(type, args[0]);
+}
+
+/*!
+ * Checks that an argument to a bytes builtin is bytes, or also a bytearray if
+ * mutable is false. Sets an exception and returns false otherwise.
+ */
+static bool check_bytes_arg(const char *func, reference_t arg, bool mutable) {
+    value_type_t type = deref(arg)->type;
+    if (type == VAL_BYTEARRAY || (!mutable && type == VAL_BYTES)) {
+        return true;
+    }
+
+    exception_set_format(EXC_TYPE_ERROR, "%s() argument must be %s, not '%s'",
+            func, mutable ? "a bytearray" : "bytes or a bytearray", type_to_str(type));
+    return false;
+}
+
+/*!
+ * Implements slice(b, start) and slice(b, start, end), which stand in for
+ * b[start:end]. The result shares the contents of b instead of copying them.
+ */
+static reference_t eval_call_slice(size_t arity, reference_t *args) {
+    if (arity < 2 || arity > 3) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "slice() takes from 2 to 3 positional arguments but %zu were given", arity);
+        return NULL_REF;
+    }
+    if (!check_bytes_arg("slice", args[0], false)) {
+        return NULL_REF;
+    }
+
+    value_t *obj = deref(args[0]);
+    int64_t bounds[2] = {0, bytes_len(obj)};
+    for (size_t i = 1; i < arity; i++) {
+        value_t *bound = deref(args[i]);
+        if (bound->type != VAL_INTEGER) {
+            exception_set_format(EXC_TYPE_ERROR,
+                    "slice indices must be integers, not '%s'", type_to_str(bound->type));
+            return NULL_REF;
         }
+        bounds[i - 1] = ((integer_value_t *) bound)->integer_value;
+    }
+    return bytes_slice(obj, bounds[0], bounds[1]);
+}
+
+/*! Implements append(b, x), which appends byte x to bytearray b. */
+static reference_t eval_call_append(size_t arity, reference_t *args) {
+    if (arity != 2) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "append() takes 2 positional arguments but %zu were given", arity);
+        return NULL_REF;
+    }
+    if (!check_bytes_arg("append", args[0], true)) {
+        return NULL_REF;
     }
 
-    fprintf(stdout, "\n");
+    bytearray_append(deref(args[0]), args[1]);
+    if (exception_occurred()) {
+        return NULL_REF;
+    }
 
     incref(NONE_REF);
     return NONE_REF;
 }
 
-static reference_t eval_call_len(size_t arity, reference_t *args) {
+/*!
+ * Implements float(x), which converts a number, or a string holding one, to a
+ * float. Surrounding whitespace is allowed in the string.
+ */
+static reference_t eval_call_float(size_t arity, reference_t *args) {
     if (arity != 1) {
         exception_set_format(EXC_TYPE_ERROR,
-                "len() takes 1 positional argument but %d were given", arity);
+                "float() takes 1 positional argument but %zu were given", arity);
         return NULL_REF;
     }
 
-    return make_reference_int(ref_len(args[0]));
+    value_t *obj = deref(args[0]);
+    switch (obj->type) {
+        case VAL_INTEGER:
+        case VAL_BIGINT:
+        case VAL_FLOAT:
+            return make_reference_float(number_to_double(obj));
+
+        case VAL_STRING: {
+            const char *str = ((string_value_t *) obj)->string_value;
+            char *end;
+            double value = strtod(str, &end);
+            while (isspace((unsigned char) *end)) {
+                end++;
+            }
+            if (end == str || *end != '\0') {
+                exception_set_format(EXC_VALUE_ERROR,
+                        "could not convert string to float: '%s'", str);
+                return NULL_REF;
+            }
+            return make_reference_float(value);
+        }
+
+        default:
+            exception_set_format(EXC_TYPE_ERROR,
+                    "float() argument must be a string or a number, not '%s'",
+                    type_to_str(obj->type));
+            return NULL_REF;
+    }
 }
 
-static reference_t eval_call_bool(size_t arity, reference_t *args) {
+/*! Implements int(x), which truncates a float towards zero. */
+static reference_t eval_call_int(size_t arity, reference_t *args) {
     if (arity != 1) {
         exception_set_format(EXC_TYPE_ERROR,
-                "bool() takes 1 positional argument but %d were given", arity);
+                "int() takes 1 positional argument but %zu were given", arity);
         return NULL_REF;
     }
 
-    return bool_ref(ref_bool(args[0]));
+    value_t *obj = deref(args[0]);
+    switch (obj->type) {
+        case VAL_INTEGER:
+        case VAL_BIGINT:
+            incref(args[0]);
+            return args[0];
+
+        case VAL_FLOAT: {
+            double value = ((float_value_t *) obj)->float_value;
+            if (!isfinite(value)) {
+                exception_set_format(EXC_VALUE_ERROR, "cannot convert float %s to integer",
+                        isnan(value) ? "NaN" : "infinity");
+                return NULL_REF;
+            }
+            return bigint_from_double(trunc(value));
+        }
+
+        default:
+            exception_set_format(EXC_TYPE_ERROR,
+                    "int() argument must be a number, not '%s'", type_to_str(obj->type));
+            return NULL_REF;
+    }
+}
+
+/*! Implements array(x). See array_from for what x may be. */
+static reference_t eval_call_array(size_t arity, reference_t *args) {
+    if (arity != 1) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "array() takes 1 positional argument but %zu were given", arity);
+        return NULL_REF;
+    }
+    return array_from(args[0]);
+}
+
+/*!
+ * Implements sum(x), which adds up the elements of a list, tuple or array.
+ * Arrays are summed a vector at a time, and give a float.
+ */
+static reference_t eval_call_sum(size_t arity, reference_t *args) {
+    if (arity != 1) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "sum() takes 1 positional argument but %zu were given", arity);
+        return NULL_REF;
+    }
+
+    value_t *obj = deref(args[0]);
+    int64_t size;
+    reference_t *elements;
+    switch (obj->type) {
+        case VAL_FLOAT_ARRAY:
+            return make_reference_float(array_sum(obj));
+
+        case VAL_LIST: {
+            list_value_t *list = (list_value_t *) obj;
+            size = list->size;
+            elements = size > 0 ? ((ref_array_value_t *) deref(list->values))->values : NULL;
+            break;
+        }
+
+        case VAL_TUPLE:
+            size = ((tuple_value_t *) obj)->size;
+            elements = ((tuple_value_t *) obj)->values;
+            break;
+
+        default:
+            exception_set_format(EXC_TYPE_ERROR,
+                    "'%s' object is not iterable", type_to_str(obj->type));
+            return NULL_REF;
+    }
+
+    reference_t total = make_reference_int(0);
+    for (int64_t i = 0; i < size && total != NULL_REF; i++) {
+        reference_t next = ref_builtin(OP_ADD, total, elements[i]);
+        decref(total);
+        total = next;
+    }
+    return total;
+}
+
+/*! Implements weakref(x), which makes a weak reference to x. */
+static reference_t eval_call_weakref(size_t arity, reference_t *args) {
+    if (arity != 1) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "weakref() takes 1 positional argument but %zu were given", arity);
+        return NULL_REF;
+    }
+    return make_reference_weakref(args[0]);
+}
+
+/*!
+ * Implements deref(w), which returns the target of weak reference w, or None
+ * if it has been freed.
+ */
+static reference_t eval_call_deref(size_t arity, reference_t *args) {
+    if (arity != 1) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "deref() takes 1 positional argument but %zu were given", arity);
+        return NULL_REF;
+    }
+
+    value_t *obj = deref(args[0]);
+    if (obj->type != VAL_WEAKREF) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "deref() argument must be a weakref, not '%s'", type_to_str(obj->type));
+        return NULL_REF;
+    }
+    return weakref_get(obj);
+}
+
+/*! Implements weakdict(), which makes an empty weak dict. */
+static reference_t eval_call_weakdict(size_t arity, reference_t *args) {
+    (void) args;
+    if (arity != 0) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "weakdict() takes 0 positional arguments but %zu were given", arity);
+        return NULL_REF;
+    }
+    return make_reference_weakdict();
 }
 
 static reference_t eval_call(NodeExprCall *node) {
@@ -671,6 +2287,13 @@ static reference_t eval_call(NodeExprCall *node) {
         exception_set(EXC_SYNTAX_ERROR, "calling non-identifiers not supported");
     }
 
+    /* Records are built straight from the argument's AST where possible, so
+     * the argument must not be evaluated here. */
+    if (node->func->type == EXPR_IDENTIFIER &&
+            strcmp(((NodeExprIdentifier *) node->func)->name, "record") == 0) {
+        return eval_call_record(node);
+    }
+
     /* Compute function arity and arguments. */
     size_t arity = node->args ? ast_nodelist_length(node->args) : 0;
 
@@ -704,6 +2327,64 @@ static reference_t eval_call(NodeExprCall *node) {
             result = eval_call_len(arity, args);
         } else if (strcmp(name, "bool") == 0) {
             result = eval_call_bool(arity, args);
+        } else if (strcmp(name, "str") == 0) {
+            result = eval_call_str(arity, args);
+        } else if (strcmp(name, "repr") == 0) {
+            result = eval_call_repr(arity, args);
+        } else if (strcmp(name, "contains") == 0) {
+            result = eval_call_contains(arity, args);
+        } else if (strcmp(name, "get") == 0) {
+            result = eval_call_get(arity, args);
+        } else if (strcmp(name, "dict") == 0) {
+            result = eval_call_dict(arity, args);
+        } else if (strcmp(name, "copy") == 0) {
+            result = eval_call_copy(arity, args);
+        } else if (strcmp(name, "set") == 0) {
+            result = eval_call_set(arity, args);
+        } else if (strcmp(name, "add") == 0) {
+            result = eval_call_add(arity, args);
+        } else if (strcmp(name, "remove") == 0) {
+            result = eval_call_remove(arity, args);
+        } else if (strcmp(name, "union") == 0) {
+            result = eval_call_union(arity, args);
+        } else if (strcmp(name, "intersection") == 0) {
+            result = eval_call_intersection(arity, args);
+        } else if (strcmp(name, "tuple") == 0) {
+            result = eval_call_tuple(arity, args);
+        } else if (strcmp(name, "vector") == 0) {
+            result = eval_call_vector(arity, args);
+        } else if (strcmp(name, "pmap") == 0) {
+            result = eval_call_pmap(arity, args);
+        } else if (strcmp(name, "push") == 0) {
+            result = eval_call_push(arity, args);
+        } else if (strcmp(name, "pop") == 0) {
+            result = eval_call_pop(arity, args);
+        } else if (strcmp(name, "assoc") == 0) {
+            result = eval_call_assoc(arity, args);
+        } else if (strcmp(name, "dissoc") == 0) {
+            result = eval_call_dissoc(arity, args);
+        } else if (strcmp(name, "bytes") == 0) {
+            result = eval_call_bytes(VAL_BYTES, arity, args);
+        } else if (strcmp(name, "bytearray") == 0) {
+            result = eval_call_bytes(VAL_BYTEARRAY, arity, args);
+        } else if (strcmp(name, "slice") == 0) {
+            result = eval_call_slice(arity, args);
+        } else if (strcmp(name, "append") == 0) {
+            result = eval_call_append(arity, args);
+        } else if (strcmp(name, "float") == 0) {
+            result = eval_call_float(arity, args);
+        } else if (strcmp(name, "int") == 0) {
+            result = eval_call_int(arity, args);
+        } else if (strcmp(name, "array") == 0) {
+            result = eval_call_array(arity, args);
+        } else if (strcmp(name, "sum") == 0) {
+            result = eval_call_sum(arity, args);
+        } else if (strcmp(name, "weakref") == 0) {
+            result = eval_call_weakref(arity, args);
+        } else if (strcmp(name, "deref") == 0) {
+            result = eval_call_deref(arity, args);
+        } else if (strcmp(name, "weakdict") == 0) {
+            result = eval_call_weakdict(arity, args);
         } else {
             result = NULL_REF;
             exception_set_format(EXC_NAME_ERROR, "no such function '%s'", name);
@@ -719,18 +2400,48 @@ static reference_t eval_call(NodeExprCall *node) {
 
 //// GLOBAL VAR FUNCTIONS ////
 
+/*!
+ * Returns the entry for a global variable, or NULL if it doesn't exist.
+ * The entry is only valid until the next global is added or deleted.
+ */
+static global_variable_t *globals_find(const char *name) {
+    for (size_t i = 0; i < num_vars; i++) {
+        if (global_vars[i].name != NULL && strcmp(name, global_vars[i].name) == 0) {
+            return &global_vars[i];
+        }
+    }
+    return NULL;
+}
+
+/*!
+ * Stores an integer into an existing global variable. If the variable holds
+ * an integer that nothing else refers to, even weakly, it is updated in place
+ * rather than allocating a new one.
+ */
+static void globals_store_int(global_variable_t *var, int64_t value) {
+    value_t *obj = deref(var->ref);
+    if (obj->type == VAL_INTEGER && obj->ref_count == 1 && obj->weakrefs == NULL_REF) {
+        ((integer_value_t *) obj)->integer_value = value;
+        return;
+    }
+
+    reference_t result = make_reference_int(value);
+    if (exception_occurred()) {
+        return;
+    }
+    decref(var->ref);
+    var->ref = result;
+}
+
 /*!
  * Tries to retrieve a global variable's reference. The returned reference is
  * a new reference to the stored value.
  */
 static reference_t globals_get(const char *name) {
-    if (global_vars != NULL) {
-        for (size_t i = 0; i < num_vars; i++) {
-            if (global_vars[i].name != NULL && strcmp(name, global_vars[i].name) == 0) {
-                incref(global_vars[i].ref);
-                return global_vars[i].ref;
-            }
-        }
+    global_variable_t *var = globals_find(name);
+    if (var != NULL) {
+        incref(var->ref);
+        return var->ref;
     }
 
     exception_set_format(EXC_NAME_ERROR, "name '%s' is not defined", name);
@@ -9,6 +9,7 @@
 
 void eval_init(void);
 reference_t eval_root(Node *root);
+void eval_profile_start(void);
 
 bool ref_is_none(reference_t r);
 bool ref_is_true(reference_t r);
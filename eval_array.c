@@ -0,0 +1,373 @@
+#include "eval_array.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "eval_refs.h"
+#include "eval_types.h"
+#include "exception.h"
+#include "refs.h"
+
+/*
+ * Arrays are processed a vector of doubles at a time using GCC's vector
+ * extensions, which compile to SIMD instructions on any target that has them
+ * and to plain scalar code elsewhere. Vectors are 16 bytes, the width SSE2
+ * and NEON have on every x86-64 and AArch64 machine. Elements that don't fill
+ * a whole vector at the end of an array are handled one at a time.
+ */
+
+typedef double vdouble_t __attribute__((vector_size(16)));
+
+/*! The number of doubles in a vdouble_t. */
+#define LANES ((int64_t) (sizeof(vdouble_t) / sizeof(double)))
+
+/*! Loads a vector from memory with no particular alignment. */
+static inline vdouble_t vload(const double *p) {
+    vdouble_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/*! Stores a vector to memory with no particular alignment. */
+static inline void vstore(double *p, vdouble_t v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+/*!
+ * The kernels for one elementwise operator, for an array with an array, an
+ * array with a scalar, and a scalar with an array. out has room for size
+ * elements and doesn't overlap the inputs.
+ */
+typedef struct {
+    void (*aa)(double *out, const double *l, const double *r, int64_t size);
+    void (*as)(double *out, const double *l, double r, int64_t size);
+    void (*sa)(double *out, double l, const double *r, int64_t size);
+} array_kernels_t;
+
+#define DEFINE_KERNELS(name, op)                                                \
+    static void name##_aa(double *out, const double *l, const double *r,       \
+            int64_t size) {                                                     \
+        int64_t i = 0;                                                          \
+        for (; i + LANES <= size; i += LANES) {                                 \
+            vstore(out + i, vload(l + i) op vload(r + i));                      \
+        }                                                                       \
+        for (; i < size; i++) {                                                 \
+            out[i] = l[i] op r[i];                                              \
+        }                                                                       \
+    }                                                                           \
+    static void name##_as(double *out, const double *l, double r, int64_t size) { \
+        vdouble_t vr = (vdouble_t) {0} + r;                                     \
+        int64_t i = 0;                                                          \
+        for (; i + LANES <= size; i += LANES) {                                 \
+            vstore(out + i, vload(l + i) op vr);                                \
+        }                                                                       \
+        for (; i < size; i++) {                                                 \
+            out[i] = l[i] op r;                                                 \
+        }                                                                       \
+    }                                                                           \
+    static void name##_sa(double *out, double l, const double *r, int64_t size) { \
+        vdouble_t vl = (vdouble_t) {0} + l;                                     \
+        int64_t i = 0;                                                          \
+        for (; i + LANES <= size; i += LANES) {                                 \
+            vstore(out + i, vl op vload(r + i));                                \
+        }                                                                       \
+        for (; i < size; i++) {                                                 \
+            out[i] = l op r[i];                                                 \
+        }                                                                       \
+    }                                                                           \
+    static const array_kernels_t name##_kernels = {name##_aa, name##_as, name##_sa};
+
+DEFINE_KERNELS(add, +)
+DEFINE_KERNELS(subtract, -)
+DEFINE_KERNELS(multiply, *)
+DEFINE_KERNELS(divide, /)
+
+/*! Returns the sum of size doubles, accumulating a vector at a time. */
+static double sum_kernel(const double *values, int64_t size) {
+    vdouble_t acc = {0};
+    int64_t i = 0;
+    for (; i + LANES <= size; i += LANES) {
+        acc += vload(values + i);
+    }
+
+    double sum = 0.0;
+    for (int64_t lane = 0; lane < LANES; lane++) {
+        sum += acc[lane];
+    }
+    for (; i < size; i++) {
+        sum += values[i];
+    }
+    return sum;
+}
+
+static inline float_array_value_t *array_coerce(value_t *obj) {
+    assert(obj->type == VAL_FLOAT_ARRAY);
+    return (float_array_value_t *) obj;
+}
+
+/*! Returns whether a value is an integer, bigint or float. */
+static bool is_number(value_t *obj) {
+    return obj->type == VAL_INTEGER || obj->type == VAL_BIGINT || obj->type == VAL_FLOAT;
+}
+
+/*!
+ * Converts a number to a double to store in an array. Sets an exception and
+ * returns false if it isn't a number.
+ */
+static bool coerce_element(reference_t ref, double *out) {
+    value_t *obj = deref(ref);
+    if (!is_number(obj)) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "array elements must be numbers, not '%s'", type_to_str(obj->type));
+        return false;
+    }
+    *out = number_to_double(obj);
+    return true;
+}
+
+/*!
+ * Turns a subscript into an index into the array, counting from the end if
+ * it is negative. Sets an exception and returns -1 if it is not a valid index.
+ */
+static int64_t array_coerce_subscript(float_array_value_t *array, reference_t subscr) {
+    value_t *obj = deref(subscr);
+    if (obj->type != VAL_INTEGER) {
+        exception_set(EXC_TYPE_ERROR, "array indices must be integers");
+        return -1;
+    }
+
+    int64_t idx = ((integer_value_t *) obj)->integer_value;
+    if (idx < 0) {
+        idx += array->size;
+    }
+    if (idx < 0 || idx >= array->size) {
+        exception_set(EXC_INDEX_ERROR, "array index out of bounds");
+        return -1;
+    }
+    return idx;
+}
+
+/*!
+ * Applies an elementwise operator to two operands, at least one of which is
+ * an array. The other may be a number, which is used for every element.
+ * Returns a new reference to the resulting array, or NULL_REF on error.
+ */
+static reference_t array_binop(value_t *l, value_t *r, const array_kernels_t *kernels) {
+    int64_t size = l->type == VAL_FLOAT_ARRAY ? array_coerce(l)->size : array_coerce(r)->size;
+    if (l->type == VAL_FLOAT_ARRAY && r->type == VAL_FLOAT_ARRAY && array_coerce(r)->size != size) {
+        exception_set_format(EXC_VALUE_ERROR,
+                "array sizes differ: %lld and %lld",
+                (long long) size, (long long) array_coerce(r)->size);
+        return NULL_REF;
+    }
+
+    reference_t ref = make_reference_float_array(size);
+    if (ref == NULL_REF) {
+        return NULL_REF;
+    }
+
+    double *out = array_coerce(deref(ref))->values;
+    if (l->type != VAL_FLOAT_ARRAY) {
+        kernels->sa(out, number_to_double(l), array_coerce(r)->values, size);
+    } else if (r->type != VAL_FLOAT_ARRAY) {
+        kernels->as(out, array_coerce(l)->values, number_to_double(r), size);
+    } else {
+        kernels->aa(out, array_coerce(l)->values, array_coerce(r)->values, size);
+    }
+    return ref;
+}
+
+//// TYPE INTERFACE FUNCTIONS ////
+
+bool array_bool(value_t *obj) {
+    return array_len(obj) > 0;
+}
+
+int64_t array_len(value_t *obj) {
+    return array_coerce(obj)->size;
+}
+
+/*! Arrays are equal if they have the same size and equal elements. */
+bool array_eq(value_t *l, value_t *r) {
+    if (l->type != r->type) {
+        return false;
+    }
+
+    float_array_value_t *larray = array_coerce(l);
+    float_array_value_t *rarray = array_coerce(r);
+    if (larray->size != rarray->size) {
+        return false;
+    }
+    for (int64_t i = 0; i < larray->size; i++) {
+        if (larray->values[i] != rarray->values[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*! Implements membership tests for arrays, which only hold numbers. */
+bool array_contains(value_t *obj, reference_t item) {
+    float_array_value_t *array = array_coerce(obj);
+    value_t *value = deref(item);
+    if (!is_number(value)) {
+        return false;
+    }
+
+    double target = number_to_double(value);
+    for (int64_t i = 0; i < array->size; i++) {
+        if (array->values[i] == target) {
+            return true;
+        }
+    }
+    return false;
+}
+
+reference_t array_unaryop_negate(value_t *l, value_t *r) {
+    (void) r;
+    float_array_value_t *array = array_coerce(l);
+    reference_t ref = make_reference_float_array(array->size);
+    if (ref != NULL_REF) {
+        /* Multiplying by -1 flips the sign of zeros too, unlike 0 - x. */
+        multiply_sa(array_coerce(deref(ref))->values, -1.0, array->values, array->size);
+    }
+    return ref;
+}
+
+reference_t array_unaryop_identity(value_t *l, value_t *r) {
+    (void) r;
+    float_array_value_t *array = array_coerce(l);
+    reference_t ref = make_reference_float_array(array->size);
+    if (ref != NULL_REF) {
+        memcpy(array_coerce(deref(ref))->values, array->values, sizeof(double[array->size]));
+    }
+    return ref;
+}
+
+/*
+ * Arithmetic on arrays is elementwise, with IEEE semantics: dividing by zero
+ * gives an infinity or NaN rather than an error, so that one bad element
+ * doesn't abort the whole operation.
+ */
+
+reference_t array_binop_add(value_t *l, value_t *r) {
+    return array_binop(l, r, &add_kernels);
+}
+
+reference_t array_binop_subtract(value_t *l, value_t *r) {
+    return array_binop(l, r, &subtract_kernels);
+}
+
+reference_t array_binop_multiply(value_t *l, value_t *r) {
+    return array_binop(l, r, &multiply_kernels);
+}
+
+reference_t array_binop_divide(value_t *l, value_t *r) {
+    return array_binop(l, r, &divide_kernels);
+}
+
+/*! Implements subscript access for arrays. */
+reference_t array_subscr_get(value_t *obj, reference_t subscr) {
+    float_array_value_t *array = array_coerce(obj);
+
+    int64_t idx = array_coerce_subscript(array, subscr);
+    if (idx < 0) {
+        return NULL_REF;
+    }
+    return make_reference_float(array->values[idx]);
+}
+
+/*! Implements subscript assignment for arrays, converting the value to a float. */
+void array_subscr_set(value_t *obj, reference_t subscr, reference_t value) {
+    float_array_value_t *array = array_coerce(obj);
+
+    int64_t idx = array_coerce_subscript(array, subscr);
+    if (idx < 0) {
+        return;
+    }
+    coerce_element(value, &array->values[idx]);
+}
+
+/*! Implements printing of arrays, as the call that would build them. */
+void array_print(value_t *obj, sink_t *sink, size_t depth) {
+    /* If we have reached the maximum recursion depth, print a placeholder. */
+    if (depth == 0) {
+        sink_puts(sink, "...");
+        return;
+    }
+
+    float_array_value_t *array = array_coerce(obj);
+    sink_puts(sink, "array([");
+    for (int64_t i = 0; i < array->size; i++) {
+        if (i > 0) {
+            sink_puts(sink, ", ");
+        }
+        sink_double(sink, array->values[i]);
+    }
+    sink_puts(sink, "])");
+}
+
+//// HELPER FUNCTIONS ////
+
+/*!
+ * Returns a new reference to an array built from source, or NULL_REF on
+ * error. source is either a count, giving that many zeros, or a list, tuple
+ * or array of numbers to copy.
+ */
+reference_t array_from(reference_t source) {
+    value_t *obj = deref(source);
+
+    int64_t size;
+    reference_t *elements = NULL;
+    switch (obj->type) {
+        case VAL_INTEGER:
+            size = ((integer_value_t *) obj)->integer_value;
+            if (size < 0) {
+                exception_set(EXC_VALUE_ERROR, "negative count");
+                return NULL_REF;
+            }
+            return make_reference_float_array(size);
+
+        case VAL_LIST: {
+            list_value_t *list = (list_value_t *) obj;
+            size = list->size;
+            if (size > 0) {
+                elements = ((ref_array_value_t *) deref(list->values))->values;
+            }
+            break;
+        }
+
+        case VAL_TUPLE:
+            size = ((tuple_value_t *) obj)->size;
+            elements = ((tuple_value_t *) obj)->values;
+            break;
+
+        case VAL_FLOAT_ARRAY:
+            return array_unaryop_identity(obj, NULL);
+
+        default:
+            exception_set_format(EXC_TYPE_ERROR,
+                    "cannot convert '%s' object to array", type_to_str(obj->type));
+            return NULL_REF;
+    }
+
+    reference_t ref = make_reference_float_array(size);
+    if (ref == NULL_REF) {
+        return NULL_REF;
+    }
+
+    float_array_value_t *array = array_coerce(deref(ref));
+    for (int64_t i = 0; i < size; i++) {
+        if (!coerce_element(elements[i], &array->values[i])) {
+            decref(ref);
+            return NULL_REF;
+        }
+    }
+    return ref;
+}
+
+/*! Returns the sum of an array's elements. */
+double array_sum(value_t *obj) {
+    float_array_value_t *array = array_coerce(obj);
+    return sum_kernel(array->values, array->size);
+}
@@ -0,0 +1,30 @@
+#ifndef EVAL_ARRAY_H
+#define EVAL_ARRAY_H
+
+#include <stdbool.h>
+
+#include "format.h"
+#include "types.h"
+
+// TYPE INTERFACE FUNCTIONS //
+
+bool array_bool(value_t *obj);
+int64_t array_len(value_t *obj);
+bool array_eq(value_t *l, value_t *r);
+bool array_contains(value_t *obj, reference_t item);
+reference_t array_unaryop_negate(value_t *l, value_t *r);
+reference_t array_unaryop_identity(value_t *l, value_t *r);
+reference_t array_binop_add(value_t *l, value_t *r);
+reference_t array_binop_subtract(value_t *l, value_t *r);
+reference_t array_binop_multiply(value_t *l, value_t *r);
+reference_t array_binop_divide(value_t *l, value_t *r);
+reference_t array_subscr_get(value_t *obj, reference_t subscr);
+void array_subscr_set(value_t *obj, reference_t subscr, reference_t value);
+void array_print(value_t *obj, sink_t *sink, size_t depth);
+
+// HELPER FUNCTIONS //
+
+reference_t array_from(reference_t source);
+double array_sum(value_t *obj);
+
+#endif /* EVAL_ARRAY_H */
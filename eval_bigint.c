@@ -0,0 +1,640 @@
+#include "eval_bigint.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "eval_refs.h"
+#include "eval_types.h"
+#include "exception.h"
+#include "refs.h"
+
+/*
+ * Bigints store the magnitude of an integer as an array of 64-bit limbs, and
+ * the magnitude functions below work on such arrays directly. Products are
+ * computed schoolbook style until both operands are at least
+ * KARATSUBA_THRESHOLD limbs long, where Karatsuba's method takes over.
+ */
+
+/*! The length of the shorter factor above which Karatsuba multiplication is used. */
+#define KARATSUBA_THRESHOLD 32
+
+/*! The largest power of 10 that fits in a limb, used to print bigints. */
+#define DECIMAL_BASE 10000000000000000000ULL
+#define DECIMAL_DIGITS 19
+
+typedef unsigned __int128 uint128_t;
+
+/*!
+ * The sign and magnitude of an integer or a bigint operand. An integer's
+ * magnitude is held in small, which limbs then points to, so an operand_t
+ * must not be copied.
+ */
+typedef struct {
+    bool negative;
+    size_t length;
+    const uint64_t *limbs;
+    uint64_t small;
+} operand_t;
+
+static void operand_init(operand_t *op, value_t *obj) {
+    if (obj->type == VAL_INTEGER) {
+        int64_t value = ((integer_value_t *) obj)->integer_value;
+        op->negative = value < 0;
+        op->small = value < 0 ? -(uint64_t) value : (uint64_t) value;
+        op->length = op->small != 0;
+        op->limbs = &op->small;
+        return;
+    }
+
+    assert(obj->type == VAL_BIGINT);
+    bigint_value_t *bigint = (bigint_value_t *) obj;
+    op->negative = bigint->negative;
+    op->length = bigint->length;
+    op->limbs = bigint->limbs;
+}
+
+/*!
+ * Allocates a bigint with room for length limbs and returns a pointer to them
+ * through limbs. Returns NULL_REF on error.
+ *
+ * The memory pool doesn't merge free blocks, so a bigint that grows a limb at
+ * a time would leave behind a trail of blocks too small for anything else.
+ * Rounding the room up to a power of two limbs lets a bigint reuse the blocks
+ * of the ones before it until it doubles in size.
+ */
+static reference_t bigint_alloc(size_t length, uint64_t **limbs) {
+    size_t capacity = 1;
+    while (capacity < length) {
+        capacity *= 2;
+    }
+
+    reference_t ref = make_reference_bigint(capacity);
+    if (ref != NULL_REF) {
+        bigint_value_t *bigint = (bigint_value_t *) deref(ref);
+        bigint->length = length;
+        *limbs = bigint->limbs;
+    }
+    return ref;
+}
+
+/*!
+ * Finishes a bigint whose limbs have been filled in, giving it a sign and
+ * dropping leading zero limbs. If the result fits in 64 bits, the bigint is
+ * released and a new integer is returned instead. Returns NULL_REF on error.
+ */
+static reference_t bigint_normalize(reference_t ref, bool negative) {
+    if (ref == NULL_REF) {
+        return NULL_REF;
+    }
+
+    bigint_value_t *bigint = (bigint_value_t *) deref(ref);
+    while (bigint->length > 0 && bigint->limbs[bigint->length - 1] == 0) {
+        bigint->length--;
+    }
+    bigint->negative = negative && bigint->length > 0;
+
+    if (bigint->length > 1) {
+        return ref;
+    }
+
+    uint64_t magnitude = bigint->length == 0 ? 0 : bigint->limbs[0];
+    if (magnitude > (uint64_t) INT64_MAX + bigint->negative) {
+        return ref;
+    }
+
+    int64_t value = bigint->negative ? -(int64_t) (magnitude - 1) - 1 : (int64_t) magnitude;
+    decref(ref);
+    return make_reference_int(value);
+}
+
+/*! Returns a new scratch buffer of count limbs, or NULL and sets an exception. */
+static uint64_t *scratch_alloc(size_t count) {
+    uint64_t *scratch = malloc(count * sizeof(uint64_t));
+    if (scratch == NULL) {
+        exception_set(EXC_MEMORY_ERROR, "cannot allocate scratch space for bigint");
+    }
+    return scratch;
+}
+
+//// MAGNITUDE ARITHMETIC ////
+
+/*! Compares two magnitudes without leading zero limbs. */
+static int mag_cmp(const uint64_t *a, size_t an, const uint64_t *b, size_t bn) {
+    if (an != bn) {
+        return an > bn ? 1 : -1;
+    }
+    for (size_t i = an; i-- > 0; ) {
+        if (a[i] != b[i]) {
+            return a[i] > b[i] ? 1 : -1;
+        }
+    }
+    return 0;
+}
+
+/*! Adds b into r in place, with bn <= rn. Returns the carry out of r. */
+static uint64_t mag_add_to(uint64_t *r, size_t rn, const uint64_t *b, size_t bn) {
+    uint64_t carry = 0;
+    size_t i = 0;
+    for (; i < bn; i++) {
+        uint128_t sum = (uint128_t) r[i] + b[i] + carry;
+        r[i] = (uint64_t) sum;
+        carry = (uint64_t) (sum >> 64);
+    }
+    for (; carry != 0 && i < rn; i++) {
+        carry = ++r[i] == 0;
+    }
+    return carry;
+}
+
+/*! Subtracts b from r in place, with bn <= rn. Returns the borrow out of r. */
+static uint64_t mag_sub_from(uint64_t *r, size_t rn, const uint64_t *b, size_t bn) {
+    uint64_t borrow = 0;
+    size_t i = 0;
+    for (; i < bn; i++) {
+        uint128_t diff = (uint128_t) r[i] - b[i] - borrow;
+        r[i] = (uint64_t) diff;
+        borrow = (uint64_t) (diff >> 64) != 0;
+    }
+    for (; borrow != 0 && i < rn; i++) {
+        borrow = r[i]-- == 0;
+    }
+    return borrow;
+}
+
+/*! Stores a * b in r, which has an + bn limbs and doesn't overlap a or b. */
+static void mag_mul_basecase(uint64_t *r, const uint64_t *a, size_t an,
+        const uint64_t *b, size_t bn) {
+    memset(r, 0, (an + bn) * sizeof(uint64_t));
+    for (size_t i = 0; i < an; i++) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < bn; j++) {
+            uint128_t product = (uint128_t) a[i] * b[j] + r[i + j] + carry;
+            r[i + j] = (uint64_t) product;
+            carry = (uint64_t) (product >> 64);
+        }
+        r[i + bn] = carry;
+    }
+}
+
+/*! Returns the number of scratch limbs mag_mul needs for factors of up to n limbs. */
+static size_t mag_mul_scratch(size_t n) {
+    /* Each level of recursion uses about 2n limbs for a problem half as big
+     * as its parent's, plus a few limbs of slack per level. */
+    return 4 * n + 16 * 64;
+}
+
+/*!
+ * Stores a * b in r, which has an + bn limbs and doesn't overlap a or b. Both
+ * factors must be nonempty. scratch must have room for mag_mul_scratch of the
+ * longer factor's length.
+ */
+static void mag_mul(uint64_t *r, const uint64_t *a, size_t an,
+        const uint64_t *b, size_t bn, uint64_t *scratch) {
+    if (an < bn) {
+        const uint64_t *t = a;
+        a = b;
+        b = t;
+        size_t tn = an;
+        an = bn;
+        bn = tn;
+    }
+
+    if (bn < KARATSUBA_THRESHOLD) {
+        mag_mul_basecase(r, a, an, b, bn);
+        return;
+    }
+
+    /* Karatsuba needs factors of similar length, so a much longer factor is
+     * multiplied in pieces as long as the shorter one. */
+    if (an >= 2 * bn) {
+        uint64_t *product = scratch;
+        memset(r, 0, (an + bn) * sizeof(uint64_t));
+        for (size_t i = 0; i < an; i += bn) {
+            size_t n = an - i < bn ? an - i : bn;
+            mag_mul(product, a + i, n, b, bn, scratch + 2 * bn);
+            mag_add_to(r + i, an + bn - i, product, n + bn);
+        }
+        return;
+    }
+
+    /* Split both factors at m limbs, as a = a1 B^m + a0 and b = b1 B^m + b0.
+     * Since an < 2 bn, m < bn and so b1 is nonempty. Then
+     * a b = z2 B^2m + z1 B^m + z0, where z0 = a0 b0, z2 = a1 b1 and
+     * z1 = (a0 + a1)(b0 + b1) - z0 - z2. */
+    size_t m = an / 2;
+    size_t a1n = an - m;
+    size_t b1n = bn - m;
+
+    mag_mul(r, a, m, b, m, scratch);
+    mag_mul(r + 2 * m, a + m, a1n, b + m, b1n, scratch);
+
+    size_t san = a1n + 1;
+    uint64_t *sa = scratch;
+    memcpy(sa, a + m, a1n * sizeof(uint64_t));
+    sa[a1n] = mag_add_to(sa, a1n, a, m);
+
+    size_t sbn = (b1n > m ? b1n : m) + 1;
+    uint64_t *sb = sa + san;
+    memset(sb, 0, sbn * sizeof(uint64_t));
+    memcpy(sb, b, m * sizeof(uint64_t));
+    mag_add_to(sb, sbn, b + m, b1n);
+
+    size_t z1n = san + sbn;
+    uint64_t *z1 = sb + sbn;
+    mag_mul(z1, sa, san, sb, sbn, z1 + z1n);
+    mag_sub_from(z1, z1n, r, 2 * m);
+    mag_sub_from(z1, z1n, r + 2 * m, a1n + b1n);
+
+    /* The sums may have had leading zeros, but z1 B^m fits in the product. */
+    while (z1n > 0 && z1[z1n - 1] == 0) {
+        z1n--;
+    }
+    mag_add_to(r + m, an + bn - m, z1, z1n);
+}
+
+/*!
+ * Divides a by the limb d, storing the quotient in q, which has an limbs.
+ * Returns the remainder.
+ */
+static uint64_t mag_divmod_limb(uint64_t *q, const uint64_t *a, size_t an, uint64_t d) {
+    uint64_t rem = 0;
+    for (size_t i = an; i-- > 0; ) {
+        uint128_t num = ((uint128_t) rem << 64) | a[i];
+        q[i] = (uint64_t) (num / d);
+        rem = (uint64_t) (num % d);
+    }
+    return rem;
+}
+
+/*!
+ * Divides a by b using Knuth's algorithm D, where an >= bn >= 2 and b has no
+ * leading zero limbs. The quotient is stored in q, which has an - bn + 1
+ * limbs, and the remainder in r, which has bn limbs. scratch must have room
+ * for an + bn + 1 limbs.
+ */
+static void mag_divmod(uint64_t *q, uint64_t *r, const uint64_t *a, size_t an,
+        const uint64_t *b, size_t bn, uint64_t *scratch) {
+    /* Shift both operands so that the top bit of the divisor is set, which
+     * keeps each estimated quotient limb within 2 of the right one. */
+    int shift = __builtin_clzll(b[bn - 1]);
+    uint64_t *u = scratch;
+    uint64_t *v = scratch + an + 1;
+
+    for (size_t i = bn; i-- > 0; ) {
+        v[i] = b[i] << shift;
+        if (shift != 0 && i > 0) {
+            v[i] |= b[i - 1] >> (64 - shift);
+        }
+    }
+    u[an] = shift != 0 ? a[an - 1] >> (64 - shift) : 0;
+    for (size_t i = an; i-- > 0; ) {
+        u[i] = a[i] << shift;
+        if (shift != 0 && i > 0) {
+            u[i] |= a[i - 1] >> (64 - shift);
+        }
+    }
+
+    for (size_t j = an - bn + 1; j-- > 0; ) {
+        uint128_t num = ((uint128_t) u[j + bn] << 64) | u[j + bn - 1];
+        uint128_t qhat = num / v[bn - 1];
+        uint128_t rhat = num % v[bn - 1];
+        while ((qhat >> 64) != 0 ||
+                qhat * v[bn - 2] > ((rhat << 64) | u[j + bn - 2])) {
+            qhat--;
+            rhat += v[bn - 1];
+            if ((rhat >> 64) != 0) {
+                break;
+            }
+        }
+
+        /* Subtract qhat v from the current window of u. */
+        uint64_t carry = 0;
+        uint64_t borrow = 0;
+        for (size_t i = 0; i < bn; i++) {
+            uint128_t product = qhat * v[i] + carry;
+            carry = (uint64_t) (product >> 64);
+            uint128_t diff = (uint128_t) u[i + j] - (uint64_t) product - borrow;
+            u[i + j] = (uint64_t) diff;
+            borrow = (uint64_t) (diff >> 64) != 0;
+        }
+        uint128_t diff = (uint128_t) u[j + bn] - carry - borrow;
+        u[j + bn] = (uint64_t) diff;
+
+        /* If that went negative, qhat was one too big, so add v back. */
+        if ((uint64_t) (diff >> 64) != 0) {
+            qhat--;
+            u[j + bn] += mag_add_to(u + j, bn, v, bn);
+        }
+        q[j] = (uint64_t) qhat;
+    }
+
+    for (size_t i = 0; i < bn; i++) {
+        r[i] = u[i] >> shift;
+        if (shift != 0) {
+            r[i] |= u[i + 1] << (64 - shift);
+        }
+    }
+}
+
+//// SIGNED ARITHMETIC ////
+
+/*! Returns a new reference to a copy of an operand, negated if negate is true. */
+static reference_t bigint_copy(operand_t *op, bool negate) {
+    uint64_t *limbs;
+    reference_t ref = bigint_alloc(op->length, &limbs);
+    if (ref != NULL_REF) {
+        memcpy(limbs, op->limbs, op->length * sizeof(uint64_t));
+    }
+    return bigint_normalize(ref, op->negative != negate);
+}
+
+/*! Returns a new reference to a + b, or to a - b if subtract is true. */
+static reference_t bigint_add(operand_t *a, operand_t *b, bool subtract) {
+    bool b_negative = b->negative != subtract;
+
+    /* With equal signs, the magnitudes add. Otherwise the smaller one is
+     * subtracted from the larger one, whose sign the result takes. */
+    if (a->negative == b_negative) {
+        if (a->length < b->length) {
+            operand_t *t = a;
+            a = b;
+            b = t;
+        }
+
+        uint64_t *limbs;
+        reference_t ref = bigint_alloc(a->length + 1, &limbs);
+        if (ref != NULL_REF) {
+            memcpy(limbs, a->limbs, a->length * sizeof(uint64_t));
+            limbs[a->length] = mag_add_to(limbs, a->length, b->limbs, b->length);
+        }
+        return bigint_normalize(ref, b_negative);
+    }
+
+    bool negative = b_negative;
+    if (mag_cmp(a->limbs, a->length, b->limbs, b->length) >= 0) {
+        negative = a->negative;
+    } else {
+        operand_t *t = a;
+        a = b;
+        b = t;
+    }
+
+    uint64_t *limbs;
+    reference_t ref = bigint_alloc(a->length, &limbs);
+    if (ref != NULL_REF) {
+        memcpy(limbs, a->limbs, a->length * sizeof(uint64_t));
+        mag_sub_from(limbs, a->length, b->limbs, b->length);
+    }
+    return bigint_normalize(ref, negative);
+}
+
+/*!
+ * Returns a new reference to the quotient of a and b if quotient is true, or
+ * to the remainder otherwise. Like integer division, the quotient is
+ * truncated toward zero, and the remainder takes the sign of a.
+ */
+static reference_t bigint_divmod(operand_t *a, operand_t *b, bool quotient) {
+    if (b->length == 0) {
+        exception_set(EXC_ZERO_DIVISION_ERROR, "integer division or modulo by zero");
+        return NULL_REF;
+    }
+
+    /* If |a| < |b|, the quotient is 0 and the remainder is a. */
+    if (mag_cmp(a->limbs, a->length, b->limbs, b->length) < 0) {
+        return quotient ? make_reference_int(0) : bigint_copy(a, false);
+    }
+
+    uint64_t *q_limbs;
+    reference_t q = bigint_alloc(a->length - b->length + 1, &q_limbs);
+    if (q == NULL_REF) {
+        return NULL_REF;
+    }
+    uint64_t *r_limbs;
+    reference_t r = bigint_alloc(b->length, &r_limbs);
+    if (r == NULL_REF) {
+        decref(q);
+        return NULL_REF;
+    }
+
+    if (b->length == 1) {
+        r_limbs[0] = mag_divmod_limb(q_limbs, a->limbs, a->length, b->limbs[0]);
+    } else {
+        uint64_t *scratch = scratch_alloc(a->length + b->length + 1);
+        if (scratch == NULL) {
+            decref(q);
+            decref(r);
+            return NULL_REF;
+        }
+        mag_divmod(q_limbs, r_limbs, a->limbs, a->length, b->limbs, b->length, scratch);
+        free(scratch);
+    }
+
+    if (quotient) {
+        decref(r);
+        return bigint_normalize(q, a->negative != b->negative);
+    }
+    decref(q);
+    return bigint_normalize(r, a->negative);
+}
+
+//// TYPE INTERFACE FUNCTIONS ////
+
+/*! Bigints are always nonzero, so they are always true. */
+bool bigint_bool(value_t *obj) {
+    (void) obj;
+    return true;
+}
+
+uint64_t bigint_hash(value_t *obj) {
+    operand_t op;
+    operand_init(&op, obj);
+    return hash_bytes((const char *) op.limbs, op.length * sizeof(uint64_t)) ^ op.negative;
+}
+
+int bigint_cmp(value_t *l, value_t *r) {
+    operand_t a, b;
+    operand_init(&a, l);
+    operand_init(&b, r);
+
+    if (a.negative != b.negative) {
+        return a.negative ? -1 : 1;
+    }
+    int comparison = mag_cmp(a.limbs, a.length, b.limbs, b.length);
+    return a.negative ? -comparison : comparison;
+}
+
+bool bigint_eq(value_t *l, value_t *r) {
+    return bigint_cmp(l, r) == 0;
+}
+
+reference_t bigint_unaryop_negate(value_t *l, value_t *r) {
+    (void) r;
+    operand_t a;
+    operand_init(&a, l);
+    return bigint_copy(&a, true);
+}
+
+reference_t bigint_unaryop_identity(value_t *l, value_t *r) {
+    (void) r;
+    operand_t a;
+    operand_init(&a, l);
+    return bigint_copy(&a, false);
+}
+
+reference_t bigint_binop_add(value_t *l, value_t *r) {
+    operand_t a, b;
+    operand_init(&a, l);
+    operand_init(&b, r);
+    return bigint_add(&a, &b, false);
+}
+
+reference_t bigint_binop_subtract(value_t *l, value_t *r) {
+    operand_t a, b;
+    operand_init(&a, l);
+    operand_init(&b, r);
+    return bigint_add(&a, &b, true);
+}
+
+reference_t bigint_binop_multiply(value_t *l, value_t *r) {
+    operand_t a, b;
+    operand_init(&a, l);
+    operand_init(&b, r);
+    if (a.length == 0 || b.length == 0) {
+        return make_reference_int(0);
+    }
+
+    uint64_t *limbs;
+    reference_t ref = bigint_alloc(a.length + b.length, &limbs);
+    if (ref == NULL_REF) {
+        return NULL_REF;
+    }
+
+    if (a.length < KARATSUBA_THRESHOLD || b.length < KARATSUBA_THRESHOLD) {
+        mag_mul_basecase(limbs, a.limbs, a.length, b.limbs, b.length);
+    } else {
+        size_t n = a.length > b.length ? a.length : b.length;
+        uint64_t *scratch = scratch_alloc(mag_mul_scratch(n));
+        if (scratch == NULL) {
+            decref(ref);
+            return NULL_REF;
+        }
+        mag_mul(limbs, a.limbs, a.length, b.limbs, b.length, scratch);
+        free(scratch);
+    }
+    return bigint_normalize(ref, a.negative != b.negative);
+}
+
+reference_t bigint_binop_divide(value_t *l, value_t *r) {
+    operand_t a, b;
+    operand_init(&a, l);
+    operand_init(&b, r);
+    return bigint_divmod(&a, &b, true);
+}
+
+reference_t bigint_binop_modulo(value_t *l, value_t *r) {
+    operand_t a, b;
+    operand_init(&a, l);
+    operand_init(&b, r);
+    return bigint_divmod(&a, &b, false);
+}
+
+/*!
+ * Implements printing of bigints in decimal, by repeatedly dividing off the
+ * lowest 19 digits.
+ */
+void bigint_print(value_t *obj, sink_t *sink, size_t depth) {
+    /* If we have reached the maximum recursion depth, print a placeholder. */
+    if (depth == 0) {
+        sink_puts(sink, "...");
+        return;
+    }
+
+    operand_t op;
+    operand_init(&op, obj);
+
+    /* Each limb gives at most 20 digits. */
+    size_t size = op.length * 20 + 2;
+    uint64_t *limbs = malloc(op.length * sizeof(uint64_t));
+    char *digits = malloc(size);
+    if (limbs == NULL || digits == NULL) {
+        free(limbs);
+        free(digits);
+        sink_puts(sink, "<bigint>");
+        return;
+    }
+    memcpy(limbs, op.limbs, op.length * sizeof(uint64_t));
+
+    char *p = digits + size;
+    *--p = '\0';
+    size_t length = op.length;
+    while (length > 0) {
+        uint64_t chunk = mag_divmod_limb(limbs, limbs, length, DECIMAL_BASE);
+        while (length > 0 && limbs[length - 1] == 0) {
+            length--;
+        }
+
+        /* Every chunk but the most significant one is padded with zeros. */
+        for (int i = 0; i < DECIMAL_DIGITS && (length > 0 || chunk != 0); i++) {
+            *--p = '0' + chunk % 10;
+            chunk /= 10;
+        }
+    }
+    if (op.negative) {
+        *--p = '-';
+    }
+
+    sink_puts(sink, p);
+    free(limbs);
+    free(digits);
+}
+
+//// HELPER FUNCTIONS ////
+
+/*!
+ * Returns the nearest double to an integer or bigint. Only the top three
+ * limbs are used, which is more than enough for 53 bits of precision;
+ * bigints too large for a double give infinity.
+ */
+double bigint_to_double(value_t *obj) {
+    operand_t op;
+    operand_init(&op, obj);
+
+    size_t low = op.length > 3 ? op.length - 3 : 0;
+    double value = 0.0;
+    for (size_t i = op.length; i-- > low; ) {
+        value = value * 18446744073709551616.0 + (double) op.limbs[i];
+    }
+    value = ldexp(value, 64 * low);
+    return op.negative ? -value : value;
+}
+
+/*!
+ * Returns a new reference to the integer equal to a finite, integral double,
+ * or NULL_REF on error. This is a bigint if it doesn't fit in 64 bits.
+ */
+reference_t bigint_from_double(double value) {
+    assert(isfinite(value) && trunc(value) == value);
+    if (value >= -9223372036854775808.0 && value < 9223372036854775808.0) {
+        return make_reference_int((int64_t) value);
+    }
+
+    /* Here |value| >= 2^63, so its 53-bit mantissa is shifted left by at
+     * least 10 bits. */
+    int exponent;
+    double fraction = frexp(fabs(value), &exponent);
+    uint64_t mantissa = (uint64_t) ldexp(fraction, 64);
+    size_t shift = exponent - 64;
+    size_t word = shift / 64;
+    size_t bit = shift % 64;
+
+    uint64_t *limbs;
+    reference_t ref = bigint_alloc(word + 2, &limbs);
+    if (ref == NULL_REF) {
+        return NULL_REF;
+    }
+    memset(limbs, 0, (word + 2) * sizeof(uint64_t));
+    limbs[word] = mantissa << bit;
+    limbs[word + 1] = bit != 0 ? mantissa >> (64 - bit) : 0;
+    return bigint_normalize(ref, value < 0);
+}
@@ -0,0 +1,35 @@
+#ifndef EVAL_BIGINT_H
+#define EVAL_BIGINT_H
+
+#include <stdbool.h>
+
+#include "format.h"
+#include "types.h"
+
+/*
+ * Every function here takes integers as well as bigints as operands, so that
+ * integer arithmetic can hand an operation over to them when it overflows.
+ * Results are normalized: any result that fits in 64 bits is an integer.
+ */
+
+// TYPE INTERFACE FUNCTIONS //
+
+bool bigint_bool(value_t *obj);
+uint64_t bigint_hash(value_t *obj);
+int bigint_cmp(value_t *l, value_t *r);
+bool bigint_eq(value_t *l, value_t *r);
+reference_t bigint_unaryop_negate(value_t *l, value_t *r);
+reference_t bigint_unaryop_identity(value_t *l, value_t *r);
+reference_t bigint_binop_add(value_t *l, value_t *r);
+reference_t bigint_binop_subtract(value_t *l, value_t *r);
+reference_t bigint_binop_multiply(value_t *l, value_t *r);
+reference_t bigint_binop_divide(value_t *l, value_t *r);
+reference_t bigint_binop_modulo(value_t *l, value_t *r);
+void bigint_print(value_t *obj, sink_t *sink, size_t depth);
+
+// HELPER FUNCTIONS //
+
+double bigint_to_double(value_t *obj);
+reference_t bigint_from_double(double value);
+
+#endif /* EVAL_BIGINT_H */
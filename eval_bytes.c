@@ -0,0 +1,421 @@
+#include "eval_bytes.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "eval_refs.h"
+#include "eval_types.h"
+#include "exception.h"
+#include "refs.h"
+
+/*! The smallest buffer a bytearray allocates when it grows. */
+#define INITIAL_BYTEARRAY_CAPACITY 16
+
+static inline bytes_value_t *bytes_coerce(value_t *obj) {
+    assert(obj->type == VAL_BYTES || obj->type == VAL_BYTEARRAY);
+    return (bytes_value_t *) obj;
+}
+
+/*! Returns a pointer to the first byte of a bytes or bytearray value. */
+static inline uint8_t *bytes_data(bytes_value_t *bytes) {
+    static uint8_t empty[1];
+    if (bytes->buffer == NULL_REF) {
+        return empty;
+    }
+
+    value_t *obj = deref(bytes->buffer);
+    assert(obj->type == VAL_BYTE_BUFFER);
+    return ((byte_buffer_value_t *) obj)->data + bytes->start;
+}
+
+/*!
+ * Returns the value of an integer that is to be stored as a byte. Sets an
+ * exception and returns -1 if it isn't an integer in the range 0-255.
+ */
+static int coerce_byte(reference_t ref) {
+    value_t *obj = deref(ref);
+    if (obj->type != VAL_INTEGER) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "'%s' object cannot be interpreted as an integer", type_to_str(obj->type));
+        return -1;
+    }
+
+    int64_t value = ((integer_value_t *) obj)->integer_value;
+    if (value < 0 || value > 255) {
+        exception_set(EXC_VALUE_ERROR, "byte must be in range(0, 256)");
+        return -1;
+    }
+    return value;
+}
+
+/*!
+ * Returns a new reference to a bytes or bytearray value holding a copy of
+ * length bytes of data, or NULL_REF on error.
+ */
+static reference_t bytes_copy_of(value_type_t type, const uint8_t *data, size_t length) {
+    reference_t ref = make_reference_bytes(type);
+    if (ref == NULL_REF || length == 0) {
+        return ref;
+    }
+
+    reference_t buffer = make_reference_byte_buffer(length);
+    if (buffer == NULL_REF) {
+        decref(ref);
+        return NULL_REF;
+    }
+    memcpy(((byte_buffer_value_t *) deref(buffer))->data, data, length);
+
+    bytes_value_t *bytes = (bytes_value_t *) deref(ref);
+    bytes->buffer = buffer;
+    bytes->length = length;
+    return ref;
+}
+
+/*!
+ * Returns a new reference to a bytes or bytearray value holding length bytes
+ * of another value from start, or NULL_REF on error. The new value shares the
+ * other value's buffer instead of copying it.
+ */
+static reference_t bytes_view(value_type_t type, bytes_value_t *bytes, int64_t start,
+        int64_t length) {
+    reference_t ref = make_reference_bytes(type);
+    if (ref == NULL_REF || length == 0) {
+        return ref;
+    }
+
+    bytes_value_t *view = (bytes_value_t *) deref(ref);
+    incref(bytes->buffer);
+    view->buffer = bytes->buffer;
+    view->start = bytes->start + start;
+    view->length = length;
+    return ref;
+}
+
+/*!
+ * Prepares a bytearray to be modified in place, with room for capacity bytes
+ * in all. If its buffer is shared with another value or too small, the
+ * contents are moved to a new buffer of its own first. Returns false if the
+ * new buffer could not be allocated.
+ */
+static bool bytearray_reserve(bytes_value_t *bytes, size_t capacity) {
+    assert(bytes->base.type == VAL_BYTEARRAY);
+
+    if (bytes->buffer != NULL_REF) {
+        byte_buffer_value_t *buffer = (byte_buffer_value_t *) deref(bytes->buffer);
+        if (buffer->base.ref_count == 1 && bytes->start + capacity <= buffer->capacity) {
+            return true;
+        }
+    }
+
+    /* Grow geometrically, so that appending takes amortized constant time. */
+    size_t new_capacity = 2 * bytes->length;
+    if (new_capacity < capacity) {
+        new_capacity = capacity;
+    }
+    if (new_capacity < INITIAL_BYTEARRAY_CAPACITY) {
+        new_capacity = INITIAL_BYTEARRAY_CAPACITY;
+    }
+
+    reference_t ref = make_reference_byte_buffer(new_capacity);
+    if (ref == NULL_REF) {
+        return false;
+    }
+    memcpy(((byte_buffer_value_t *) deref(ref))->data, bytes_data(bytes), bytes->length);
+
+    decref(bytes->buffer);
+    bytes->buffer = ref;
+    bytes->start = 0;
+    return true;
+}
+
+//// TYPE INTERFACE FUNCTIONS ////
+
+bool bytes_bool(value_t *obj) {
+    return bytes_len(obj) > 0;
+}
+
+int64_t bytes_len(value_t *obj) {
+    return bytes_coerce(obj)->length;
+}
+
+/*!
+ * Implements hashing of bytes. This is only in the table for bytes, since a
+ * bytearray's hash could change.
+ */
+uint64_t bytes_hash(value_t *obj) {
+    bytes_value_t *bytes = bytes_coerce(obj);
+    return hash_bytes((const char *) bytes_data(bytes), bytes->length);
+}
+
+int bytes_cmp(value_t *l, value_t *r) {
+    bytes_value_t *lbytes = bytes_coerce(l);
+    bytes_value_t *rbytes = bytes_coerce(r);
+    int64_t min_length = lbytes->length < rbytes->length ? lbytes->length : rbytes->length;
+
+    int result = memcmp(bytes_data(lbytes), bytes_data(rbytes), min_length);
+    if (result != 0) {
+        return (result > 0) - (result < 0);
+    }
+    return (lbytes->length > rbytes->length) - (lbytes->length < rbytes->length);
+}
+
+bool bytes_eq(value_t *l, value_t *r) {
+    bytes_value_t *lbytes = bytes_coerce(l);
+    bytes_value_t *rbytes = bytes_coerce(r);
+
+    return lbytes->length == rbytes->length &&
+            memcmp(bytes_data(lbytes), bytes_data(rbytes), lbytes->length) == 0;
+}
+
+/*!
+ * Bytes contain the integers that are among their bytes, and the bytes and
+ * bytearrays that are substrings of them.
+ */
+bool bytes_contains(value_t *obj, reference_t item) {
+    bytes_value_t *bytes = bytes_coerce(obj);
+    value_t *needle = deref(item);
+
+    if (needle->type == VAL_INTEGER) {
+        int byte = coerce_byte(item);
+        return byte >= 0 && memchr(bytes_data(bytes), byte, bytes->length) != NULL;
+    }
+
+    if (needle->type != VAL_BYTES && needle->type != VAL_BYTEARRAY) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "a bytes-like object is required, not '%s'", type_to_str(needle->type));
+        return false;
+    }
+
+    bytes_value_t *sub = bytes_coerce(needle);
+    const uint8_t *data = bytes_data(bytes);
+    const uint8_t *sub_data = bytes_data(sub);
+    for (int64_t i = 0; i + sub->length <= bytes->length; i++) {
+        if (memcmp(data + i, sub_data, sub->length) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*!
+ * Turns a subscript into an index into a bytes value, counting from the end
+ * if it is negative. Sets an exception and returns -1 if it is not valid.
+ */
+static int64_t bytes_coerce_subscript(bytes_value_t *bytes, reference_t subscr) {
+    value_t *obj = deref(subscr);
+    if (obj->type != VAL_INTEGER) {
+        exception_set(EXC_TYPE_ERROR, "byte indices must be integers");
+        return -1;
+    }
+
+    int64_t idx = ((integer_value_t *) obj)->integer_value;
+    if (idx < 0) {
+        idx += bytes->length;
+    }
+    if (idx < 0 || idx >= bytes->length) {
+        exception_set(EXC_INDEX_ERROR, "index out of range");
+        return -1;
+    }
+    return idx;
+}
+
+/*! Implements subscript access for bytes, which gives the byte as an int. */
+reference_t bytes_subscr_get(value_t *obj, reference_t subscr) {
+    bytes_value_t *bytes = bytes_coerce(obj);
+
+    int64_t idx = bytes_coerce_subscript(bytes, subscr);
+    if (idx < 0) {
+        return NULL_REF;
+    }
+    return make_reference_int(bytes_data(bytes)[idx]);
+}
+
+/*! Implements subscript assignment for bytearrays. */
+void bytearray_subscr_set(value_t *obj, reference_t subscr, reference_t value) {
+    bytes_value_t *bytes = bytes_coerce(obj);
+
+    int64_t idx = bytes_coerce_subscript(bytes, subscr);
+    if (idx < 0) {
+        return;
+    }
+    int byte = coerce_byte(value);
+    if (byte < 0 || !bytearray_reserve(bytes, bytes->length)) {
+        return;
+    }
+
+    bytes_data(bytes)[idx] = byte;
+}
+
+/*! Concatenates two bytes, or two bytearrays, into a new value. */
+reference_t bytes_binop_add(value_t *l, value_t *r) {
+    bytes_value_t *lbytes = bytes_coerce(l);
+    bytes_value_t *rbytes = bytes_coerce(r);
+    size_t length = lbytes->length + rbytes->length;
+
+    reference_t ref = make_reference_bytes(l->type);
+    if (ref == NULL_REF || length == 0) {
+        return ref;
+    }
+
+    reference_t buffer = make_reference_byte_buffer(length);
+    if (buffer == NULL_REF) {
+        decref(ref);
+        return NULL_REF;
+    }
+
+    uint8_t *data = ((byte_buffer_value_t *) deref(buffer))->data;
+    memcpy(data, bytes_data(lbytes), lbytes->length);
+    memcpy(data + lbytes->length, bytes_data(rbytes), rbytes->length);
+
+    bytes_value_t *result = (bytes_value_t *) deref(ref);
+    result->buffer = buffer;
+    result->length = length;
+    return ref;
+}
+
+/*!
+ * Implements printing of bytes, with any byte that isn't printable ASCII
+ * written as a hex escape.
+ */
+void bytes_print(value_t *obj, sink_t *sink, size_t depth) {
+    /* If we have reached the maximum recursion depth, print a placeholder. */
+    if (depth == 0) {
+        sink_puts(sink, "...");
+        return;
+    }
+
+    bytes_value_t *bytes = bytes_coerce(obj);
+    const uint8_t *data = bytes_data(bytes);
+
+    if (obj->type == VAL_BYTEARRAY) {
+        sink_puts(sink, "bytearray(");
+    }
+    sink_puts(sink, "b\"");
+    for (int64_t i = 0; i < bytes->length; i++) {
+        uint8_t byte = data[i];
+        if (byte == '"' || byte == '\\') {
+            sink_putc(sink, '\\');
+            sink_putc(sink, byte);
+        } else if (byte >= ' ' && byte < 0x7f) {
+            sink_putc(sink, byte);
+        } else {
+            char escape[5];
+            snprintf(escape, sizeof(escape), "\\x%02x", byte);
+            sink_puts(sink, escape);
+        }
+    }
+    sink_putc(sink, '"');
+    if (obj->type == VAL_BYTEARRAY) {
+        sink_putc(sink, ')');
+    }
+}
+
+//// HELPER FUNCTIONS ////
+
+/*!
+ * Returns a new reference to a bytes or bytearray value made from source, or
+ * NULL_REF on error. source may be:
+ *  - a string, whose characters are copied
+ *  - an integer n, giving n zero bytes
+ *  - a list of integers in the range 0-255
+ *  - bytes or a bytearray, whose buffer is shared rather than copied
+ */
+reference_t bytes_from(value_type_t type, reference_t source) {
+    value_t *obj = deref(source);
+
+    switch (obj->type) {
+        case VAL_STRING: {
+            string_value_t *str = (string_value_t *) obj;
+            return bytes_copy_of(type, (const uint8_t *) str->string_value,
+                    string_length(str));
+        }
+
+        case VAL_INTEGER: {
+            int64_t length = ((integer_value_t *) obj)->integer_value;
+            if (length < 0) {
+                exception_set(EXC_VALUE_ERROR, "negative count");
+                return NULL_REF;
+            }
+
+            reference_t ref = make_reference_bytes(type);
+            if (ref == NULL_REF || length == 0) {
+                return ref;
+            }
+
+            bytes_value_t *bytes = (bytes_value_t *) deref(ref);
+            bytes->buffer = make_reference_byte_buffer(length);
+            if (bytes->buffer == NULL_REF) {
+                decref(ref);
+                return NULL_REF;
+            }
+            bytes->length = length;
+            memset(bytes_data(bytes), 0, length);
+            return ref;
+        }
+
+        case VAL_LIST: {
+            list_value_t *list = (list_value_t *) obj;
+            ref_array_value_t *elements = (ref_array_value_t *) deref(list->values);
+            uint8_t data[list->size > 0 ? list->size : 1];
+            for (int64_t i = 0; i < list->size; i++) {
+                int byte = coerce_byte(elements->values[i]);
+                if (byte < 0) {
+                    return NULL_REF;
+                }
+                data[i] = byte;
+            }
+            return bytes_copy_of(type, data, list->size);
+        }
+
+        case VAL_BYTES:
+        case VAL_BYTEARRAY: {
+            bytes_value_t *bytes = bytes_coerce(obj);
+            return bytes_view(type, bytes, 0, bytes->length);
+        }
+
+        default:
+            exception_set_format(EXC_TYPE_ERROR,
+                    "cannot convert '%s' object to %s",
+                    type_to_str(obj->type), type_to_str(type));
+            return NULL_REF;
+    }
+}
+
+/*!
+ * Returns a new reference to a value of the same type holding the bytes from
+ * start up to end, or NULL_REF on error. Like Python, negative positions count
+ * from the end and positions out of range are clamped. The result shares the
+ * buffer of obj instead of copying it.
+ */
+reference_t bytes_slice(value_t *obj, int64_t start, int64_t end) {
+    bytes_value_t *bytes = bytes_coerce(obj);
+
+    if (start < 0) {
+        start = start + bytes->length < 0 ? 0 : start + bytes->length;
+    }
+    if (end < 0) {
+        end = end + bytes->length < 0 ? 0 : end + bytes->length;
+    }
+    if (start > bytes->length) {
+        start = bytes->length;
+    }
+    if (end > bytes->length) {
+        end = bytes->length;
+    }
+
+    return bytes_view(obj->type, bytes, start, end > start ? end - start : 0);
+}
+
+/*! Appends an integer in the range 0-255 to the end of a bytearray. */
+void bytearray_append(value_t *obj, reference_t item) {
+    bytes_value_t *bytes = bytes_coerce(obj);
+    assert(obj->type == VAL_BYTEARRAY);
+
+    int byte = coerce_byte(item);
+    if (byte < 0 || !bytearray_reserve(bytes, bytes->length + 1)) {
+        return;
+    }
+
+    bytes_data(bytes)[bytes->length] = byte;
+    bytes->length++;
+}
@@ -0,0 +1,28 @@
+#ifndef EVAL_BYTES_H
+#define EVAL_BYTES_H
+
+#include <stdbool.h>
+
+#include "format.h"
+#include "types.h"
+
+// TYPE INTERFACE FUNCTIONS //
+
+bool bytes_bool(value_t *obj);
+int64_t bytes_len(value_t *obj);
+uint64_t bytes_hash(value_t *obj);
+int bytes_cmp(value_t *l, value_t *r);
+bool bytes_eq(value_t *l, value_t *r);
+bool bytes_contains(value_t *obj, reference_t item);
+reference_t bytes_subscr_get(value_t *obj, reference_t subscr);
+void bytearray_subscr_set(value_t *obj, reference_t subscr, reference_t value);
+reference_t bytes_binop_add(value_t *l, value_t *r);
+void bytes_print(value_t *obj, sink_t *sink, size_t depth);
+
+// HELPER FUNCTIONS //
+
+reference_t bytes_from(value_type_t type, reference_t source);
+reference_t bytes_slice(value_t *obj, int64_t start, int64_t end);
+void bytearray_append(value_t *obj, reference_t item);
+
+#endif /* EVAL_BYTES_H */
@@ -1,16 +1,41 @@
 #include "eval_dict.h"
 
 #include <assert.h>
+#include <string.h>
 #include "eval_refs.h"
 #include "eval_types.h"
 #include "exception.h"
 #include "refs.h"
 
+/*!
+ * The largest number of different keys that may be added to dicts of one
+ * shape. Dicts that are used as maps with many distinct string keys would
+ * otherwise grow the shape tree without bound.
+ */
+#define MAX_SHAPE_TRANSITIONS 32
+
+/*! The initial capacity of a dict's hash table. Must be a power of two. */
+#define INITIAL_TABLE_CAPACITY 8
+
+/*!
+ * Hash tables grow once they are this full. Robin Hood probing keeps probe
+ * sequences short well past the half-full point linear probing needs.
+ */
+#define MAX_LOAD_NUMERATOR 3
+#define MAX_LOAD_DENOMINATOR 4
+
+/*! The initial capacity of a shaped dict's value array. */
+#define INITIAL_SHAPED_CAPACITY 4
+
 static inline dict_value_t *dict_coerce(value_t *obj) {
     assert(obj->type == VAL_DICT);
     return (dict_value_t *) obj;
 }
 
+static inline bool dict_is_shaped(dict_value_t *dict) {
+    return dict->keys == NULL_REF;
+}
+
 static inline ref_array_value_t *dict_keyarray(dict_value_t *dict) {
     value_t *obj = deref(dict->keys);
     assert(obj->type == VAL_REF_ARRAY);
@@ -22,35 +47,220 @@ static inline ref_array_value_t *dict_valuearray(dict_value_t *dict) {
     return (ref_array_value_t *) obj;
 }
 
-static int64_t keys_find(ref_array_value_t *keys, uint64_t hash, reference_t subscr, bool skip_tombstones) {
-    int64_t capacity = keys->capacity;
-    int64_t bucket = hash % capacity;
+/*!
+ * Gives a dict its own key and value arrays if it shares them with a copy, so
+ * that they can be modified in place. Returns false if they couldn't be
+ * allocated.
+ */
+static inline bool dict_unshare(dict_value_t *dict) {
+    return unshare_refarray(&dict->keys) && unshare_refarray(&dict->values);
+}
 
-    for (int64_t idx = 0; idx < capacity; idx++) {
-        int64_t current = bucket + idx;
-        if (current > capacity) {
-            current -= capacity;
+/*! Returns the string contents of a key, or NULL if it is not a string. */
+static inline const char *key_name(reference_t key) {
+    value_t *obj = deref(key);
+    return obj->type == VAL_STRING ? ((string_value_t *) obj)->string_value : NULL;
+}
+
+//// HASH TABLE REPRESENTATION ////
+
+/*
+ * Hash table dicts, and sets, use Robin Hood linear probing. Every key sits
+ * at or after its home bucket, the hash masked to the table's capacity, and
+ * an insert that finds a key closer to its home than the new key is to its
+ * own takes that slot and moves the other key on. Probe lengths stay short
+ * and even, and a lookup can stop as soon as it passes a key closer to home
+ * than the key being searched for. Deletion shifts the following keys back a
+ * slot rather than leaving a tombstone.
+ *
+ * The keys are a key array, which stores each key's hash next to it, so
+ * probing never has to hash the keys it passes again, and a lookup only
+ * compares keys whose hashes match. Only the low 32 bits are kept: that is
+ * all a home bucket uses, and it keeps tables small.
+ */
+
+/*! Returns the hashes stored after the references of a key array. */
+static inline uint32_t *keys_hashes(ref_array_value_t *keys) {
+    return (uint32_t *) &keys->values[keys->capacity];
+}
+
+/*!
+ * Returns the stored hash of the key in an occupied slot. This is only the
+ * low 32 bits of its hash, which is enough to insert or look it up in any
+ * table.
+ */
+uint64_t keys_hash(ref_array_value_t *keys, uint64_t idx) {
+    assert(keys->values[idx] != NULL_REF);
+    return keys_hashes(keys)[idx];
+}
+
+/*! Returns how far the key in a slot is from its home bucket. */
+static inline uint64_t key_distance(ref_array_value_t *keys, uint64_t idx) {
+    uint64_t mask = keys->capacity - 1;
+    return (idx - keys_hashes(keys)[idx]) & mask;
+}
+
+/*!
+ * Returns the slot holding a key with the given hash that is equal to subscr,
+ * or -1 if the table doesn't contain it.
+ */
+int64_t keys_find(ref_array_value_t *keys, uint64_t hash, reference_t subscr) {
+    uint64_t mask = keys->capacity - 1;
+
+    for (uint64_t distance = 0; distance <= mask; distance++) {
+        uint64_t idx = (hash + distance) & mask;
+        reference_t key = keys->values[idx];
+        if (key == NULL_REF) {
+            return -1;
         }
+        if (keys_hashes(keys)[idx] == (uint32_t) hash && ref_eq(subscr, key)) {
+            return idx;
+        }
+        if (key_distance(keys, idx) < distance) {
+            return -1;
+        }
+    }
 
-        reference_t key = keys->values[current];
-        if (skip_tombstones && key == TOMBSTONE_REF) {
-            continue;
+    return -1;
+}
+
+/*!
+ * Like keys_find, but looks for a string key given its contents rather than
+ * a reference. Returns the index of the key, or -1 if it is not present.
+ */
+static int64_t keys_find_name(ref_array_value_t *keys, const char *name) {
+    uint64_t mask = keys->capacity - 1;
+    uint64_t hash = hash_string(name);
+
+    for (uint64_t distance = 0; distance <= mask; distance++) {
+        uint64_t idx = (hash + distance) & mask;
+        reference_t key = keys->values[idx];
+        if (key == NULL_REF) {
+            return -1;
+        }
+
+        const char *current_name = key_name(key);
+        if (keys_hashes(keys)[idx] == (uint32_t) hash && current_name != NULL &&
+                strcmp(current_name, name) == 0) {
+            return idx;
         }
-        if (key == NULL_REF || key == TOMBSTONE_REF || ref_eq(subscr, key)) {
-            return current;
+        if (key_distance(keys, idx) < distance) {
+            return -1;
         }
     }
 
     return -1;
 }
 
+/*!
+ * Inserts a key that is not already in the table, along with its hash and
+ * value. The references are moved into the table rather than incref'd. The
+ * table must have at least one empty slot. values is NULL for keys-only tables.
+ */
+void keys_insert(ref_array_value_t *keys, ref_array_value_t *values,
+        uint64_t hash, reference_t key, reference_t value) {
+    uint32_t *hashes = keys_hashes(keys);
+    uint64_t mask = keys->capacity - 1;
+    uint64_t idx = hash & mask;
+
+    for (uint64_t distance = 0; ; distance++, idx = (idx + 1) & mask) {
+        if (keys->values[idx] == NULL_REF) {
+            keys->values[idx] = key;
+            hashes[idx] = hash;
+            if (values != NULL) {
+                values->values[idx] = value;
+            }
+            return;
+        }
+
+        /* Take the slot from a key that is closer to its home, and carry on
+         * looking for a slot for that key instead. */
+        uint64_t current_distance = key_distance(keys, idx);
+        if (current_distance < distance) {
+            reference_t displaced_key = keys->values[idx];
+            keys->values[idx] = key;
+            key = displaced_key;
+            uint32_t displaced_hash = hashes[idx];
+            hashes[idx] = hash;
+            hash = displaced_hash;
+            if (values != NULL) {
+                reference_t displaced_value = values->values[idx];
+                values->values[idx] = value;
+                value = displaced_value;
+            }
+            distance = current_distance;
+        }
+    }
+}
+
+/*!
+ * Empties a slot, shifting back the keys after it that aren't in their home
+ * bucket so that no lookup stops early at the gap. The references in the slot
+ * must already have been released. values is NULL for keys-only tables.
+ */
+void keys_remove(ref_array_value_t *keys, ref_array_value_t *values, uint64_t idx) {
+    uint64_t mask = keys->capacity - 1;
+
+    while (true) {
+        uint64_t next = (idx + 1) & mask;
+        if (keys->values[next] == NULL_REF || key_distance(keys, next) == 0) {
+            break;
+        }
+
+        keys->values[idx] = keys->values[next];
+        keys_hashes(keys)[idx] = keys_hashes(keys)[next];
+        if (values != NULL) {
+            values->values[idx] = values->values[next];
+        }
+        idx = next;
+    }
+
+    keys->values[idx] = NULL_REF;
+    if (values != NULL) {
+        values->values[idx] = NULL_REF;
+    }
+}
+
+/*! Returns the table capacity needed to hold size keys under the maximum load. */
+size_t table_capacity(size_t size) {
+    size_t capacity = INITIAL_TABLE_CAPACITY;
+    while (size * MAX_LOAD_DENOMINATOR >= capacity * MAX_LOAD_NUMERATOR) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+/*!
+ * Gives a dict empty key and value arrays of the given capacity, switching it
+ * to the hash table representation. Any previous arrays are not released.
+ * Returns false if the arrays could not be allocated.
+ */
+static bool dict_init_table(dict_value_t *dict, size_t capacity) {
+    assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+
+    reference_t ref_keys = make_reference_keyarray(capacity);
+    if (exception_occurred()) {
+        return false;
+    }
+    reference_t ref_values = make_reference_refarray(capacity);
+    if (exception_occurred()) {
+        decref(ref_keys);
+        return false;
+    }
+
+    dict->keys = ref_keys;
+    dict->values = ref_values;
+    dict->size = 0;
+    return true;
+}
+
 static void dict_upsize(dict_value_t *dict) {
     ref_array_value_t *keys = dict_keyarray(dict);
     ref_array_value_t *values = dict_valuearray(dict);
     int64_t capacity = keys->capacity;
 
     int64_t new_capacity = capacity * 2;
-    reference_t ref_keys = make_reference_refarray(new_capacity);
+    reference_t ref_keys = make_reference_keyarray(new_capacity);
     if (exception_occurred()) {
         return;
     }
@@ -64,24 +274,15 @@ static void dict_upsize(dict_value_t *dict) {
     ref_array_value_t *new_values = (ref_array_value_t *) deref(ref_values);
 
     for (int64_t idx = 0; idx < capacity; idx++) {
-        if (keys->values[idx] != TOMBSTONE_REF && keys->values[idx] != NULL_REF) {
-            reference_t key = keys->values[idx];
+        reference_t key = keys->values[idx];
+        if (key != NULL_REF) {
             reference_t value = values->values[idx];
 
-            uint64_t hash = ref_hash(key);
-            if (exception_occurred()) {
-                decref(ref_keys);
-                decref(ref_values);
-                return;
-            }
-            int64_t idx = keys_find(new_keys, hash, key, false);
-
             /* Increment the counts for the key and value because the new
              * reference arrays now refer to them. */
             incref(key);
             incref(value);
-            new_keys->values[idx] = key;
-            new_values->values[idx] = value;
+            keys_insert(new_keys, new_values, keys_hash(keys, idx), key, value);
         }
     }
 
@@ -90,18 +291,113 @@ static void dict_upsize(dict_value_t *dict) {
     decref(dict->values);
     dict->keys = ref_keys;
     dict->values = ref_values;
+}
 
-    /* This process removes all tombstones, so the number of occupied slots
-     * become equal to the number of elements in the dictionary. */
-    dict->occupied = dict->size;
+//// SHAPED REPRESENTATION ////
+
+/*!
+ * Returns the shape a shaped dict should move to when key is added, or NULL
+ * if the dict should switch to the hash table instead. Sets an exception and
+ * returns NULL if a new shape could not be allocated.
+ */
+static shape_t *dict_shape_transition(dict_value_t *dict, const char *key) {
+    shape_t *shape = dict->shape;
+    if (shape->num_keys >= DICT_MAX_SHAPED_KEYS) {
+        return NULL;
+    }
+    return dict_shape_add_key(shape, key);
 }
-static void dict_maybe_upsize(dict_value_t *dict) {
-    int64_t capacity = dict_keyarray(dict)->capacity;
-    if (dict->occupied * 2 >= capacity) {
-        dict_upsize(dict);
+
+/*!
+ * Switches a shaped dict to the hash table representation. This allocates a
+ * string value for every key, so it can fail; in that case the dict is left
+ * unchanged and false is returned.
+ */
+static bool dict_unshape(dict_value_t *dict) {
+    assert(dict_is_shaped(dict));
+    shape_t *shape = dict->shape;
+    int64_t size = dict->size;
+    reference_t old_values = dict->values;
+
+    if (!dict_init_table(dict, table_capacity(size))) {
+        return false;
     }
+    ref_array_value_t *keys = dict_keyarray(dict);
+    ref_array_value_t *values = dict_valuearray(dict);
+
+    for (int64_t slot = 0; slot < size; slot++) {
+        reference_t key = make_reference_string(shape->keys[slot]);
+        if (exception_occurred()) {
+            /* Put the shaped representation back. */
+            decref(dict->keys);
+            decref(dict->values);
+            dict->keys = NULL_REF;
+            dict->values = old_values;
+            dict->size = size;
+            dict->shape = shape;
+            return false;
+        }
+
+        reference_t value = ((ref_array_value_t *) deref(old_values))->values[slot];
+        incref(value);
+        keys_insert(keys, values, ref_hash(key), key, value);
+    }
+
+    decref(old_values);
+    dict->size = size;
+    return true;
 }
 
+/*!
+ * Adds a new key to a shaped dict, moving it to the given shape.
+ * The value array is grown if it is full.
+ */
+static void dict_shaped_append(dict_value_t *dict, shape_t *next, reference_t value) {
+    size_t capacity = dict->values == NULL_REF ? 0 : dict_valuearray(dict)->capacity;
+
+    if ((size_t) dict->size == capacity) {
+        size_t new_capacity = capacity == 0 ? INITIAL_SHAPED_CAPACITY : capacity * 2;
+        reference_t ref_values = make_reference_refarray(new_capacity);
+        if (exception_occurred()) {
+            return;
+        }
+
+        /* Move the existing values over. Clearing the old slots transfers
+         * ownership, so no counts need to change. */
+        if (dict->values != NULL_REF) {
+            ref_array_value_t *old_values = dict_valuearray(dict);
+            ref_array_value_t *new_values = (ref_array_value_t *) deref(ref_values);
+            for (int64_t slot = 0; slot < dict->size; slot++) {
+                new_values->values[slot] = old_values->values[slot];
+                old_values->values[slot] = NULL_REF;
+            }
+            decref(dict->values);
+        }
+        dict->values = ref_values;
+    }
+
+    incref(value);
+    dict_valuearray(dict)->values[dict->size] = value;
+    dict->shape = next;
+    dict->size++;
+}
+
+/*!
+ * Returns a borrowed reference to the value stored for a string key,
+ * or NULL_REF if the dict doesn't contain the key.
+ */
+static reference_t dict_lookup_name(dict_value_t *dict, const char *name) {
+    if (dict_is_shaped(dict)) {
+        int64_t slot = shape_find(dict->shape, name);
+        return slot >= 0 ? dict_valuearray(dict)->values[slot] : NULL_REF;
+    } else {
+        int64_t idx = keys_find_name(dict_keyarray(dict), name);
+        return idx >= 0 ? dict_valuearray(dict)->values[idx] : NULL_REF;
+    }
+}
+
+//// TYPE INTERFACE FUNCTIONS ////
+
 bool dict_bool(value_t *obj) {
     return dict_len(obj) > 0;
 }
@@ -111,28 +407,59 @@ int64_t dict_len(value_t *obj) {
 }
 
 reference_t dict_subscr_get(value_t *obj, reference_t subscr) {
-    dict_value_t *dict = dict_coerce(obj);
-    ref_array_value_t *keys = dict_keyarray(dict);
-    ref_array_value_t *values = dict_valuearray(dict);
-
-    uint64_t hash = ref_hash(subscr);
-    if (exception_occurred()) {
+    reference_t value = dict_subscr_peek(obj, subscr);
+    if (value == NULL_REF) {
+        if (!exception_occurred()) {
+            exception_set(EXC_KEY_ERROR, "no value found for key in dictionary");
+        }
         return NULL_REF;
     }
 
-    int64_t idx = keys_find(keys, hash, subscr, true);
+    incref(value);
+    return value;
+}
 
-    if (idx >= 0 && keys->values[idx] != NULL_REF) {
-        incref(values->values[idx]);
-        return values->values[idx];
-    } else {
-        exception_set(EXC_KEY_ERROR, "no value found for key in dictionary");
-        return NULL_REF;
-    }
+/*! Implements membership tests for dicts, which test the keys. */
+bool dict_contains(value_t *obj, reference_t item) {
+    return dict_subscr_peek(obj, item) != NULL_REF;
 }
 
 void dict_subscr_set(value_t *obj, reference_t subscr, reference_t value) {
     dict_value_t *dict = dict_coerce(obj);
+    if (!dict_unshare(dict)) {
+        return;
+    }
+
+    if (dict_is_shaped(dict)) {
+        const char *name = key_name(subscr);
+        if (name != NULL) {
+            /* Overwrite an existing field in place. */
+            int64_t slot = shape_find(dict->shape, name);
+            if (slot >= 0) {
+                ref_array_value_t *values = dict_valuearray(dict);
+                incref(value);
+                decref(values->values[slot]);
+                values->values[slot] = value;
+                return;
+            }
+
+            /* Otherwise, move along the shape tree if we can. */
+            shape_t *next = dict_shape_transition(dict, name);
+            if (exception_occurred()) {
+                return;
+            }
+            if (next != NULL) {
+                dict_shaped_append(dict, next, value);
+                return;
+            }
+        }
+
+        /* Non-string keys and oversized dicts need the hash table. */
+        if (!dict_unshape(dict)) {
+            return;
+        }
+    }
+
     ref_array_value_t *keys = dict_keyarray(dict);
     ref_array_value_t *values = dict_valuearray(dict);
 
@@ -142,8 +469,8 @@ void dict_subscr_set(value_t *obj, reference_t subscr, reference_t value) {
     }
 
     /* Look for an existing entry with this key. */
-    int64_t idx = keys_find(keys, hash, subscr, true);
-    if (idx >= 0 && keys->values[idx] != NULL_REF) {
+    int64_t idx = keys_find(keys, hash, subscr);
+    if (idx >= 0) {
         /* If the keys match, just overwrite the value. */
         decref(values->values[idx]);
         incref(value);
@@ -151,30 +478,45 @@ void dict_subscr_set(value_t *obj, reference_t subscr, reference_t value) {
         return;
     }
 
-    /* Otherwise, look for a new slot to set. */
-    idx = keys_find(keys, hash, subscr, false);
-    if (idx >= 0) {
-        assert(keys->values[idx] == NULL_REF || keys->values[idx] == TOMBSTONE_REF);
-        dict->size++;
-        if (keys->values[idx] == NULL_REF) {
-            dict->occupied++;
-        }
-
-        keys->values[idx] = subscr;
-        values->values[idx] = value;
-
-        incref(subscr);
-        incref(value);
-
-        dict_maybe_upsize(dict);
-    } else {
+    /* Otherwise, grow the table first if the new key would take it past its
+     * maximum load, so that there is always an empty slot to probe to. */
+    if ((size_t) (dict->size + 1) * MAX_LOAD_DENOMINATOR >= keys->capacity * MAX_LOAD_NUMERATOR) {
         dict_upsize(dict);
-        dict_subscr_set(obj, subscr, value);
+        if (exception_occurred()) {
+            return;
+        }
+        keys = dict_keyarray(dict);
+        values = dict_valuearray(dict);
     }
+
+    incref(subscr);
+    incref(value);
+    keys_insert(keys, values, hash, subscr, value);
+    dict->size++;
 }
 
 void dict_subscr_del(value_t *obj, reference_t subscr) {
     dict_value_t *dict = dict_coerce(obj);
+    if (!dict_unshare(dict)) {
+        return;
+    }
+
+    if (dict_is_shaped(dict)) {
+        /* Shapes only ever grow, so deleting a key present in a shaped dict
+         * switches it to the hash table first. */
+        const char *name = key_name(subscr);
+        if (name == NULL || shape_find(dict->shape, name) < 0) {
+            ref_hash(subscr);
+            if (!exception_occurred()) {
+                exception_set(EXC_KEY_ERROR, "can't delete nonexistant key in dictionary");
+            }
+            return;
+        }
+        if (!dict_unshape(dict)) {
+            return;
+        }
+    }
+
     ref_array_value_t *keys = dict_keyarray(dict);
     ref_array_value_t *values = dict_valuearray(dict);
 
@@ -183,15 +525,13 @@ void dict_subscr_del(value_t *obj, reference_t subscr) {
         return;
     }
 
-    int64_t idx = keys_find(keys, hash, subscr, true);
-    if (idx >= 0 && keys->values[idx] != NULL_REF) {
+    int64_t idx = keys_find(keys, hash, subscr);
+    if (idx >= 0) {
         dict->size--;
 
         decref(keys->values[idx]);
         decref(values->values[idx]);
-
-        keys->values[idx] = TOMBSTONE_REF;
-        values->values[idx] = NULL_REF;
+        keys_remove(keys, values, idx);
     } else {
         exception_set(EXC_KEY_ERROR, "can't delete nonexistant key in dictionary");
     }
@@ -205,20 +545,46 @@ bool dict_eq(value_t *l, value_t *r) {
         return false;
     }
 
+    /* Shaped dicts iterate over their shape's keys. */
+    if (dict_is_shaped(ldict)) {
+        shape_t *shape = ldict->shape;
+        for (size_t slot = 0; slot < shape->num_keys; slot++) {
+            reference_t rvalue = dict_is_shaped(rdict) && rdict->shape == shape ?
+                dict_valuearray(rdict)->values[slot] :
+                dict_lookup_name(rdict, shape->keys[slot]);
+            bool equals = rvalue != NULL_REF &&
+                ref_eq(dict_valuearray(ldict)->values[slot], rvalue);
+            if (exception_occurred() || !equals) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     ref_array_value_t *lkeys = dict_keyarray(ldict);
     ref_array_value_t *lvalues = dict_valuearray(ldict);
-    ref_array_value_t *rkeys = dict_keyarray(rdict);
-    ref_array_value_t *rvalues = dict_valuearray(rdict);
 
     for (size_t idx = 0; idx < lkeys->capacity; idx++) {
         reference_t key = lkeys->values[idx];
-        if (key == NULL_REF || key == TOMBSTONE_REF) {
+        if (key == NULL_REF) {
             continue;
         }
 
-        int64_t ridx = keys_find(rkeys, ref_hash(key), key, true);
-        bool equals = ridx >= 0 && rkeys->values[ridx] != NULL_REF &&
-            ref_eq(lvalues->values[idx], rvalues->values[ridx]);
+        reference_t rvalue = NULL_REF;
+        if (dict_is_shaped(rdict)) {
+            const char *name = key_name(key);
+            if (name != NULL) {
+                rvalue = dict_lookup_name(rdict, name);
+            }
+        } else {
+            ref_array_value_t *rkeys = dict_keyarray(rdict);
+            int64_t ridx = keys_find(rkeys, keys_hash(lkeys, idx), key);
+            if (ridx >= 0) {
+                rvalue = dict_valuearray(rdict)->values[ridx];
+            }
+        }
+
+        bool equals = rvalue != NULL_REF && ref_eq(lvalues->values[idx], rvalue);
         if (exception_occurred() || !equals) {
             return false;
         }
@@ -227,35 +593,257 @@ bool dict_eq(value_t *l, value_t *r) {
     return true;
 }
 
-void dict_print(value_t *obj, FILE *stream, size_t depth) {
+void dict_print(value_t *obj, sink_t *sink, size_t depth) {
     /* If we have reached the maximum recursion depth, print a placeholder. */
     if (depth == 0) {
-        fprintf(stream, "...");
+        sink_puts(sink, "...");
         return;
     }
 
     /* Then make sure that we are dealing with a dictionary. */
     dict_value_t *dict = dict_coerce(obj);
+
+    /* Shaped dicts print in the order their keys were added. Keys are
+     * printed as their repr would be, placeholder included. */
+    if (dict_is_shaped(dict)) {
+        shape_t *shape = dict->shape;
+        sink_putc(sink, '{');
+        for (size_t slot = 0; slot < shape->num_keys; slot++) {
+            if (slot > 0) {
+                sink_puts(sink, ", ");
+            }
+
+            if (depth - 1 == 0) {
+                sink_puts(sink, "...");
+            } else {
+                sink_quoted(sink, shape->keys[slot]);
+            }
+            sink_puts(sink, ": ");
+            ref_write_repr(dict_valuearray(dict)->values[slot], sink, depth - 1);
+        }
+        sink_putc(sink, '}');
+        return;
+    }
+
     ref_array_value_t *keys = dict_keyarray(dict);
     ref_array_value_t *values = dict_valuearray(dict);
 
     bool comma = false;
-    fprintf(stream, "{");
+    sink_putc(sink, '{');
     for (size_t idx = 0; idx < keys->capacity; idx++) {
         reference_t key = keys->values[idx];
-        if (key == NULL_REF || key == TOMBSTONE_REF) {
+        if (key == NULL_REF) {
             continue;
         }
 
         if (comma) {
-            fprintf(stream, ", ");
+            sink_puts(sink, ", ");
         }
 
-        ref_print_repr(key, stream, depth - 1);
-        fprintf(stream, ": ");
-        ref_print_repr(values->values[idx], stream, depth - 1);
+        ref_write_repr(key, sink, depth - 1);
+        sink_puts(sink, ": ");
+        ref_write_repr(values->values[idx], sink, depth - 1);
 
         comma = true;
     }
-    fprintf(stream, "}");
+    sink_putc(sink, '}');
+}
+
+//// HELPER FUNCTIONS ////
+
+/*!
+ * Returns the shape reached by adding key to shape, or NULL if that would
+ * give the shape more than MAX_SHAPE_TRANSITIONS transitions. The key must
+ * not already be in shape. Sets an exception and returns NULL if a new shape
+ * could not be allocated.
+ */
+shape_t *dict_shape_add_key(shape_t *shape, const char *key) {
+    shape_t *next = shape_transition(shape, key);
+    if (next == NULL && shape->num_transitions < MAX_SHAPE_TRANSITIONS) {
+        next = shape_add_key(shape, key);
+    }
+    return next;
+}
+
+/*!
+ * Turns a freshly allocated dict into a shaped dict with the given shape and
+ * room for capacity values. The values must be filled in by the caller.
+ */
+bool dict_init_shaped(value_t *obj, shape_t *shape, size_t capacity) {
+    dict_value_t *dict = dict_coerce(obj);
+    assert(capacity >= shape->num_keys);
+
+    if (capacity > 0) {
+        reference_t ref_values = make_reference_refarray(capacity);
+        if (exception_occurred()) {
+            return false;
+        }
+        dict->values = ref_values;
+    }
+
+    dict->size = shape->num_keys;
+    dict->shape = shape;
+    return true;
+}
+
+/*!
+ * Turns a freshly allocated dict into an empty hash table dict with room for
+ * size keys before it has to grow.
+ */
+bool dict_init_hashed(value_t *obj, size_t size) {
+    return dict_init_table(dict_coerce(obj), table_capacity(size));
+}
+
+/*!
+ * Fills an empty dict set up by dict_init_hashed with room for size keys,
+ * hashing each key once and placing it directly. As with assigning the pairs
+ * in order, a repeated key keeps its first slot and takes its last value.
+ * The keys and values are incref'd, not stolen. Returns false and sets an
+ * exception if a key is unhashable.
+ */
+bool dict_build_hashed(value_t *obj, reference_t *keys, reference_t *values, size_t size) {
+    dict_value_t *dict = dict_coerce(obj);
+    ref_array_value_t *dict_keys = dict_keyarray(dict);
+    ref_array_value_t *dict_values = dict_valuearray(dict);
+    assert(dict->size == 0 && table_capacity(size) <= dict_keys->capacity);
+
+    for (size_t i = 0; i < size; i++) {
+        uint64_t hash = ref_hash(keys[i]);
+        if (exception_occurred()) {
+            return false;
+        }
+
+        incref(values[i]);
+        int64_t idx = keys_find(dict_keys, hash, keys[i]);
+        if (idx >= 0) {
+            decref(dict_values->values[idx]);
+            dict_values->values[idx] = values[i];
+        } else {
+            incref(keys[i]);
+            keys_insert(dict_keys, dict_values, hash, keys[i], values[i]);
+            dict->size++;
+        }
+    }
+    return true;
+}
+
+/*!
+ * Builds a new record with the same fields as a dict whose keys are all
+ * strings. A shaped dict's record shares its shape. Returns a new reference
+ * to the record, or NULL_REF on error.
+ */
+reference_t dict_to_record(value_t *obj) {
+    dict_value_t *dict = dict_coerce(obj);
+
+    /* A shaped dict already has the layout a record needs. */
+    if (dict_is_shaped(dict)) {
+        shape_t *shape = dict->shape;
+        reference_t ref = make_reference_record(shape);
+        if (ref == NULL_REF) {
+            return NULL_REF;
+        }
+
+        record_value_t *record = (record_value_t *) deref(ref);
+        for (size_t slot = 0; slot < shape->num_keys; slot++) {
+            reference_t value = dict_valuearray(dict)->values[slot];
+            incref(value);
+            record->values[slot] = value;
+        }
+        return ref;
+    }
+
+    /* Otherwise, first determine the shape of the record from the keys. */
+    ref_array_value_t *keys = dict_keyarray(dict);
+    shape_t *shape = shape_root();
+    for (size_t idx = 0; idx < keys->capacity; idx++) {
+        reference_t key = keys->values[idx];
+        if (key == NULL_REF) {
+            continue;
+        }
+
+        const char *name = key_name(key);
+        if (name == NULL) {
+            exception_set(EXC_TYPE_ERROR, "record field names must be strings");
+            return NULL_REF;
+        }
+
+        shape = shape_add_key(shape, name);
+        if (shape == NULL) {
+            return NULL_REF;
+        }
+    }
+
+    /* Then allocate the record and copy the values in, in the same order. */
+    reference_t ref = make_reference_record(shape);
+    if (ref == NULL_REF) {
+        return NULL_REF;
+    }
+
+    record_value_t *record = (record_value_t *) deref(ref);
+    ref_array_value_t *values = dict_valuearray(dict);
+    size_t slot = 0;
+    for (size_t idx = 0; idx < keys->capacity; idx++) {
+        reference_t key = keys->values[idx];
+        if (key != NULL_REF) {
+            incref(values->values[idx]);
+            record->values[slot++] = values->values[idx];
+        }
+    }
+    return ref;
+}
+
+/*!
+ * Like dict_subscr_get, but returns a borrowed reference, and returns
+ * NULL_REF without raising a KeyError if the key is missing. An exception is
+ * only set if the key is unhashable.
+ */
+reference_t dict_subscr_peek(value_t *obj, reference_t subscr) {
+    dict_value_t *dict = dict_coerce(obj);
+
+    if (dict_is_shaped(dict)) {
+        const char *name = key_name(subscr);
+        if (name == NULL) {
+            /* Only strings can be present, but unhashable keys should still
+             * be reported as such. */
+            ref_hash(subscr);
+            return NULL_REF;
+        }
+
+        int64_t slot = shape_find(dict->shape, name);
+        return slot >= 0 ? dict_valuearray(dict)->values[slot] : NULL_REF;
+    }
+
+    uint64_t hash = ref_hash(subscr);
+    if (exception_occurred()) {
+        return NULL_REF;
+    }
+
+    ref_array_value_t *keys = dict_keyarray(dict);
+    int64_t idx = keys_find(keys, hash, subscr);
+    return idx >= 0 ? dict_valuearray(dict)->values[idx] : NULL_REF;
+}
+
+/*!
+ * Returns a new reference to a shallow copy of a dict, or NULL_REF on error.
+ * The copy shares the original's key and value arrays, and shape, until
+ * either dict is modified, so copying takes constant time.
+ */
+reference_t dict_copy(value_t *obj) {
+    dict_value_t *dict = dict_coerce(obj);
+
+    reference_t ref = make_reference_dict();
+    if (ref != NULL_REF) {
+        dict_value_t *copy = (dict_value_t *) deref(ref);
+        if (dict->keys != NULL_REF) {
+            incref(dict->keys);
+        }
+        if (dict->values != NULL_REF) {
+            incref(dict->values);
+        }
+        copy->size = dict->size;
+        copy->shape = dict->shape;
+        copy->keys = dict->keys;
+        copy->values = dict->values;
+    }
+    return ref;
 }
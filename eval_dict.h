@@ -2,18 +2,45 @@
 #define EVAL_DICT_H
 
 #include <stdbool.h>
-#include <stdio.h>
 
+#include "format.h"
+#include "shape.h"
 #include "types.h"
 
+/*!
+ * The largest number of keys a dict keeps in its shaped representation.
+ * Shaped lookups scan the shape's keys, so bigger dicts use the hash table.
+ */
+#define DICT_MAX_SHAPED_KEYS 16
+
 // TYPE INTERFACE FUNCTIONS //
 
 bool dict_bool(value_t *obj);
 int64_t dict_len(value_t *obj);
 bool dict_eq(value_t *l, value_t *r);
 reference_t dict_subscr_get(value_t *obj, reference_t subscr);
+bool dict_contains(value_t *obj, reference_t item);
 void dict_subscr_set(value_t *obj, reference_t subscr, reference_t value);
 void dict_subscr_del(value_t *obj, reference_t subscr);
-void dict_print(value_t *obj, FILE *stream, size_t depth);
+void dict_print(value_t *obj, sink_t *sink, size_t depth);
+
+// HELPER FUNCTIONS //
+
+shape_t *dict_shape_add_key(shape_t *shape, const char *key);
+bool dict_init_shaped(value_t *obj, shape_t *shape, size_t capacity);
+bool dict_init_hashed(value_t *obj, size_t size);
+bool dict_build_hashed(value_t *obj, reference_t *keys, reference_t *values, size_t size);
+reference_t dict_to_record(value_t *obj);
+reference_t dict_subscr_peek(value_t *obj, reference_t subscr);
+reference_t dict_copy(value_t *obj);
+
+// HASH TABLE FUNCTIONS //
+
+uint64_t keys_hash(ref_array_value_t *keys, uint64_t idx);
+int64_t keys_find(ref_array_value_t *keys, uint64_t hash, reference_t subscr);
+void keys_insert(ref_array_value_t *keys, ref_array_value_t *values,
+        uint64_t hash, reference_t key, reference_t value);
+void keys_remove(ref_array_value_t *keys, ref_array_value_t *values, uint64_t idx);
+size_t table_capacity(size_t size);
 
 #endif /* EVAL_DICT_H */
@@ -1,6 +1,7 @@
 #include "eval_list.h"
 
 #include <assert.h>
+#include "eval_refs.h"
 #include "eval_types.h"
 #include "exception.h"
 #include "refs.h"
@@ -83,21 +84,29 @@ bool list_eq(value_t *lobj, value_t *robj) {
     return true;
 }
 
-/*! Implements subscript access for list types. */
-reference_t list_subscr_get(value_t *obj, reference_t subscr) {
-    /* First ensure that this is actually a list_value_t. */
+/*! Implements membership tests for lists, comparing items with ==. */
+bool list_contains(value_t *obj, reference_t item) {
     list_value_t *list = list_coerce(obj);
+    reference_t *values = list_refarray(list)->values;
 
-    /* Then check to make sure that the subscript is an integer. */
-    int64_t idx = list_coerce_subscript(list, deref(subscr));
-    if (exception_occurred()) {
-        return NULL_REF;
+    for (int64_t idx = 0; idx < list->size; idx++) {
+        if (ref_eq(values[idx], item)) {
+            return true;
+        }
+        if (exception_occurred()) {
+            return false;
+        }
     }
+    return false;
+}
 
-    /* Finally look up the appropriate reference in the list. */
-    ref_array_value_t *array = list_refarray(list);
-    incref(array->values[idx]);
-    return array->values[idx];
+/*! Implements subscript access for list types. */
+reference_t list_subscr_get(value_t *obj, reference_t subscr) {
+    reference_t value = list_subscr_peek(obj, subscr);
+    if (value != NULL_REF) {
+        incref(value);
+    }
+    return value;
 }
 
 /*! Implements subscript assignment for list types. */
@@ -111,6 +120,11 @@ void list_subscr_set(value_t *obj, reference_t subscr, reference_t value) {
         return;
     }
 
+    /* A list sharing its elements with a copy needs its own first. */
+    if (!unshare_refarray(&list->values)) {
+        return;
+    }
+
     /* Finally set the appropriate reference in the list. */
     ref_array_value_t *array = list_refarray(list);
     decref(array->values[idx]);
@@ -129,7 +143,10 @@ void list_subscr_del(value_t *obj, reference_t subscr) {
     }
 
     /* Now get the value array so that we can actually perform the deletion
-     * operation. */
+     * operation, taking a private copy if it is shared. */
+    if (!unshare_refarray(&list->values)) {
+        return;
+    }
     ref_array_value_t *array = list_refarray(list);
 
     /* Update the size of the list. */
@@ -144,10 +161,10 @@ void list_subscr_del(value_t *obj, reference_t subscr) {
 }
 
 /*! Implements printing of lists. */
-void list_print(value_t *obj, FILE *stream, size_t depth) {
+void list_print(value_t *obj, sink_t *sink, size_t depth) {
     /* If we have reached the maximum recursion depth, print a placeholder. */
     if (depth == 0) {
-        fprintf(stream, "...");
+        sink_puts(sink, "...");
         return;
     }
 
@@ -158,13 +175,53 @@ void list_print(value_t *obj, FILE *stream, size_t depth) {
     ref_array_value_t *array = list_refarray(list);
 
     /* Then print out the contents. */
-    fprintf(stream, "[");
+    sink_putc(sink, '[');
     if (list->size >= 1) {
-        ref_print_repr(array->values[0], stream, depth - 1);
+        ref_write_repr(array->values[0], sink, depth - 1);
         for (int64_t i = 1; i < list->size; i++) {
-            fprintf(stream, ", ");
-            ref_print_repr(array->values[i], stream, depth - 1);
+            sink_puts(sink, ", ");
+            ref_write_repr(array->values[i], sink, depth - 1);
+        }
+    }
+    sink_putc(sink, ']');
+}
+
+//// HELPER FUNCTIONS ////
+
+/*!
+ * Like list_subscr_get, but returns a borrowed reference. The result is only
+ * valid as long as the list is alive and unmodified.
+ */
+reference_t list_subscr_peek(value_t *obj, reference_t subscr) {
+    /* First ensure that this is actually a list_value_t. */
+    list_value_t *list = list_coerce(obj);
+
+    /* Then check to make sure that the subscript is an integer. */
+    int64_t idx = list_coerce_subscript(list, deref(subscr));
+    if (exception_occurred()) {
+        return NULL_REF;
+    }
+
+    /* Finally look up the appropriate reference in the list. */
+    return list_refarray(list)->values[idx];
+}
+
+/*!
+ * Returns a new reference to a shallow copy of a list, or NULL_REF on error.
+ * The copy shares the original's element array until either list is
+ * modified, so copying takes constant time.
+ */
+reference_t list_copy(value_t *obj) {
+    list_value_t *list = list_coerce(obj);
+
+    reference_t ref = make_reference_list();
+    if (ref != NULL_REF) {
+        list_value_t *copy = (list_value_t *) deref(ref);
+        if (list->values != NULL_REF) {
+            incref(list->values);
         }
+        copy->values = list->values;
+        copy->size = list->size;
     }
-    fprintf(stream, "]");
+    return ref;
 }
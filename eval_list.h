@@ -2,8 +2,8 @@
 #define EVAL_LIST_H
 
 #include <stdbool.h>
-#include <stdio.h>
 
+#include "format.h"
 #include "types.h"
 
 // TYPE INTERFACE FUNCTIONS //
@@ -12,9 +12,15 @@ bool list_bool(value_t *obj);
 int64_t list_len(value_t *obj);
 int list_cmp(value_t *lobj, value_t *robj);
 bool list_eq(value_t *lobj, value_t *robj);
+bool list_contains(value_t *obj, reference_t item);
 reference_t list_subscr_get(value_t *obj, reference_t subscr);
 void list_subscr_set(value_t *obj, reference_t subscr, reference_t value);
 void list_subscr_del(value_t *obj, reference_t subscr);
-void list_print(value_t *obj, FILE *stream, size_t depth);
+void list_print(value_t *obj, sink_t *sink, size_t depth);
+
+// HELPER FUNCTIONS //
+
+reference_t list_subscr_peek(value_t *obj, reference_t subscr);
+reference_t list_copy(value_t *obj);
 
 #endif /* EVAL_LIST_H */
\ No newline at end of file
@@ -0,0 +1,608 @@
+#include "eval_pmap.h"
+
+#include <assert.h>
+#include "eval_refs.h"
+#include "eval_types.h"
+#include "exception.h"
+#include "refs.h"
+
+/*! The number of hash bits used at each level of a map's trie. */
+#define HAMT_BITS 5
+
+#define HAMT_MASK ((1 << HAMT_BITS) - 1)
+
+/*!
+ * The number of bits in a hash. Keys that still collide once they are all
+ * used share a bucket at the next level.
+ */
+#define HAMT_HASH_BITS 64
+
+static inline pmap_value_t *pmap_coerce(value_t *obj) {
+    assert(obj->type == VAL_PMAP);
+    return (pmap_value_t *) obj;
+}
+
+/*! Returns true if a node of a trie is a bucket of colliding pairs. */
+static inline bool is_bucket(reference_t node) {
+    return deref(node)->type == VAL_REF_ARRAY;
+}
+
+static inline hamt_node_value_t *hamt_node(reference_t node) {
+    value_t *obj = deref(node);
+    assert(obj->type == VAL_HAMT_NODE);
+    return (hamt_node_value_t *) obj;
+}
+static inline ref_array_value_t *hamt_bucket(reference_t node) {
+    value_t *obj = deref(node);
+    assert(obj->type == VAL_REF_ARRAY);
+    return (ref_array_value_t *) obj;
+}
+
+/*! Returns the bit standing for the hash's digit at the given level. */
+static inline uint32_t hash_bit(uint64_t hash, int shift) {
+    return (uint32_t) 1 << ((hash >> shift) & HAMT_MASK);
+}
+
+static inline size_t node_num_entries(hamt_node_value_t *node) {
+    return 2 * __builtin_popcount(node->datamap) + __builtin_popcount(node->nodemap);
+}
+
+/*! Returns the index of the key of the pair for a bit of the datamap. */
+static inline size_t data_index(hamt_node_value_t *node, uint32_t bit) {
+    return 2 * __builtin_popcount(node->datamap & (bit - 1));
+}
+
+/*! Returns the index of the child for a bit of the nodemap. */
+static inline size_t child_index(hamt_node_value_t *node, uint32_t bit) {
+    return 2 * __builtin_popcount(node->datamap) + __builtin_popcount(node->nodemap & (bit - 1));
+}
+
+/*! Copies count references from src to dst, incref'ing them. */
+static void copy_entries(reference_t *dst, const reference_t *src, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        incref(src[i]);
+        dst[i] = src[i];
+    }
+}
+
+/*!
+ * Returns a new reference to a map with the given trie, which is moved into
+ * it, or NULL_REF on error. The trie is released if the map can't be
+ * allocated.
+ */
+static reference_t pmap_with_root(int64_t size, reference_t root) {
+    reference_t ref = make_reference_pmap();
+    if (ref == NULL_REF) {
+        decref(root);
+        return NULL_REF;
+    }
+
+    pmap_value_t *pmap = (pmap_value_t *) deref(ref);
+    pmap->size = size;
+    pmap->root = root;
+    return ref;
+}
+
+//// PATH COPYING ////
+
+/*
+ * The trie functions below never modify a node. Each returns a new reference
+ * to a copy of the node it was given, with the change made, sharing every
+ * entry but one with the original. They take borrowed references to keys and
+ * values, and return NULL_REF with an exception set on error.
+ */
+
+/*!
+ * Returns a copy of a trie node or bucket with the entry at idx replaced.
+ * The new entry is moved into the copy, and released on error.
+ */
+static reference_t node_with_entry(reference_t node, size_t idx, reference_t entry) {
+    bool bucket = is_bucket(node);
+    reference_t ref = bucket ?
+        make_reference_refarray(hamt_bucket(node)->capacity) :
+        make_reference_hamt_node(hamt_node(node)->datamap, hamt_node(node)->nodemap);
+    if (ref == NULL_REF) {
+        decref(entry);
+        return NULL_REF;
+    }
+
+    reference_t *src, *dst;
+    size_t count;
+    if (bucket) {
+        src = hamt_bucket(node)->values;
+        dst = hamt_bucket(ref)->values;
+        count = hamt_bucket(node)->capacity;
+    } else {
+        src = hamt_node(node)->entries;
+        dst = hamt_node(ref)->entries;
+        count = node_num_entries(hamt_node(node));
+    }
+
+    copy_entries(dst, src, count);
+    decref(dst[idx]);
+    dst[idx] = entry;
+    return ref;
+}
+
+/*!
+ * Returns a subtrie holding two pairs whose keys differ, but whose hashes
+ * have the same digits above the given level.
+ */
+static reference_t trie_merge(int shift,
+        uint64_t hash1, reference_t key1, reference_t value1,
+        uint64_t hash2, reference_t key2, reference_t value2) {
+    if (shift >= HAMT_HASH_BITS) {
+        reference_t ref = make_reference_refarray(4);
+        if (ref != NULL_REF) {
+            reference_t pairs[] = {key1, value1, key2, value2};
+            copy_entries(hamt_bucket(ref)->values, pairs, 4);
+        }
+        return ref;
+    }
+
+    uint32_t bit1 = hash_bit(hash1, shift);
+    uint32_t bit2 = hash_bit(hash2, shift);
+    if (bit1 == bit2) {
+        reference_t child = trie_merge(shift + HAMT_BITS,
+                hash1, key1, value1, hash2, key2, value2);
+        if (child == NULL_REF) {
+            return NULL_REF;
+        }
+
+        reference_t ref = make_reference_hamt_node(0, bit1);
+        if (ref == NULL_REF) {
+            decref(child);
+            return NULL_REF;
+        }
+        hamt_node(ref)->entries[0] = child;
+        return ref;
+    }
+
+    reference_t ref = make_reference_hamt_node(bit1 | bit2, 0);
+    if (ref != NULL_REF) {
+        reference_t pairs[] = {key1, value1, key2, value2};
+        size_t first = bit1 < bit2 ? 0 : 2;
+        copy_entries(hamt_node(ref)->entries + first, pairs, 2);
+        copy_entries(hamt_node(ref)->entries + (2 - first), pairs + 2, 2);
+    }
+    return ref;
+}
+
+/*! Returns a borrowed reference to the value for key, or NULL_REF if absent. */
+static reference_t trie_peek(reference_t node, uint64_t hash, reference_t key) {
+    for (int shift = 0; ; shift += HAMT_BITS) {
+        if (is_bucket(node)) {
+            ref_array_value_t *bucket = hamt_bucket(node);
+            for (size_t idx = 0; idx < bucket->capacity; idx += 2) {
+                if (ref_eq(bucket->values[idx], key)) {
+                    return bucket->values[idx + 1];
+                }
+                if (exception_occurred()) {
+                    return NULL_REF;
+                }
+            }
+            return NULL_REF;
+        }
+
+        hamt_node_value_t *n = hamt_node(node);
+        uint32_t bit = hash_bit(hash, shift);
+        if (n->datamap & bit) {
+            size_t idx = data_index(n, bit);
+            return ref_eq(n->entries[idx], key) ? n->entries[idx + 1] : NULL_REF;
+        }
+        if (!(n->nodemap & bit)) {
+            return NULL_REF;
+        }
+        node = n->entries[child_index(n, bit)];
+    }
+}
+
+/*!
+ * Returns a copy of the subtrie at node with key mapped to value. Sets
+ * *added if the key was not already in the subtrie.
+ */
+static reference_t trie_assoc(reference_t node, int shift, uint64_t hash,
+        reference_t key, reference_t value, bool *added) {
+    if (is_bucket(node)) {
+        size_t capacity = hamt_bucket(node)->capacity;
+        size_t idx = 0;
+        while (idx < capacity && !ref_eq(hamt_bucket(node)->values[idx], key)) {
+            if (exception_occurred()) {
+                return NULL_REF;
+            }
+            idx += 2;
+        }
+
+        if (idx < capacity) {
+            *added = false;
+            incref(value);
+            return node_with_entry(node, idx + 1, value);
+        }
+
+        *added = true;
+        reference_t ref = make_reference_refarray(capacity + 2);
+        if (ref != NULL_REF) {
+            reference_t *dst = hamt_bucket(ref)->values;
+            copy_entries(dst, hamt_bucket(node)->values, capacity);
+            reference_t pair[] = {key, value};
+            copy_entries(dst + capacity, pair, 2);
+        }
+        return ref;
+    }
+
+    hamt_node_value_t *n = hamt_node(node);
+    uint32_t bit = hash_bit(hash, shift);
+    size_t num_entries = node_num_entries(n);
+
+    if (n->datamap & bit) {
+        size_t idx = data_index(n, bit);
+        reference_t old_key = n->entries[idx];
+        bool equals = ref_eq(old_key, key);
+        if (exception_occurred()) {
+            return NULL_REF;
+        }
+
+        if (equals) {
+            *added = false;
+            incref(value);
+            return node_with_entry(node, idx + 1, value);
+        }
+
+        /* Another key has the same digit here, so both move down into a
+         * new child. The old key was hashed when it was added, so hashing it
+         * again can't fail. */
+        *added = true;
+        reference_t child = trie_merge(shift + HAMT_BITS,
+                ref_hash(old_key), old_key, n->entries[idx + 1], hash, key, value);
+        if (child == NULL_REF) {
+            return NULL_REF;
+        }
+
+        n = hamt_node(node);
+        reference_t ref = make_reference_hamt_node(n->datamap ^ bit, n->nodemap | bit);
+        if (ref == NULL_REF) {
+            decref(child);
+            return NULL_REF;
+        }
+
+        hamt_node_value_t *copy = hamt_node(ref);
+        size_t cidx = child_index(copy, bit);
+        copy_entries(copy->entries, n->entries, idx);
+        copy_entries(copy->entries + idx, n->entries + idx + 2, cidx - idx);
+        copy->entries[cidx] = child;
+        copy_entries(copy->entries + cidx + 1, n->entries + cidx + 2,
+                num_entries - cidx - 2);
+        return ref;
+    }
+
+    if (n->nodemap & bit) {
+        size_t cidx = child_index(n, bit);
+        reference_t child = trie_assoc(n->entries[cidx], shift + HAMT_BITS,
+                hash, key, value, added);
+        if (child == NULL_REF) {
+            return NULL_REF;
+        }
+        return node_with_entry(node, cidx, child);
+    }
+
+    /* Otherwise the digit is unused, and the pair goes in this node. */
+    *added = true;
+    reference_t ref = make_reference_hamt_node(n->datamap | bit, n->nodemap);
+    if (ref != NULL_REF) {
+        n = hamt_node(node);
+        hamt_node_value_t *copy = hamt_node(ref);
+        size_t idx = data_index(copy, bit);
+        reference_t pair[] = {key, value};
+        copy_entries(copy->entries, n->entries, idx);
+        copy_entries(copy->entries + idx, pair, 2);
+        copy_entries(copy->entries + idx + 2, n->entries + idx, num_entries - idx);
+    }
+    return ref;
+}
+
+/*!
+ * Returns true if a subtrie holds just one pair, which its parent should
+ * store itself, and sets *pair to point to it.
+ */
+static bool trie_single_pair(reference_t node, reference_t **pair) {
+    if (is_bucket(node)) {
+        *pair = hamt_bucket(node)->values;
+        return hamt_bucket(node)->capacity == 2;
+    }
+
+    hamt_node_value_t *n = hamt_node(node);
+    *pair = n->entries;
+    return n->nodemap == 0 && __builtin_popcount(n->datamap) == 1;
+}
+
+/*!
+ * Returns a copy of the subtrie at node without key. If the key isn't in the
+ * subtrie, a new reference to node itself is returned instead.
+ */
+static reference_t trie_dissoc(reference_t node, int shift, uint64_t hash, reference_t key) {
+    if (is_bucket(node)) {
+        size_t capacity = hamt_bucket(node)->capacity;
+        size_t idx = 0;
+        while (idx < capacity && !ref_eq(hamt_bucket(node)->values[idx], key)) {
+            if (exception_occurred()) {
+                return NULL_REF;
+            }
+            idx += 2;
+        }
+
+        if (idx == capacity) {
+            incref(node);
+            return node;
+        }
+
+        reference_t ref = make_reference_refarray(capacity - 2);
+        if (ref != NULL_REF) {
+            reference_t *src = hamt_bucket(node)->values;
+            reference_t *dst = hamt_bucket(ref)->values;
+            copy_entries(dst, src, idx);
+            copy_entries(dst + idx, src + idx + 2, capacity - idx - 2);
+        }
+        return ref;
+    }
+
+    hamt_node_value_t *n = hamt_node(node);
+    uint32_t bit = hash_bit(hash, shift);
+    size_t num_entries = node_num_entries(n);
+
+    if (n->datamap & bit) {
+        size_t idx = data_index(n, bit);
+        bool equals = ref_eq(n->entries[idx], key);
+        if (exception_occurred()) {
+            return NULL_REF;
+        }
+        if (!equals) {
+            incref(node);
+            return node;
+        }
+
+        reference_t ref = make_reference_hamt_node(n->datamap ^ bit, n->nodemap);
+        if (ref != NULL_REF) {
+            n = hamt_node(node);
+            reference_t *dst = hamt_node(ref)->entries;
+            copy_entries(dst, n->entries, idx);
+            copy_entries(dst + idx, n->entries + idx + 2, num_entries - idx - 2);
+        }
+        return ref;
+    }
+
+    if (n->nodemap & bit) {
+        size_t cidx = child_index(n, bit);
+        reference_t old_child = n->entries[cidx];
+        reference_t child = trie_dissoc(old_child, shift + HAMT_BITS, hash, key);
+        if (child == NULL_REF) {
+            return NULL_REF;
+        }
+        if (child == old_child) {
+            decref(child);
+            incref(node);
+            return node;
+        }
+
+        /* A child left with a single pair is folded back into this node, so
+         * that every child holds at least two keys. */
+        reference_t *pair;
+        if (!trie_single_pair(child, &pair)) {
+            return node_with_entry(node, cidx, child);
+        }
+
+        n = hamt_node(node);
+        reference_t ref = make_reference_hamt_node(n->datamap | bit, n->nodemap ^ bit);
+        if (ref != NULL_REF) {
+            n = hamt_node(node);
+            hamt_node_value_t *copy = hamt_node(ref);
+            size_t idx = data_index(copy, bit);
+            copy_entries(copy->entries, n->entries, idx);
+            copy_entries(copy->entries + idx, pair, 2);
+            copy_entries(copy->entries + idx + 2, n->entries + idx, cidx - idx);
+            copy_entries(copy->entries + cidx + 2, n->entries + cidx + 1,
+                    num_entries - cidx - 1);
+        }
+        decref(child);
+        return ref;
+    }
+
+    incref(node);
+    return node;
+}
+
+/*!
+ * Calls f on every pair in a subtrie, in trie order, stopping early if it
+ * returns false. Returns false if it stopped early.
+ */
+static bool trie_each(reference_t node,
+        bool (*f)(reference_t key, reference_t value, void *ctx), void *ctx) {
+    if (is_bucket(node)) {
+        ref_array_value_t *bucket = hamt_bucket(node);
+        for (size_t idx = 0; idx < bucket->capacity; idx += 2) {
+            if (!f(bucket->values[idx], bucket->values[idx + 1], ctx)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    hamt_node_value_t *n = hamt_node(node);
+    size_t num_data = 2 * __builtin_popcount(n->datamap);
+    for (size_t idx = 0; idx < num_data; idx += 2) {
+        if (!f(n->entries[idx], n->entries[idx + 1], ctx)) {
+            return false;
+        }
+    }
+    for (size_t idx = num_data; idx < node_num_entries(n); idx++) {
+        if (!trie_each(n->entries[idx], f, ctx)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//// TYPE INTERFACE FUNCTIONS ////
+
+bool pmap_bool(value_t *obj) {
+    return pmap_len(obj) > 0;
+}
+
+int64_t pmap_len(value_t *obj) {
+    return pmap_coerce(obj)->size;
+}
+
+/*! Checks that a pair of one map is also in the map ctx. */
+static bool pair_in(reference_t key, reference_t value, void *ctx) {
+    reference_t other = pmap_peek(ctx, key);
+    bool equals = other != NULL_REF && ref_eq(value, other);
+    return equals && !exception_occurred();
+}
+
+bool pmap_eq(value_t *l, value_t *r) {
+    pmap_value_t *lpmap = pmap_coerce(l);
+    pmap_value_t *rpmap = pmap_coerce(r);
+
+    if (lpmap->size != rpmap->size) {
+        return false;
+    }
+    if (lpmap->root == rpmap->root) {
+        return true;
+    }
+    return trie_each(lpmap->root, pair_in, r);
+}
+
+/*! Implements membership tests for maps, which test the keys. */
+bool pmap_contains(value_t *obj, reference_t item) {
+    return pmap_peek(obj, item) != NULL_REF;
+}
+
+reference_t pmap_subscr_get(value_t *obj, reference_t subscr) {
+    reference_t value = pmap_peek(obj, subscr);
+    if (value == NULL_REF) {
+        if (!exception_occurred()) {
+            exception_set(EXC_KEY_ERROR, "no value found for key in map");
+        }
+        return NULL_REF;
+    }
+
+    incref(value);
+    return value;
+}
+
+typedef struct {
+    sink_t *sink;
+    size_t depth;
+    bool comma;
+} print_state_t;
+
+static bool print_pair(reference_t key, reference_t value, void *ctx) {
+    print_state_t *state = ctx;
+    if (state->comma) {
+        sink_puts(state->sink, ", ");
+    }
+
+    ref_write_repr(key, state->sink, state->depth);
+    sink_puts(state->sink, ": ");
+    ref_write_repr(value, state->sink, state->depth);
+
+    state->comma = true;
+    return true;
+}
+
+/*! Implements printing of maps, as the call that would build them. */
+void pmap_print(value_t *obj, sink_t *sink, size_t depth) {
+    /* If we have reached the maximum recursion depth, print a placeholder. */
+    if (depth == 0) {
+        sink_puts(sink, "...");
+        return;
+    }
+
+    pmap_value_t *pmap = pmap_coerce(obj);
+    if (pmap->size == 0) {
+        sink_puts(sink, "pmap()");
+        return;
+    }
+
+    print_state_t state = {sink, depth - 1, false};
+    sink_puts(sink, "pmap({");
+    trie_each(pmap->root, print_pair, &state);
+    sink_puts(sink, "})");
+}
+
+//// HELPER FUNCTIONS ////
+
+/*!
+ * Returns a borrowed reference to the value for a key, or NULL_REF if the key
+ * is missing. An exception is only set if the key is unhashable.
+ */
+reference_t pmap_peek(value_t *obj, reference_t key) {
+    pmap_value_t *pmap = pmap_coerce(obj);
+
+    uint64_t hash = ref_hash(key);
+    if (exception_occurred() || pmap->root == NULL_REF) {
+        return NULL_REF;
+    }
+    return trie_peek(pmap->root, hash, key);
+}
+
+/*!
+ * Returns a new reference to a map like this one, but with key mapped to
+ * value, or NULL_REF on error.
+ */
+reference_t pmap_assoc(value_t *obj, reference_t key, reference_t value) {
+    pmap_value_t *pmap = pmap_coerce(obj);
+
+    uint64_t hash = ref_hash(key);
+    if (exception_occurred()) {
+        return NULL_REF;
+    }
+
+    if (pmap->root == NULL_REF) {
+        reference_t root = make_reference_hamt_node(hash_bit(hash, 0), 0);
+        if (root == NULL_REF) {
+            return NULL_REF;
+        }
+        reference_t pair[] = {key, value};
+        copy_entries(hamt_node(root)->entries, pair, 2);
+        return pmap_with_root(1, root);
+    }
+
+    bool added;
+    reference_t root = trie_assoc(pmap->root, 0, hash, key, value, &added);
+    if (root == NULL_REF) {
+        return NULL_REF;
+    }
+    return pmap_with_root(pmap->size + added, root);
+}
+
+/*!
+ * Returns a new reference to a map like this one, but without key, or
+ * NULL_REF on error. Removing a missing key is not an error; the new map
+ * then shares the whole trie with this one.
+ */
+reference_t pmap_dissoc(value_t *obj, reference_t key) {
+    pmap_value_t *pmap = pmap_coerce(obj);
+
+    uint64_t hash = ref_hash(key);
+    if (exception_occurred()) {
+        return NULL_REF;
+    }
+    if (pmap->root == NULL_REF) {
+        return pmap_with_root(0, NULL_REF);
+    }
+
+    reference_t root = trie_dissoc(pmap->root, 0, hash, key);
+    if (root == NULL_REF) {
+        return NULL_REF;
+    }
+    if (root == pmap->root) {
+        return pmap_with_root(pmap->size, root);
+    }
+
+    /* The root is the only node that may be left empty. */
+    if (node_num_entries(hamt_node(root)) == 0) {
+        decref(root);
+        root = NULL_REF;
+    }
+    return pmap_with_root(pmap->size - 1, root);
+}
@@ -0,0 +1,24 @@
+#ifndef EVAL_PMAP_H
+#define EVAL_PMAP_H
+
+#include <stdbool.h>
+
+#include "format.h"
+#include "types.h"
+
+// TYPE INTERFACE FUNCTIONS //
+
+bool pmap_bool(value_t *obj);
+int64_t pmap_len(value_t *obj);
+bool pmap_eq(value_t *l, value_t *r);
+bool pmap_contains(value_t *obj, reference_t item);
+reference_t pmap_subscr_get(value_t *obj, reference_t subscr);
+void pmap_print(value_t *obj, sink_t *sink, size_t depth);
+
+// HELPER FUNCTIONS //
+
+reference_t pmap_peek(value_t *obj, reference_t key);
+reference_t pmap_assoc(value_t *obj, reference_t key, reference_t value);
+reference_t pmap_dissoc(value_t *obj, reference_t key);
+
+#endif /* EVAL_PMAP_H */
@@ -0,0 +1,136 @@
+#include "eval_record.h"
+
+#include <assert.h>
+#include "eval_refs.h"
+#include "eval_types.h"
+#include "exception.h"
+#include "refs.h"
+
+static inline record_value_t *record_coerce(value_t *obj) {
+    assert(obj->type == VAL_RECORD);
+    return (record_value_t *) obj;
+}
+
+/*!
+ * Looks up the slot named by a subscript. Sets an exception and returns -1 if
+ * the subscript is not a string or doesn't name a field of the record.
+ */
+static int64_t record_coerce_subscript(record_value_t *record, reference_t subscr) {
+    value_t *obj = deref(subscr);
+    if (obj->type != VAL_STRING) {
+        exception_set(EXC_TYPE_ERROR, "record field names must be strings");
+        return -1;
+    }
+
+    const char *name = ((string_value_t *) obj)->string_value;
+    int64_t slot = shape_find(record->shape, name);
+    if (slot < 0) {
+        exception_set_format(EXC_KEY_ERROR, "record has no field '%s'", name);
+    }
+    return slot;
+}
+
+bool record_bool(value_t *obj) {
+    return record_len(obj) > 0;
+}
+
+int64_t record_len(value_t *obj) {
+    return record_coerce(obj)->shape->num_keys;
+}
+
+bool record_eq(value_t *l, value_t *r) {
+    record_value_t *lrecord = record_coerce(l);
+    record_value_t *rrecord = record_coerce(r);
+    shape_t *lshape = lrecord->shape, *rshape = rrecord->shape;
+
+    if (lshape->num_keys != rshape->num_keys) {
+        return false;
+    }
+
+    for (size_t idx = 0; idx < lshape->num_keys; idx++) {
+        /* Records with the same shape line up slot for slot. Otherwise the
+         * same fields may have been added in a different order. */
+        int64_t ridx = lshape == rshape ? (int64_t) idx :
+            shape_find(rshape, lshape->keys[idx]);
+        if (ridx < 0) {
+            return false;
+        }
+
+        bool equals = ref_eq(lrecord->values[idx], rrecord->values[ridx]);
+        if (exception_occurred() || !equals) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*! Implements subscript access for records. */
+reference_t record_subscr_get(value_t *obj, reference_t subscr) {
+    record_value_t *record = record_coerce(obj);
+
+    int64_t slot = record_coerce_subscript(record, subscr);
+    if (slot < 0) {
+        return NULL_REF;
+    }
+
+    return record_get_slot(obj, slot);
+}
+
+/*!
+ * Implements subscript assignment for records. Only existing fields can be
+ * assigned, since a record's shape never changes.
+ */
+void record_subscr_set(value_t *obj, reference_t subscr, reference_t value) {
+    record_value_t *record = record_coerce(obj);
+
+    int64_t slot = record_coerce_subscript(record, subscr);
+    if (slot < 0) {
+        return;
+    }
+
+    record_set_slot(obj, slot, value);
+}
+
+/*! Implements printing of records. */
+void record_print(value_t *obj, sink_t *sink, size_t depth) {
+    /* If we have reached the maximum recursion depth, print a placeholder. */
+    if (depth == 0) {
+        sink_puts(sink, "...");
+        return;
+    }
+
+    record_value_t *record = record_coerce(obj);
+    shape_t *shape = record->shape;
+
+    sink_puts(sink, "record(");
+    for (size_t idx = 0; idx < shape->num_keys; idx++) {
+        if (idx > 0) {
+            sink_puts(sink, ", ");
+        }
+
+        sink_puts(sink, shape->keys[idx]);
+        sink_putc(sink, '=');
+        ref_write_repr(record->values[idx], sink, depth - 1);
+    }
+    sink_putc(sink, ')');
+}
+
+/*! Returns a new reference to the value in the given slot of a record. */
+reference_t record_get_slot(value_t *obj, int64_t slot) {
+    record_value_t *record = record_coerce(obj);
+    assert(slot >= 0 && (size_t) slot < record->shape->num_keys);
+
+    incref(record->values[slot]);
+    return record->values[slot];
+}
+
+/*! Replaces the value in the given slot of a record. */
+void record_set_slot(value_t *obj, int64_t slot, reference_t value) {
+    record_value_t *record = record_coerce(obj);
+    assert(slot >= 0 && (size_t) slot < record->shape->num_keys);
+
+    incref(value);
+    decref(record->values[slot]);
+    record->values[slot] = value;
+}
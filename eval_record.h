@@ -0,0 +1,24 @@
+#ifndef EVAL_RECORD_H
+#define EVAL_RECORD_H
+
+#include <stdbool.h>
+
+#include "format.h"
+#include "shape.h"
+#include "types.h"
+
+// TYPE INTERFACE FUNCTIONS //
+
+bool record_bool(value_t *obj);
+int64_t record_len(value_t *obj);
+bool record_eq(value_t *l, value_t *r);
+reference_t record_subscr_get(value_t *obj, reference_t subscr);
+void record_subscr_set(value_t *obj, reference_t subscr, reference_t value);
+void record_print(value_t *obj, sink_t *sink, size_t depth);
+
+// HELPER FUNCTIONS //
+
+reference_t record_get_slot(value_t *obj, int64_t slot);
+void record_set_slot(value_t *obj, int64_t slot, reference_t value);
+
+#endif /* EVAL_RECORD_H */
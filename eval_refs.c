@@ -1,9 +1,12 @@
 #include "eval_refs.h"
 #include "eval_types.h"
 
+#include <assert.h>
 #include <string.h>
 
+#include "exception.h"
 #include "refs.h"
+#include "shape.h"
 
 //// GLOBAL VARIABLE DECLARATIONS ////
 
@@ -32,10 +35,64 @@ reference_t make_reference_int(int64_t i) {
     return ref;
 }
 
+/*! Assigns a double to a new reference in the ref_table. */
+reference_t make_reference_float(double f) {
+    reference_t ref = make_ref(VAL_FLOAT, sizeof(float_value_t));
+    if (ref != NULL_REF) {
+        ((float_value_t *) deref(ref))->float_value = f;
+    }
+    return ref;
+}
+
+/*! Float array allocation helper. The elements of new arrays are zero. */
+reference_t make_reference_float_array(size_t size) {
+    /* Reject sizes whose byte count doesn't fit in a size_t. */
+    if (size > (SIZE_MAX - sizeof(float_array_value_t)) / sizeof(double)) {
+        exception_set_format(EXC_MEMORY_ERROR,
+                "cannot allocate an array of %zu floats", size);
+        return NULL_REF;
+    }
+
+    reference_t ref = make_ref(VAL_FLOAT_ARRAY,
+            sizeof(float_array_value_t) + sizeof(double[size]));
+    if (ref != NULL_REF) {
+        float_array_value_t *array = (float_array_value_t *) deref(ref);
+        array->size = size;
+        for (size_t i = 0; i < size; i++) {
+            array->values[i] = 0.0;
+        }
+    }
+    return ref;
+}
+
+/*!
+ * Big integer allocation helper. The bigint has room for length limbs, which
+ * the caller must fill in; it is nonnegative until the caller says otherwise.
+ */
+reference_t make_reference_bigint(size_t length) {
+    reference_t ref = make_ref(VAL_BIGINT, sizeof(bigint_value_t) + sizeof(uint64_t[length]));
+    if (ref != NULL_REF) {
+        bigint_value_t *bigint = (bigint_value_t *) deref(ref);
+        bigint->negative = false;
+        bigint->length = length;
+    }
+    return ref;
+}
+
 
-/*! Makes a reference for a new string of the given length. */
+/*!
+ * Makes a reference for a new string of the given length. Everything from
+ * the terminator to the end of the value is zeroed, as string_length expects;
+ * the caller only needs to fill in the first len characters.
+ */
 static reference_t make_reference_string_length(size_t len) {
-    return make_ref(VAL_STRING, sizeof(string_value_t) + sizeof(char[len + 1]));
+    reference_t ref = make_ref(VAL_STRING, sizeof(string_value_t) + sizeof(char[len + 1]));
+    if (ref != NULL_REF) {
+        string_value_t *str = (string_value_t *) deref(ref);
+        size_t capacity = str->base.value_size - sizeof(string_value_t);
+        memset(str->string_value + len, 0, capacity - len);
+    }
+    return ref;
 }
 
 /*! Assigns a string to a new reference in the ref_table. */
@@ -47,6 +104,20 @@ reference_t make_reference_string(const char *value) {
     return ref;
 }
 
+/*!
+ * Assigns the first length characters of buffer to a new string reference.
+ * The buffer does not need to be '\0'-terminated.
+ */
+reference_t make_reference_string_buffer(const char *buffer, size_t length) {
+    reference_t ref = make_reference_string_length(length);
+    if (ref != NULL_REF) {
+        char *string_value = ((string_value_t *) deref(ref))->string_value;
+        memcpy(string_value, buffer, length);
+        string_value[length] = '\0';
+    }
+    return ref;
+}
+
 /*! Assigns a concatenated string to a new reference in the ref_table. */
 reference_t make_reference_string_concat(const char *v1, const char *v2) {
     size_t len1 = strlen(v1), len2 = strlen(v2);
@@ -70,19 +141,178 @@ reference_t make_reference_list() {
     return ref;
 }
 
-/*! Dict allocation helper. */
+/*!
+ * Dict allocation helper. New dicts start out shaped and empty; see
+ * dict_value_t for the two representations.
+ */
 reference_t make_reference_dict() {
     reference_t ref = make_ref(VAL_DICT, sizeof(dict_value_t));
     if (ref != NULL_REF) {
         dict_value_t *dv = (dict_value_t *) deref(ref);
         dv->size = 0;
-        dv->occupied = 0;
+        dv->shape = shape_root();
         dv->keys = NULL_REF;
         dv->values = NULL_REF;
     }
     return ref;
 }
 
+/*!
+ * Record allocation helper. The fields are initialized to NULL_REF and must
+ * all be filled in before the record is used.
+ */
+reference_t make_reference_record(shape_t *shape) {
+    reference_t ref = make_ref(
+        VAL_RECORD,
+        sizeof(record_value_t) + sizeof(reference_t[shape->num_keys])
+    );
+    if (ref != NULL_REF) {
+        record_value_t *record = (record_value_t *) deref(ref);
+        record->shape = shape;
+        for (size_t i = 0; i < shape->num_keys; i++) {
+            record->values[i] = NULL_REF;
+        }
+    }
+    return ref;
+}
+
+/*!
+ * Set allocation helper. New sets are empty, and allocate their table when
+ * the first member is added.
+ */
+reference_t make_reference_set() {
+    reference_t ref = make_ref(VAL_SET, sizeof(set_value_t));
+    if (ref != NULL_REF) {
+        set_value_t *sv = (set_value_t *) deref(ref);
+        sv->size = 0;
+        sv->keys = NULL_REF;
+    }
+    return ref;
+}
+
+/*!
+ * Weak reference allocation helper. The new weak reference is added to the
+ * target's list, but doesn't hold a count on it.
+ */
+reference_t make_reference_weakref(reference_t target) {
+    reference_t ref = make_ref(VAL_WEAKREF, sizeof(weakref_value_t));
+    if (ref != NULL_REF) {
+        weakref_value_t *wv = (weakref_value_t *) deref(ref);
+        value_t *obj = deref(target);
+        wv->target = target;
+        wv->next = obj->weakrefs;
+        obj->weakrefs = ref;
+    }
+    return ref;
+}
+
+/*! Weak dict allocation helper. New weak dicts are empty. */
+reference_t make_reference_weakdict() {
+    reference_t ref = make_ref(VAL_WEAKDICT, sizeof(weakdict_value_t));
+    if (ref != NULL_REF) {
+        weakdict_value_t *wd = (weakdict_value_t *) deref(ref);
+        wd->size = 0;
+        wd->keys = NULL_REF;
+        wd->values = NULL_REF;
+        wd->purged = weakrefs_cleared();
+    }
+    return ref;
+}
+
+/*!
+ * Tuple allocation helper. The elements are initialized to NULL_REF and must
+ * all be filled in before the tuple is used.
+ */
+reference_t make_reference_tuple(size_t size) {
+    reference_t ref = make_ref(
+        VAL_TUPLE,
+        sizeof(tuple_value_t) + sizeof(reference_t[size])
+    );
+    if (ref != NULL_REF) {
+        tuple_value_t *tuple = (tuple_value_t *) deref(ref);
+        tuple->size = size;
+        tuple->hashed = false;
+        for (size_t i = 0; i < size; i++) {
+            tuple->values[i] = NULL_REF;
+        }
+    }
+    return ref;
+}
+
+/*!
+ * Bytes and bytearray allocation helper. type must be VAL_BYTES or
+ * VAL_BYTEARRAY. New values are empty.
+ */
+reference_t make_reference_bytes(value_type_t type) {
+    assert(type == VAL_BYTES || type == VAL_BYTEARRAY);
+    reference_t ref = make_ref(type, sizeof(bytes_value_t));
+    if (ref != NULL_REF) {
+        bytes_value_t *bv = (bytes_value_t *) deref(ref);
+        bv->buffer = NULL_REF;
+        bv->start = 0;
+        bv->length = 0;
+    }
+    return ref;
+}
+
+/*! Byte buffer allocation helper. The contents are left uninitialized. */
+reference_t make_reference_byte_buffer(size_t capacity) {
+    reference_t ref = make_ref(
+        VAL_BYTE_BUFFER,
+        sizeof(byte_buffer_value_t) + capacity
+    );
+    if (ref != NULL_REF) {
+        byte_buffer_value_t *buffer = (byte_buffer_value_t *) deref(ref);
+        buffer->capacity = capacity;
+    }
+    return ref;
+}
+
+/*! Persistent vector allocation helper. New vectors are empty. */
+reference_t make_reference_vector() {
+    reference_t ref = make_ref(VAL_VECTOR, sizeof(vector_value_t));
+    if (ref != NULL_REF) {
+        vector_value_t *vv = (vector_value_t *) deref(ref);
+        vv->size = 0;
+        vv->shift = 0;
+        vv->root = NULL_REF;
+    }
+    return ref;
+}
+
+/*! Persistent map allocation helper. New maps are empty. */
+reference_t make_reference_pmap() {
+    reference_t ref = make_ref(VAL_PMAP, sizeof(pmap_value_t));
+    if (ref != NULL_REF) {
+        pmap_value_t *pv = (pmap_value_t *) deref(ref);
+        pv->size = 0;
+        pv->root = NULL_REF;
+    }
+    return ref;
+}
+
+/*!
+ * Persistent map node allocation helper. The node has room for a pair for
+ * each bit of datamap and a child for each bit of nodemap. The entries are
+ * initialized to NULL_REF and must all be filled in before the node is used.
+ */
+reference_t make_reference_hamt_node(uint32_t datamap, uint32_t nodemap) {
+    size_t num_entries = 2 * __builtin_popcount(datamap) + __builtin_popcount(nodemap);
+    reference_t ref = make_ref(
+        VAL_HAMT_NODE,
+        sizeof(hamt_node_value_t) + sizeof(reference_t[num_entries])
+    );
+    if (ref != NULL_REF) {
+        hamt_node_value_t *node = (hamt_node_value_t *) deref(ref);
+        node->datamap = datamap;
+        node->nodemap = nodemap;
+        for (size_t i = 0; i < num_entries; i++) {
+            node->entries[i] = NULL_REF;
+        }
+    }
+    return ref;
+}
+
 /*! RefArray allocation helper. */
 reference_t make_reference_refarray(size_t capacity) {
     reference_t ref = make_ref(
@@ -98,3 +328,55 @@ reference_t make_reference_refarray(size_t capacity) {
     }
     return ref;
 }
+
+/*!
+ * Key array allocation helper. A key array is a ref array holding a hash
+ * table's keys, followed by room for the low 32 bits of the hash of the key
+ * in each slot. Only the references are seen by the garbage collector.
+ */
+reference_t make_reference_keyarray(size_t capacity) {
+    reference_t ref = make_ref(
+        VAL_REF_ARRAY,
+        sizeof(ref_array_value_t) + sizeof(reference_t[capacity]) + sizeof(uint32_t[capacity])
+    );
+    if (ref != NULL_REF) {
+        ref_array_value_t *rav = (ref_array_value_t *) deref(ref);
+        rav->capacity = capacity;
+        for (size_t i = 0; i < capacity; i++) {
+            rav->values[i] = NULL_REF;
+        }
+    }
+    return ref;
+}
+
+/*!
+ * Copy-on-write helper for containers whose ref arrays may be shared with
+ * their copies. If the array at *ref_array is also referenced elsewhere, it is
+ * replaced by a private copy, so the caller can modify it in place. Returns
+ * false if the copy could not be allocated, leaving *ref_array unchanged.
+ */
+bool unshare_refarray(reference_t *ref_array) {
+    if (*ref_array == NULL_REF || deref(*ref_array)->ref_count == 1) {
+        return true;
+    }
+
+    /* The whole value is copied, so that a key array keeps its hashes. */
+    ref_array_value_t *shared = (ref_array_value_t *) deref(*ref_array);
+    reference_t ref = make_ref(VAL_REF_ARRAY, shared->base.value_size);
+    if (ref == NULL_REF) {
+        return false;
+    }
+
+    ref_array_value_t *copy = (ref_array_value_t *) deref(ref);
+    copy->capacity = shared->capacity;
+    memcpy(copy->values, shared->values, shared->base.value_size - sizeof(ref_array_value_t));
+    for (size_t i = 0; i < shared->capacity; i++) {
+        if (shared->values[i] != NULL_REF) {
+            incref(shared->values[i]);
+        }
+    }
+
+    decref(*ref_array);
+    *ref_array = ref;
+    return true;
+}
@@ -1,6 +1,8 @@
 #ifndef EVAL_REFS_H
 #define EVAL_REFS_H
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "types.h"
@@ -16,11 +18,40 @@ extern reference_t FALSE_REF;
 reference_t make_reference_none(void);
 reference_t make_reference_bool(void);
 reference_t make_reference_int(int64_t v);
+reference_t make_reference_bigint(size_t length);
 reference_t make_reference_float(double f);
+reference_t make_reference_float_array(size_t size);
 reference_t make_reference_string(const char *value);
+reference_t make_reference_string_buffer(const char *buffer, size_t length);
 reference_t make_reference_string_concat(const char *v1, const char *v2);
 reference_t make_reference_list(void);
 reference_t make_reference_dict(void);
+reference_t make_reference_record(struct shape *shape);
+reference_t make_reference_set(void);
+reference_t make_reference_tuple(size_t size);
+reference_t make_reference_weakref(reference_t target);
+reference_t make_reference_weakdict(void);
+reference_t make_reference_bytes(value_type_t type);
+reference_t make_reference_byte_buffer(size_t capacity);
+reference_t make_reference_vector(void);
+reference_t make_reference_pmap(void);
+reference_t make_reference_hamt_node(uint32_t datamap, uint32_t nodemap);
 reference_t make_reference_refarray(size_t capacity);
+reference_t make_reference_keyarray(size_t capacity);
+bool unshare_refarray(reference_t *ref_array);
+
+/*!
+ * Returns the length of a string value in constant time. Strings are
+ * zero-filled past their terminator to the end of the value, and can't
+ * contain '\0' themselves, so the end is at most a few words before
+ * value_size.
+ */
+static inline size_t string_length(const string_value_t *str) {
+    size_t end = str->base.value_size - sizeof(string_value_t);
+    while (end > 0 && str->string_value[end - 1] == '\0') {
+        end--;
+    }
+    return end;
+}
 
 #endif /* EVAL_REFS_H */
@@ -0,0 +1,282 @@
+#include "eval_set.h"
+
+#include <assert.h>
+#include "eval_dict.h"
+#include "eval_refs.h"
+#include "eval_types.h"
+#include "exception.h"
+#include "refs.h"
+
+/*
+ * Sets are hash tables of keys with no values. They share the Robin Hood
+ * probing code of hash table dicts in eval_dict.c, passing NULL for the value
+ * array, so a member costs one reference instead of a dict entry's two.
+ */
+
+static inline set_value_t *set_coerce(value_t *obj) {
+    assert(obj->type == VAL_SET);
+    return (set_value_t *) obj;
+}
+
+/*! Returns a set's key array, or NULL if it hasn't allocated one yet. */
+static inline ref_array_value_t *set_keyarray(set_value_t *set) {
+    return set->keys == NULL_REF ? NULL : (ref_array_value_t *) deref(set->keys);
+}
+
+/*!
+ * Returns the slot holding item, or -1 if the set doesn't contain it. Sets an
+ * exception and returns -1 if the item is unhashable.
+ */
+static int64_t set_find(set_value_t *set, reference_t item) {
+    uint64_t hash = ref_hash(item);
+    if (exception_occurred()) {
+        return -1;
+    }
+
+    ref_array_value_t *keys = set_keyarray(set);
+    return keys == NULL ? -1 : keys_find(keys, hash, item);
+}
+
+//// TYPE INTERFACE FUNCTIONS ////
+
+bool set_bool(value_t *obj) {
+    return set_len(obj) > 0;
+}
+
+int64_t set_len(value_t *obj) {
+    return set_coerce(obj)->size;
+}
+
+bool set_eq(value_t *l, value_t *r) {
+    set_value_t *lset = set_coerce(l);
+    set_value_t *rset = set_coerce(r);
+
+    if (lset->size != rset->size) {
+        return false;
+    }
+    if (lset->size == 0) {
+        return true;
+    }
+
+    ref_array_value_t *lkeys = set_keyarray(lset);
+    for (size_t idx = 0; idx < lkeys->capacity; idx++) {
+        reference_t key = lkeys->values[idx];
+        if (key != NULL_REF && set_find(rset, key) < 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*! Implements membership tests for sets. */
+bool set_contains(value_t *obj, reference_t item) {
+    return set_find(set_coerce(obj), item) >= 0;
+}
+
+/*! Implements printing of sets. Like Python, an empty set prints as set(). */
+void set_print(value_t *obj, sink_t *sink, size_t depth) {
+    /* If we have reached the maximum recursion depth, print a placeholder. */
+    if (depth == 0) {
+        sink_puts(sink, "...");
+        return;
+    }
+
+    set_value_t *set = set_coerce(obj);
+    if (set->size == 0) {
+        sink_puts(sink, "set()");
+        return;
+    }
+
+    ref_array_value_t *keys = set_keyarray(set);
+
+    bool comma = false;
+    sink_putc(sink, '{');
+    for (size_t idx = 0; idx < keys->capacity; idx++) {
+        reference_t key = keys->values[idx];
+        if (key == NULL_REF) {
+            continue;
+        }
+
+        if (comma) {
+            sink_puts(sink, ", ");
+        }
+        ref_write_repr(key, sink, depth - 1);
+        comma = true;
+    }
+    sink_putc(sink, '}');
+}
+
+//// HELPER FUNCTIONS ////
+
+/*!
+ * Makes sure a set has room for size members without growing its table,
+ * rehashing its current members into a bigger table if needed. Returns false
+ * and sets an exception if the table could not be allocated.
+ */
+bool set_reserve(value_t *obj, size_t size) {
+    set_value_t *set = set_coerce(obj);
+    ref_array_value_t *keys = set_keyarray(set);
+
+    size_t capacity = table_capacity(size);
+    if (keys != NULL && capacity <= keys->capacity) {
+        return true;
+    }
+
+    reference_t ref_keys = make_reference_keyarray(capacity);
+    if (exception_occurred()) {
+        return false;
+    }
+
+    /* The members move over to the new table, so their counts stay the same
+     * once the old table's slots are cleared. */
+    if (keys != NULL) {
+        ref_array_value_t *new_keys = (ref_array_value_t *) deref(ref_keys);
+        for (size_t idx = 0; idx < keys->capacity; idx++) {
+            reference_t key = keys->values[idx];
+            if (key != NULL_REF) {
+                keys_insert(new_keys, NULL, keys_hash(keys, idx), key, NULL_REF);
+                keys->values[idx] = NULL_REF;
+            }
+        }
+        decref(set->keys);
+    }
+
+    set->keys = ref_keys;
+    return true;
+}
+
+/*! Adds an item to a set, if it isn't a member already. */
+void set_add(value_t *obj, reference_t item) {
+    set_value_t *set = set_coerce(obj);
+
+    if (set_find(set, item) >= 0 || exception_occurred()) {
+        return;
+    }
+
+    /* Grow first, so that there is always an empty slot to probe to. */
+    if (!set_reserve(obj, set->size + 1)) {
+        return;
+    }
+
+    incref(item);
+    keys_insert(set_keyarray(set), NULL, ref_hash(item), item, NULL_REF);
+    set->size++;
+}
+
+/*! Removes an item from a set, raising a KeyError if it isn't a member. */
+void set_remove(value_t *obj, reference_t item) {
+    set_value_t *set = set_coerce(obj);
+
+    int64_t idx = set_find(set, item);
+    if (idx < 0) {
+        if (!exception_occurred()) {
+            exception_set(EXC_KEY_ERROR, "item not found in set");
+        }
+        return;
+    }
+
+    ref_array_value_t *keys = set_keyarray(set);
+    decref(keys->values[idx]);
+    keys_remove(keys, NULL, idx);
+    set->size--;
+}
+
+/*!
+ * Returns a new reference to a set holding the members of both sets, or
+ * NULL_REF on error. The result's table is sized for both sets up front, so
+ * it never grows while the members are copied in.
+ */
+reference_t set_union(value_t *l, value_t *r) {
+    set_value_t *lset = set_coerce(l);
+    set_value_t *rset = set_coerce(r);
+
+    reference_t ref = make_reference_set();
+    if (ref == NULL_REF) {
+        return NULL_REF;
+    }
+
+    set_value_t *result = (set_value_t *) deref(ref);
+    if (!set_reserve(&result->base, lset->size + rset->size)) {
+        decref(ref);
+        return NULL_REF;
+    }
+    ref_array_value_t *keys = set_keyarray(result);
+
+    set_value_t *sources[] = {lset, rset};
+    for (size_t i = 0; i < 2; i++) {
+        ref_array_value_t *source = set_keyarray(sources[i]);
+        if (source == NULL) {
+            continue;
+        }
+
+        for (size_t idx = 0; idx < source->capacity; idx++) {
+            reference_t key = source->values[idx];
+            if (key == NULL_REF) {
+                continue;
+            }
+
+            /* Members of the first set are already distinct. */
+            uint64_t hash = keys_hash(source, idx);
+            if (i > 0 && keys_find(keys, hash, key) >= 0) {
+                continue;
+            }
+
+            incref(key);
+            keys_insert(keys, NULL, hash, key, NULL_REF);
+            result->size++;
+        }
+    }
+
+    return ref;
+}
+
+/*!
+ * Returns a new reference to a set holding the members common to both sets,
+ * or NULL_REF on error. Only the smaller set is scanned.
+ */
+reference_t set_intersection(value_t *l, value_t *r) {
+    set_value_t *lset = set_coerce(l);
+    set_value_t *rset = set_coerce(r);
+    if (lset->size > rset->size) {
+        set_value_t *tmp = lset;
+        lset = rset;
+        rset = tmp;
+    }
+
+    reference_t ref = make_reference_set();
+    if (ref == NULL_REF) {
+        return NULL_REF;
+    }
+
+    set_value_t *result = (set_value_t *) deref(ref);
+    ref_array_value_t *source = set_keyarray(lset);
+    if (source == NULL) {
+        return ref;
+    }
+
+    if (!set_reserve(&result->base, lset->size)) {
+        decref(ref);
+        return NULL_REF;
+    }
+    ref_array_value_t *keys = set_keyarray(result);
+
+    for (size_t idx = 0; idx < source->capacity; idx++) {
+        reference_t key = source->values[idx];
+        if (key == NULL_REF) {
+            continue;
+        }
+
+        uint64_t hash = keys_hash(source, idx);
+        ref_array_value_t *other = set_keyarray(rset);
+        if (keys_find(other, hash, key) < 0) {
+            continue;
+        }
+
+        incref(key);
+        keys_insert(keys, NULL, hash, key, NULL_REF);
+        result->size++;
+    }
+
+    return ref;
+}
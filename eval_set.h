@@ -0,0 +1,25 @@
+#ifndef EVAL_SET_H
+#define EVAL_SET_H
+
+#include <stdbool.h>
+
+#include "format.h"
+#include "types.h"
+
+// TYPE INTERFACE FUNCTIONS //
+
+bool set_bool(value_t *obj);
+int64_t set_len(value_t *obj);
+bool set_eq(value_t *l, value_t *r);
+bool set_contains(value_t *obj, reference_t item);
+void set_print(value_t *obj, sink_t *sink, size_t depth);
+
+// HELPER FUNCTIONS //
+
+bool set_reserve(value_t *obj, size_t size);
+void set_add(value_t *obj, reference_t item);
+void set_remove(value_t *obj, reference_t item);
+reference_t set_union(value_t *l, value_t *r);
+reference_t set_intersection(value_t *l, value_t *r);
+
+#endif /* EVAL_SET_H */
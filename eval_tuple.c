@@ -0,0 +1,167 @@
+#include "eval_tuple.h"
+
+#include <assert.h>
+#include "eval_refs.h"
+#include "eval_types.h"
+#include "exception.h"
+#include "refs.h"
+
+static inline tuple_value_t *tuple_coerce(value_t *obj) {
+    assert(obj->type == VAL_TUPLE);
+    return (tuple_value_t *) obj;
+}
+
+//// TYPE INTERFACE FUNCTIONS ////
+
+bool tuple_bool(value_t *obj) {
+    return tuple_len(obj) > 0;
+}
+
+int64_t tuple_len(value_t *obj) {
+    return tuple_coerce(obj)->size;
+}
+
+/*!
+ * Implements hashing of tuples, by hashing the bytes of their elements'
+ * hashes. The result is cached in the tuple. Sets an exception if an element
+ * is unhashable; nothing is cached then.
+ */
+uint64_t tuple_hash(value_t *obj) {
+    tuple_value_t *tuple = tuple_coerce(obj);
+    if (tuple->hashed) {
+        return tuple->hash;
+    }
+
+    uint64_t hashes[tuple->size > 0 ? tuple->size : 1];
+    for (int64_t i = 0; i < tuple->size; i++) {
+        hashes[i] = ref_hash(tuple->values[i]);
+        if (exception_occurred()) {
+            return 0;
+        }
+    }
+
+    tuple->hash = hash_bytes((const char *) hashes, tuple->size * sizeof(uint64_t));
+    tuple->hashed = true;
+    return tuple->hash;
+}
+
+/*! Implements ordering of tuples, which compare lexicographically. */
+int tuple_cmp(value_t *l, value_t *r) {
+    tuple_value_t *ltuple = tuple_coerce(l);
+    tuple_value_t *rtuple = tuple_coerce(r);
+    int64_t min_size = ltuple->size < rtuple->size ? ltuple->size : rtuple->size;
+
+    for (int64_t i = 0; i < min_size; i++) {
+        int comparison = compare(ltuple->values[i], rtuple->values[i]);
+        if (exception_occurred()) {
+            return 0;
+        }
+        if (comparison != 0) {
+            return comparison;
+        }
+    }
+    return (ltuple->size > rtuple->size) - (ltuple->size < rtuple->size);
+}
+
+bool tuple_eq(value_t *l, value_t *r) {
+    tuple_value_t *ltuple = tuple_coerce(l);
+    tuple_value_t *rtuple = tuple_coerce(r);
+
+    if (ltuple->size != rtuple->size) {
+        return false;
+    }
+
+    /* Tuples used as keys have usually been hashed already, so most
+     * mismatches are caught without looking at the elements. */
+    if (ltuple->hashed && rtuple->hashed && ltuple->hash != rtuple->hash) {
+        return false;
+    }
+
+    for (int64_t i = 0; i < ltuple->size; i++) {
+        bool equals = ref_eq(ltuple->values[i], rtuple->values[i]);
+        if (exception_occurred() || !equals) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*! Implements membership tests for tuples, comparing elements with ==. */
+bool tuple_contains(value_t *obj, reference_t item) {
+    tuple_value_t *tuple = tuple_coerce(obj);
+
+    for (int64_t i = 0; i < tuple->size; i++) {
+        if (ref_eq(tuple->values[i], item)) {
+            return true;
+        }
+        if (exception_occurred()) {
+            return false;
+        }
+    }
+    return false;
+}
+
+/*! Implements subscript access for tuples. */
+reference_t tuple_subscr_get(value_t *obj, reference_t subscr) {
+    tuple_value_t *tuple = tuple_coerce(obj);
+
+    value_t *index = deref(subscr);
+    if (index->type != VAL_INTEGER) {
+        exception_set(EXC_TYPE_ERROR, "tuple indices must be integers");
+        return NULL_REF;
+    }
+
+    /* Negative subscripts count from the end. */
+    int64_t idx = ((integer_value_t *) index)->integer_value;
+    if (idx < 0) {
+        idx += tuple->size;
+    }
+    if (idx < 0 || idx >= tuple->size) {
+        exception_set(EXC_INDEX_ERROR, "tuple index out of bounds");
+        return NULL_REF;
+    }
+
+    incref(tuple->values[idx]);
+    return tuple->values[idx];
+}
+
+/*! Implements printing of tuples. A tuple of one element keeps its comma. */
+void tuple_print(value_t *obj, sink_t *sink, size_t depth) {
+    /* If we have reached the maximum recursion depth, print a placeholder. */
+    if (depth == 0) {
+        sink_puts(sink, "...");
+        return;
+    }
+
+    tuple_value_t *tuple = tuple_coerce(obj);
+
+    sink_putc(sink, '(');
+    for (int64_t i = 0; i < tuple->size; i++) {
+        if (i > 0) {
+            sink_puts(sink, ", ");
+        }
+        ref_write_repr(tuple->values[i], sink, depth - 1);
+    }
+    if (tuple->size == 1) {
+        sink_putc(sink, ',');
+    }
+    sink_putc(sink, ')');
+}
+
+//// HELPER FUNCTIONS ////
+
+/*!
+ * Returns a new reference to a tuple of the given values, which are incref'd,
+ * or NULL_REF on error.
+ */
+reference_t tuple_pack(reference_t *values, size_t size) {
+    reference_t ref = make_reference_tuple(size);
+    if (ref != NULL_REF) {
+        tuple_value_t *tuple = (tuple_value_t *) deref(ref);
+        for (size_t i = 0; i < size; i++) {
+            incref(values[i]);
+            tuple->values[i] = values[i];
+        }
+    }
+    return ref;
+}
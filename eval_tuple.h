@@ -0,0 +1,24 @@
+#ifndef EVAL_TUPLE_H
+#define EVAL_TUPLE_H
+
+#include <stdbool.h>
+
+#include "format.h"
+#include "types.h"
+
+// TYPE INTERFACE FUNCTIONS //
+
+bool tuple_bool(value_t *obj);
+int64_t tuple_len(value_t *obj);
+uint64_t tuple_hash(value_t *obj);
+int tuple_cmp(value_t *l, value_t *r);
+bool tuple_eq(value_t *l, value_t *r);
+bool tuple_contains(value_t *obj, reference_t item);
+reference_t tuple_subscr_get(value_t *obj, reference_t subscr);
+void tuple_print(value_t *obj, sink_t *sink, size_t depth);
+
+// HELPER FUNCTIONS //
+
+reference_t tuple_pack(reference_t *values, size_t size);
+
+#endif /* EVAL_TUPLE_H */
@@ -1,15 +1,25 @@
 #include "eval_types.h"
 
 #include <assert.h>
-#include <inttypes.h>
+#include <math.h>
 #include <stdint.h>
 #include <string.h>
 
 #include "config.h"
+#include "eval_array.h"
+#include "eval_bigint.h"
+#include "eval_bytes.h"
 #include "eval_dict.h"
 #include "eval_list.h"
+#include "eval_pmap.h"
+#include "eval_record.h"
 #include "eval_refs.h"
+#include "eval_set.h"
+#include "eval_tuple.h"
+#include "eval_vector.h"
+#include "eval_weakref.h"
 #include "exception.h"
+#include "format.h"
 #include "refs.h"
 
 //// TYPE-SPECIFIC FUNCTIONS ////
@@ -19,9 +29,21 @@ const char *type_to_str(value_type_t type) {
         case VAL_NONE:    return "NoneType";
         case VAL_BOOL:    return "bool";
         case VAL_INTEGER: return "int";
+        case VAL_BIGINT:  return "int";
+        case VAL_FLOAT:   return "float";
         case VAL_STRING:  return "str";
         case VAL_LIST:    return "list";
         case VAL_DICT:    return "dict";
+        case VAL_RECORD:  return "record";
+        case VAL_SET:     return "set";
+        case VAL_VECTOR:  return "vector";
+        case VAL_PMAP:    return "pmap";
+        case VAL_TUPLE:   return "tuple";
+        case VAL_BYTES:   return "bytes";
+        case VAL_BYTEARRAY: return "bytearray";
+        case VAL_FLOAT_ARRAY: return "array";
+        case VAL_WEAKREF: return "weakref";
+        case VAL_WEAKDICT: return "weakdict";
         default:          return "<unknown>";
     }
 }
@@ -68,22 +90,22 @@ static bool singleton_eq(value_t *l, value_t *r) {
 }
 
 /*! Implements printing for singletons (None and boolean values). */
-static void singleton_print(value_t *obj, FILE *stream, size_t depth) {
+static void singleton_print(value_t *obj, sink_t *sink, size_t depth) {
     assert(obj->type == VAL_NONE || obj->type == VAL_BOOL);
 
     /* If we have reached the maximum recursion depth, print a placeholder. */
     if (depth == 0) {
-        fprintf(stream, "...");
+        sink_puts(sink, "...");
         return;
     }
 
     /* Otherwise, print an appropriate textual representation. */
     if (obj == deref(NONE_REF)) {
-        fprintf(stream, "None");
+        sink_puts(sink, "None");
     } else if (obj == deref(TRUE_REF)) {
-        fprintf(stream, "True");
+        sink_puts(sink, "True");
     } else if (obj == deref(FALSE_REF)) {
-        fprintf(stream, "False");
+        sink_puts(sink, "False");
     } else {
         /* If we reach here then something is very wrong. Memory corruption? */
         UNREACHABLE();
@@ -112,13 +134,35 @@ static bool integer_bool(value_t *obj) {
     return integer->integer_value != 0;
 }
 
+/*!
+ * Integers are hashed with the 64-bit finalizer from MurmurHash3, so that
+ * every bit of the integer affects the low bits dicts use to pick a bucket.
+ * Otherwise keys that are multiples of a table's capacity would all collide.
+ */
+static uint64_t hash_int64(int64_t value) {
+    uint64_t hash = value;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
 static uint64_t integer_hash(value_t *obj) {
-    return integer_coerce(obj)->integer_value;
+    return hash_int64(integer_coerce(obj)->integer_value);
 }
 
+/*
+ * Integer arithmetic is done in 64 bits, and only hands over to the bigint
+ * functions in eval_bigint.c, which accept integers too, if that overflows.
+ */
+
 static reference_t integer_unaryop_negate(value_t *l, value_t *r) {
-    (void) r;
-    return make_reference_int(-integer_coerce(l)->integer_value);
+    int64_t result;
+    if (__builtin_sub_overflow(0, integer_coerce(l)->integer_value, &result)) {
+        return bigint_unaryop_negate(l, r);
+    }
+    return make_reference_int(result);
 }
 static reference_t integer_unaryop_identity(value_t *l, value_t *r) {
     (void) r;
@@ -135,31 +179,56 @@ static bool integer_eq(value_t *l, value_t *r) {
 }
 
 static reference_t integer_binop_add(value_t *l, value_t *r) {
-    return make_reference_int(
-            integer_coerce(l)->integer_value + integer_coerce(r)->integer_value);
+    int64_t result;
+    if (__builtin_add_overflow(integer_coerce(l)->integer_value,
+            integer_coerce(r)->integer_value, &result)) {
+        return bigint_binop_add(l, r);
+    }
+    return make_reference_int(result);
 }
 static reference_t integer_binop_subtract(value_t *l, value_t *r) {
-    return make_reference_int(
-            integer_coerce(l)->integer_value - integer_coerce(r)->integer_value);
+    int64_t result;
+    if (__builtin_sub_overflow(integer_coerce(l)->integer_value,
+            integer_coerce(r)->integer_value, &result)) {
+        return bigint_binop_subtract(l, r);
+    }
+    return make_reference_int(result);
 }
 static reference_t integer_binop_multiply(value_t *l, value_t *r) {
-    return make_reference_int(
-            integer_coerce(l)->integer_value * integer_coerce(r)->integer_value);
+    int64_t result;
+    if (__builtin_mul_overflow(integer_coerce(l)->integer_value,
+            integer_coerce(r)->integer_value, &result)) {
+        return bigint_binop_multiply(l, r);
+    }
+    return make_reference_int(result);
 }
+
+/*!
+ * Division and modulo by zero are errors, and INT64_MIN / -1 is the one
+ * quotient that overflows; the bigint functions deal with both.
+ */
 static reference_t integer_binop_divide(value_t *l, value_t *r) {
-    return make_reference_int(
-            integer_coerce(l)->integer_value / integer_coerce(r)->integer_value);
+    int64_t lval = integer_coerce(l)->integer_value,
+            rval = integer_coerce(r)->integer_value;
+    if (rval == 0 || rval == -1) {
+        return bigint_binop_divide(l, r);
+    }
+    return make_reference_int(lval / rval);
 }
 static reference_t integer_binop_modulo(value_t *l, value_t *r) {
-    return make_reference_int(
-            integer_coerce(l)->integer_value % integer_coerce(r)->integer_value);
+    int64_t lval = integer_coerce(l)->integer_value,
+            rval = integer_coerce(r)->integer_value;
+    if (rval == 0 || rval == -1) {
+        return bigint_binop_modulo(l, r);
+    }
+    return make_reference_int(lval % rval);
 }
 
 /*! Implements printing for integers. */
-static void integer_print(value_t *obj, FILE *stream, size_t depth) {
+static void integer_print(value_t *obj, sink_t *sink, size_t depth) {
     /* If we have reached the maximum recursion depth, print a placeholder. */
     if (depth == 0) {
-        fprintf(stream, "...");
+        sink_puts(sink, "...");
         return;
     }
 
@@ -167,7 +236,169 @@ static void integer_print(value_t *obj, FILE *stream, size_t depth) {
     integer_value_t *integer = integer_coerce(obj);
 
     /* If it is, print an appropriate textual representation. */
-    fprintf(stream, "%" PRIi64, integer->integer_value);
+    sink_int64(sink, integer->integer_value);
+}
+
+// FLOAT FUNCTIONS //
+
+static inline float_value_t *float_coerce(value_t *obj) {
+    assert(obj->type == VAL_FLOAT);
+    return (float_value_t *) obj;
+}
+
+/*! Returns the value of an integer, bigint or float as a double. */
+double number_to_double(value_t *obj) {
+    switch (obj->type) {
+        case VAL_INTEGER:
+            return (double) integer_coerce(obj)->integer_value;
+        case VAL_BIGINT:
+            return bigint_to_double(obj);
+        case VAL_FLOAT:
+            return float_coerce(obj)->float_value;
+        default:
+            UNREACHABLE();
+    }
+}
+
+static bool float_bool(value_t *obj) {
+    return float_coerce(obj)->float_value != 0.0;
+}
+
+/*!
+ * Floats that are equal to an integer hash like it, since they compare equal
+ * to it and so must find the same dict entries. Other floats hash their bits.
+ */
+static uint64_t float_hash(value_t *obj) {
+    double value = float_coerce(obj)->float_value;
+    if (!isfinite(value) || trunc(value) != value) {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return hash_int64(bits);
+    }
+    if (value >= -9223372036854775808.0 && value < 9223372036854775808.0) {
+        return hash_int64((int64_t) value);
+    }
+
+    reference_t ref = bigint_from_double(value);
+    if (ref == NULL_REF) {
+        return 0;
+    }
+    uint64_t hash = bigint_hash(deref(ref));
+    decref(ref);
+    return hash;
+}
+
+/*!
+ * Compares two numbers, at least one of which is a float. Integers are
+ * compared exactly, rather than after rounding them to a double. NaN is
+ * unordered with everything, itself included.
+ */
+static int float_cmp(value_t *l, value_t *r) {
+    if (l->type != VAL_FLOAT) {
+        int comparison = float_cmp(r, l);
+        return comparison == COMPARE_UNORDERED ? comparison : -comparison;
+    }
+
+    double lval = float_coerce(l)->float_value;
+    if (isnan(lval) || (r->type == VAL_FLOAT && isnan(float_coerce(r)->float_value))) {
+        return COMPARE_UNORDERED;
+    }
+    if (r->type == VAL_FLOAT) {
+        double rval = float_coerce(r)->float_value;
+        return (lval > rval) - (lval < rval);
+    }
+    if (isinf(lval)) {
+        return lval > 0 ? 1 : -1;
+    }
+
+    /* Compare the integral part first, and only look at the fraction if that
+     * is equal. Bigints never fit in 64 bits, so against one the integral
+     * part only needs converting when it doesn't either. */
+    double whole = trunc(lval);
+    int comparison;
+    if (whole >= -9223372036854775808.0 && whole < 9223372036854775808.0) {
+        int64_t lint = (int64_t) whole;
+        if (r->type == VAL_INTEGER) {
+            int64_t rint = integer_coerce(r)->integer_value;
+            comparison = (lint > rint) - (lint < rint);
+        } else {
+            comparison = ((bigint_value_t *) r)->negative ? 1 : -1;
+        }
+    } else if (r->type == VAL_INTEGER) {
+        comparison = whole > 0 ? 1 : -1;
+    } else {
+        reference_t ref = bigint_from_double(whole);
+        if (ref == NULL_REF) {
+            return 0;
+        }
+        comparison = bigint_cmp(deref(ref), r);
+        decref(ref);
+    }
+
+    if (comparison == 0) {
+        comparison = (lval > whole) - (lval < whole);
+    }
+    return comparison;
+}
+static bool float_eq(value_t *l, value_t *r) {
+    return float_cmp(l, r) == 0;
+}
+
+/*
+ * Float arithmetic also accepts integers and bigints for either operand,
+ * converting them to the nearest double first.
+ */
+
+static reference_t float_unaryop_negate(value_t *l, value_t *r) {
+    (void) r;
+    return make_reference_float(-float_coerce(l)->float_value);
+}
+static reference_t float_unaryop_identity(value_t *l, value_t *r) {
+    (void) r;
+    return make_reference_float(float_coerce(l)->float_value);
+}
+
+static reference_t float_binop_add(value_t *l, value_t *r) {
+    return make_reference_float(number_to_double(l) + number_to_double(r));
+}
+static reference_t float_binop_subtract(value_t *l, value_t *r) {
+    return make_reference_float(number_to_double(l) - number_to_double(r));
+}
+static reference_t float_binop_multiply(value_t *l, value_t *r) {
+    return make_reference_float(number_to_double(l) * number_to_double(r));
+}
+
+/*!
+ * Division by zero is an error, as it is for integers, rather than giving an
+ * infinity or NaN. Modulo truncates like integer modulo does, so the result
+ * has the sign of the dividend.
+ */
+static reference_t float_binop_divide(value_t *l, value_t *r) {
+    double rval = number_to_double(r);
+    if (rval == 0.0) {
+        exception_set(EXC_ZERO_DIVISION_ERROR, "float division by zero");
+        return NULL_REF;
+    }
+    return make_reference_float(number_to_double(l) / rval);
+}
+static reference_t float_binop_modulo(value_t *l, value_t *r) {
+    double rval = number_to_double(r);
+    if (rval == 0.0) {
+        exception_set(EXC_ZERO_DIVISION_ERROR, "float modulo by zero");
+        return NULL_REF;
+    }
+    return make_reference_float(fmod(number_to_double(l), rval));
+}
+
+/*! Implements printing for floats, as the shortest repr that reads back. */
+static void float_print(value_t *obj, sink_t *sink, size_t depth) {
+    /* If we have reached the maximum recursion depth, print a placeholder. */
+    if (depth == 0) {
+        sink_puts(sink, "...");
+        return;
+    }
+
+    sink_double(sink, float_coerce(obj)->float_value);
 }
 
 // STRING FUNCTIONS //
@@ -181,26 +412,105 @@ static bool string_bool(value_t *obj) {
     return string_coerce(obj)->string_value[0] != '\0';
 }
 
-static uint64_t string_hash(value_t *obj) {
-    /* Adapted from Java's String.hashCode(). */
-    string_value_t *str = string_coerce(obj);
+/*!
+ * Multiplies two words into 128 bits and folds the halves together. This is
+ * the mixing step of hash_bytes.
+ */
+static inline uint64_t hash_mix(uint64_t a, uint64_t b) {
+    __uint128_t product = (__uint128_t) a * b;
+    return (uint64_t) product ^ (uint64_t) (product >> 64);
+}
 
-    uint64_t hash = 1125899906842597UL; // prime
-    for (const char *sp = str->string_value; *sp; sp++) {
-        hash = 31 * hash + *sp;
+/*! Loads 8 bytes from a possibly unaligned address. */
+static inline uint64_t hash_load(const char *p) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+/*!
+ * Returns the hash of length bytes of data. Data is consumed 16 bytes per
+ * step, each word combined with a constant and mixed through a 64x64->128
+ * bit multiply, in the style of wyhash.
+ */
+uint64_t hash_bytes(const char *data, size_t length) {
+    static const uint64_t P0 = 0xa0761d6478bd642fULL;
+    static const uint64_t P1 = 0xe7037ed1a0b428dbULL;
+    static const uint64_t P2 = 0x8ebc6af09c88c6e3ULL;
+
+    uint64_t hash = P0 ^ length;
+    const char *p = data;
+    size_t remaining = length;
+
+    while (remaining >= 16) {
+        hash = hash_mix(hash_load(p) ^ P1, hash_load(p + 8) ^ hash);
+        p += 16;
+        remaining -= 16;
     }
-    return hash;
+    if (remaining >= 8) {
+        hash = hash_mix(hash_load(p) ^ P1, hash ^ P2);
+        p += 8;
+        remaining -= 8;
+    }
+    if (remaining > 0) {
+        uint64_t tail = 0;
+        memcpy(&tail, p, remaining);
+        hash = hash_mix(tail ^ P1, hash ^ P2);
+    }
+
+    return hash_mix(hash ^ P1, length ^ P2);
+}
+
+/*!
+ * Returns the hash of a '\0'-terminated string. This is the same value that
+ * hashing a string value with those contents produces.
+ */
+uint64_t hash_string(const char *str) {
+    return hash_bytes(str, strlen(str));
+}
+
+static uint64_t string_hash(value_t *obj) {
+    string_value_t *str = string_coerce(obj);
+    return hash_bytes(str->string_value, string_length(str));
 }
 
 static int64_t string_len(value_t *obj) {
-    return strlen(string_coerce(obj)->string_value);
+    return string_length(string_coerce(obj));
 }
 
 static int string_cmp(value_t *l, value_t *r) {
-    return strcmp(string_coerce(l)->string_value, string_coerce(r)->string_value);
+    string_value_t *lstr = string_coerce(l);
+    string_value_t *rstr = string_coerce(r);
+    size_t llen = string_length(lstr);
+    size_t rlen = string_length(rstr);
+
+    int result = memcmp(lstr->string_value, rstr->string_value, llen < rlen ? llen : rlen);
+    if (result != 0) {
+        return (result > 0) - (result < 0);
+    }
+    return (llen > rlen) - (llen < rlen);
 }
 static bool string_eq(value_t *l, value_t *r) {
-    return string_cmp(l, r) == 0;
+    string_value_t *lstr = string_coerce(l);
+    string_value_t *rstr = string_coerce(r);
+    size_t length = string_length(lstr);
+
+    /* Different lengths can be ruled out without looking at the contents. */
+    return length == string_length(rstr) &&
+            memcmp(lstr->string_value, rstr->string_value, length) == 0;
+}
+
+/*! Strings contain the strings that are substrings of them. */
+static bool string_contains(value_t *obj, reference_t item) {
+    value_t *needle = deref(item);
+    if (needle->type != VAL_STRING) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "'in <string>' requires string as left operand, not %s",
+                type_to_str(needle->type));
+        return false;
+    }
+    return strstr(string_coerce(obj)->string_value,
+            string_coerce(needle)->string_value) != NULL;
 }
 
 static reference_t string_binop_add(value_t *l, value_t *r) {
@@ -209,25 +519,25 @@ static reference_t string_binop_add(value_t *l, value_t *r) {
             string_coerce(r)->string_value);
 }
 
-static void string_print_gen(const char *format, value_t *obj, FILE *stream, size_t depth) {
+static void string_print_repr(value_t *obj, sink_t *sink, size_t depth) {
     /* If we have reached the maximum recursion depth, print a placeholder. */
     if (depth == 0) {
-        fprintf(stream, "...");
+        sink_puts(sink, "...");
         return;
     }
 
-    /* Otherwise, ensure that this is actually a string_value_t. */
-    string_value_t *string = string_coerce(obj);
-
-    /* If it is, print it out. */
-    fprintf(stream, format, string->string_value);
+    /* Otherwise, print the string surrounded by quotes. */
+    sink_quoted(sink, string_coerce(obj)->string_value);
 }
+static void string_print(value_t *obj, sink_t *sink, size_t depth) {
+    /* If we have reached the maximum recursion depth, print a placeholder. */
+    if (depth == 0) {
+        sink_puts(sink, "...");
+        return;
+    }
 
-static void string_print_repr(value_t *obj, FILE *stream, size_t depth) {
-    string_print_gen("\"%s\"", obj, stream, depth);
-}
-static void string_print(value_t *obj, FILE *stream, size_t depth) {
-    string_print_gen("%s", obj, stream, depth);
+    /* Otherwise, print the string as-is. */
+    sink_puts(sink, string_coerce(obj)->string_value);
 }
 
 //// TYPE FUNCTION LISTINGS ////
@@ -257,6 +567,7 @@ typedef struct func_table {
 
     int         (*f_cmp       )(value_t *l, value_t *r);
     bool        (*f_eq        )(value_t *l, value_t *r);
+    bool        (*f_contains  )(value_t *obj, reference_t item);
 
     builtin_table_t f_builtins;
 
@@ -264,8 +575,8 @@ typedef struct func_table {
     void        (*f_subscr_set)(value_t *obj, reference_t subscript, reference_t value);
     void        (*f_subscr_del)(value_t *obj, reference_t subscript);
 
-    void        (*f_print_repr)(value_t *obj, FILE *stream, size_t depth);
-    void        (*f_print     )(value_t *obj, FILE *stream, size_t depth);
+    void        (*f_print_repr)(value_t *obj, sink_t *sink, size_t depth);
+    void        (*f_print     )(value_t *obj, sink_t *sink, size_t depth);
 } func_table_t;
 
 static func_table_t table[NUM_TYPES];
@@ -306,12 +617,65 @@ void eval_types_init() {
         .f_print_repr = &integer_print,
         .f_print      = &integer_print,
     };
+    table[VAL_BIGINT] = (func_table_t) {
+        .f_bool         = &bigint_bool,
+        .f_hash         = &bigint_hash,
+        .f_cmp          = &bigint_cmp,
+        .f_eq           = &bigint_eq,
+        .f_builtins     = (builtin_table_t) {
+            .u_negate   = &bigint_unaryop_negate,
+            .u_identity = &bigint_unaryop_identity,
+            .b_add      = &bigint_binop_add,
+            .b_subtract = &bigint_binop_subtract,
+            .b_multiply = &bigint_binop_multiply,
+            .b_divide   = &bigint_binop_divide,
+            .b_modulo   = &bigint_binop_modulo,
+        },
+        .f_print_repr = &bigint_print,
+        .f_print      = &bigint_print,
+    };
+    table[VAL_FLOAT] = (func_table_t) {
+        .f_bool         = &float_bool,
+        .f_hash         = &float_hash,
+        .f_cmp          = &float_cmp,
+        .f_eq           = &float_eq,
+        .f_builtins     = (builtin_table_t) {
+            .u_negate   = &float_unaryop_negate,
+            .u_identity = &float_unaryop_identity,
+            .b_add      = &float_binop_add,
+            .b_subtract = &float_binop_subtract,
+            .b_multiply = &float_binop_multiply,
+            .b_divide   = &float_binop_divide,
+            .b_modulo   = &float_binop_modulo,
+        },
+        .f_print_repr = &float_print,
+        .f_print      = &float_print,
+    };
+    table[VAL_FLOAT_ARRAY] = (func_table_t) {
+        .f_bool         = &array_bool,
+        .f_len          = &array_len,
+        .f_eq           = &array_eq,
+        .f_contains     = &array_contains,
+        .f_builtins     = (builtin_table_t) {
+            .u_negate   = &array_unaryop_negate,
+            .u_identity = &array_unaryop_identity,
+            .b_add      = &array_binop_add,
+            .b_subtract = &array_binop_subtract,
+            .b_multiply = &array_binop_multiply,
+            .b_divide   = &array_binop_divide,
+        },
+        .f_subscr_get   = &array_subscr_get,
+        .f_subscr_set   = &array_subscr_set,
+        .f_print_repr   = &array_print,
+        .f_print        = &array_print,
+    };
     table[VAL_STRING] = (func_table_t) {
         .f_bool       = &string_bool,
         .f_len        = &string_len,
         .f_hash       = &string_hash,
         .f_cmp        = &string_cmp,
         .f_eq         = &string_eq,
+        .f_contains   = &string_contains,
         .f_builtins   = (builtin_table_t) {
             .b_add    = &string_binop_add
         },
@@ -323,6 +687,7 @@ void eval_types_init() {
         .f_len        = &list_len,
         .f_cmp        = &list_cmp,
         .f_eq         = &list_eq,
+        .f_contains   = &list_contains,
         .f_subscr_get = &list_subscr_get,
         .f_subscr_set = &list_subscr_set,
         .f_subscr_del = &list_subscr_del,
@@ -333,12 +698,102 @@ void eval_types_init() {
         .f_bool       = &dict_bool,
         .f_len        = &dict_len,
         .f_eq         = &dict_eq,
+        .f_contains   = &dict_contains,
         .f_subscr_get = &dict_subscr_get,
         .f_subscr_set = &dict_subscr_set,
         .f_subscr_del = &dict_subscr_del,
         .f_print_repr = &dict_print,
         .f_print      = &dict_print
     };
+    table[VAL_RECORD] = (func_table_t) {
+        .f_bool       = &record_bool,
+        .f_len        = &record_len,
+        .f_eq         = &record_eq,
+        .f_subscr_get = &record_subscr_get,
+        .f_subscr_set = &record_subscr_set,
+        .f_print_repr = &record_print,
+        .f_print      = &record_print
+    };
+    table[VAL_SET] = (func_table_t) {
+        .f_bool       = &set_bool,
+        .f_len        = &set_len,
+        .f_eq         = &set_eq,
+        .f_contains   = &set_contains,
+        .f_print_repr = &set_print,
+        .f_print      = &set_print
+    };
+    table[VAL_TUPLE] = (func_table_t) {
+        .f_bool       = &tuple_bool,
+        .f_len        = &tuple_len,
+        .f_hash       = &tuple_hash,
+        .f_cmp        = &tuple_cmp,
+        .f_eq         = &tuple_eq,
+        .f_contains   = &tuple_contains,
+        .f_subscr_get = &tuple_subscr_get,
+        .f_print_repr = &tuple_print,
+        .f_print      = &tuple_print
+    };
+    table[VAL_BYTES] = (func_table_t) {
+        .f_bool       = &bytes_bool,
+        .f_len        = &bytes_len,
+        .f_hash       = &bytes_hash,
+        .f_cmp        = &bytes_cmp,
+        .f_eq         = &bytes_eq,
+        .f_contains   = &bytes_contains,
+        .f_builtins   = (builtin_table_t) {
+            .b_add    = &bytes_binop_add
+        },
+        .f_subscr_get = &bytes_subscr_get,
+        .f_print_repr = &bytes_print,
+        .f_print      = &bytes_print
+    };
+    table[VAL_BYTEARRAY] = (func_table_t) {
+        .f_bool       = &bytes_bool,
+        .f_len        = &bytes_len,
+        .f_cmp        = &bytes_cmp,
+        .f_eq         = &bytes_eq,
+        .f_contains   = &bytes_contains,
+        .f_builtins   = (builtin_table_t) {
+            .b_add    = &bytes_binop_add
+        },
+        .f_subscr_get = &bytes_subscr_get,
+        .f_subscr_set = &bytearray_subscr_set,
+        .f_print_repr = &bytes_print,
+        .f_print      = &bytes_print
+    };
+    table[VAL_VECTOR] = (func_table_t) {
+        .f_bool       = &vector_bool,
+        .f_len        = &vector_len,
+        .f_eq         = &vector_eq,
+        .f_contains   = &vector_contains,
+        .f_subscr_get = &vector_subscr_get,
+        .f_print_repr = &vector_print,
+        .f_print      = &vector_print
+    };
+    table[VAL_WEAKREF] = (func_table_t) {
+        .f_eq         = &weakref_eq,
+        .f_print_repr = &weakref_print,
+        .f_print      = &weakref_print
+    };
+    table[VAL_WEAKDICT] = (func_table_t) {
+        .f_bool       = &weakdict_bool,
+        .f_len        = &weakdict_len,
+        .f_contains   = &weakdict_contains,
+        .f_subscr_get = &weakdict_subscr_get,
+        .f_subscr_set = &weakdict_subscr_set,
+        .f_subscr_del = &weakdict_subscr_del,
+        .f_print_repr = &weakdict_print,
+        .f_print      = &weakdict_print
+    };
+    table[VAL_PMAP] = (func_table_t) {
+        .f_bool       = &pmap_bool,
+        .f_len        = &pmap_len,
+        .f_eq         = &pmap_eq,
+        .f_contains   = &pmap_contains,
+        .f_subscr_get = &pmap_subscr_get,
+        .f_print_repr = &pmap_print,
+        .f_print      = &pmap_print
+    };
 }
 
 //// GENERIC DISPATCH FUNCTIONS ////
@@ -433,6 +888,36 @@ static const char *builtin_to_str(NodeExprBuiltinType type) {
     }
 }
 
+/*!
+ * Returns how wide a numeric type is, or 0 if the type isn't numeric. The
+ * functions of each numeric type also take the numeric types narrower than it.
+ */
+static int numeric_rank(value_type_t type) {
+    switch (type) {
+        case VAL_INTEGER:     return 1;
+        case VAL_BIGINT:      return 2;
+        case VAL_FLOAT:       return 3;
+        case VAL_FLOAT_ARRAY: return 4;
+        default:              return 0;
+    }
+}
+
+/*!
+ * Returns the type whose functions handle an operation on values of the two
+ * given types, or NUM_TYPES if there is none. This is their shared type, or
+ * the wider of two different numeric types.
+ */
+static value_type_t operand_type(value_type_t l, value_type_t r) {
+    if (l == r) {
+        return l;
+    }
+    int lrank = numeric_rank(l), rrank = numeric_rank(r);
+    if (lrank == 0 || rrank == 0) {
+        return NUM_TYPES;
+    }
+    return lrank > rrank ? l : r;
+}
+
 /*!
  * Return the result of executing the specified builtin operation.
  */
@@ -443,9 +928,10 @@ reference_t ref_builtin(NodeExprBuiltinType type, reference_t l, reference_t r)
 
     /* First, we make the simplifying assumption that the two values must have
      * the same type, which holds for all operations current available in
-     * Subpython. Then, if the appropriate builtin function is not set for this
-     * type, error out. */
-    if (lobj->type != robj->type || table[lobj->type].f_builtins.f_table[type] == NULL) {
+     * Subpython besides mixing numeric types. Then, if the appropriate
+     * builtin function is not set for this type, error out. */
+    value_type_t op_type = operand_type(lobj->type, robj->type);
+    if (op_type == NUM_TYPES || table[op_type].f_builtins.f_table[type] == NULL) {
         if (is_unary_builtin(type)) {
             exception_set_format(EXC_TYPE_ERROR,
                     "bad operand type for unary %s: '%s'",
@@ -459,13 +945,14 @@ reference_t ref_builtin(NodeExprBuiltinType type, reference_t l, reference_t r)
     }
 
     /* Otherwise, dispatch to function. */
-    return table[lobj->type].f_builtins.f_table[type](lobj, robj);
+    return table[op_type].f_builtins.f_table[type](lobj, robj);
 }
 
 /*!
  * Compares the values at two references.
- * Return value is negative if the first is less,
- * positive if the first is greater, and 0 if they are equal.
+ * Return value is -1 if the first is less,
+ * 1 if the first is greater, and 0 if they are equal.
+ * It is COMPARE_UNORDERED if none of these hold, as with NaN.
  */
 int compare(reference_t l, reference_t r) {
     /* Attempt to dereference the provided references. */
@@ -473,8 +960,9 @@ int compare(reference_t l, reference_t r) {
     value_t *robj = deref(r);
 
     /* If the operands have different types or can't be compared, error out. */
-    int (*f_cmp)(value_t *, value_t *) = table[lobj->type].f_cmp;
-    if (f_cmp == NULL || lobj->type != robj->type) {
+    value_type_t op_type = operand_type(lobj->type, robj->type);
+    int (*f_cmp)(value_t *, value_t *) = op_type == NUM_TYPES ? NULL : table[op_type].f_cmp;
+    if (f_cmp == NULL) {
         exception_set_format(EXC_TYPE_ERROR,
                 "type(s) are not comparable: '%s' and '%s'",
                 type_to_str(lobj->type), type_to_str(robj->type));
@@ -484,11 +972,10 @@ int compare(reference_t l, reference_t r) {
     return f_cmp(lobj, robj);
 }
 
-/*! Returns the result of executing the builtin compare operation. */
-reference_t ref_compare(NodeExprBuiltinType type, reference_t l, reference_t r) {
-    int comparison = compare(l, r);
-    if (exception_occurred()) {
-        return NULL_REF;
+/*! Converts the result of compare into the result of a comparison operator. */
+static reference_t comparison_result(NodeExprBuiltinType type, int comparison) {
+    if (comparison == COMPARE_UNORDERED) {
+        return bool_ref(false);
     }
 
     switch (type) {
@@ -507,27 +994,58 @@ reference_t ref_compare(NodeExprBuiltinType type, reference_t l, reference_t r)
     }
 }
 
+/*! Returns the result of executing the builtin compare operation. */
+reference_t ref_compare(NodeExprBuiltinType type, reference_t l, reference_t r) {
+    int comparison = compare(l, r);
+    if (exception_occurred()) {
+        return NULL_REF;
+    }
+
+    return comparison_result(type, comparison);
+}
+
 /*! Returns the result of comparing two objects for equality. */
 bool ref_eq(reference_t l, reference_t r) {
     /* Attempt to dereference the provided references. */
     value_t *lobj = deref(l);
     value_t *robj = deref(r);
 
-    /* If the operands have different types, then return false. */
-    if (lobj->type != robj->type) {
+    /* If the operands have different types, then return false, unless they
+     * are both numbers. */
+    value_type_t op_type = operand_type(lobj->type, robj->type);
+    if (op_type == NUM_TYPES) {
         return false;
     }
 
     /* If the object type doesn't support equality comparison, then error
      * out. */
-    if (table[lobj->type].f_eq == NULL) {
+    if (table[op_type].f_eq == NULL) {
         exception_set_format(EXC_TYPE_ERROR,
                 "unsupported operand types for '==': '%s' and '%s'",
                 type_to_str(lobj->type), type_to_str(robj->type));
         return false;
     }
 
-    return table[lobj->type].f_eq(lobj, robj);
+    return table[op_type].f_eq(lobj, robj);
+}
+
+/*!
+ * Return whether a container holds an item: an element of a list, a key of a
+ * dict, or a substring of a string.
+ */
+bool ref_contains(reference_t r, reference_t item) {
+    /* Attempt to dereference the provided reference. */
+    value_t *obj = deref(r);
+
+    /* If the contains function is not set, then error out. */
+    if (table[obj->type].f_contains == NULL) {
+        exception_set_format(EXC_TYPE_ERROR,
+                "argument of type '%s' is not iterable", type_to_str(obj->type));
+        return false;
+    }
+
+    /* Otherwise, dispatch to function. */
+    return table[obj->type].f_contains(obj, item);
 }
 
 /*!
@@ -584,11 +1102,101 @@ void ref_subscr_del(reference_t r, reference_t subscr) {
     table[obj->type].f_subscr_del(obj, subscr);
 }
 
+//// INLINE CACHED DISPATCH ////
+
+/*
+ * These behave exactly like the functions above, but take the inline cache of
+ * the AST node performing the operation. On a hit, the handler is called after
+ * a single type check. On a miss, the handler is looked up in the type's
+ * function table and cached; if there isn't one, the uncached function is
+ * called to report the error.
+ */
+
+/*! Cached version of ref_builtin, for arithmetic and unary operators. */
+reference_t ref_builtin_cached(InlineCache *cache, NodeExprBuiltinType type,
+        reference_t l, reference_t r) {
+    value_t *lobj = deref(l);
+    value_t *robj = deref(r);
+
+    if (lobj->type == cache->type && robj->type == cache->type) {
+        return cache->builtin(lobj, robj);
+    }
+
+    if (lobj->type != robj->type || table[lobj->type].f_builtins.f_table[type] == NULL) {
+        return ref_builtin(type, l, r);
+    }
+    cache->type = lobj->type;
+    cache->builtin = table[lobj->type].f_builtins.f_table[type];
+    return cache->builtin(lobj, robj);
+}
+
+/*! Cached version of compare, for the ordering operators. */
+int compare_cached(InlineCache *cache, reference_t l, reference_t r) {
+    value_t *lobj = deref(l);
+    value_t *robj = deref(r);
+
+    if (lobj->type != cache->type || robj->type != cache->type) {
+        if (lobj->type != robj->type || table[lobj->type].f_cmp == NULL) {
+            return compare(l, r);
+        }
+        cache->type = lobj->type;
+        cache->cmp = table[lobj->type].f_cmp;
+    }
+    return cache->cmp(lobj, robj);
+}
+
+/*! Cached version of ref_eq. */
+bool ref_eq_cached(InlineCache *cache, reference_t l, reference_t r) {
+    value_t *lobj = deref(l);
+    value_t *robj = deref(r);
+
+    if (lobj->type == cache->type && robj->type == cache->type) {
+        return cache->eq(lobj, robj);
+    }
+
+    if (lobj->type != robj->type || table[lobj->type].f_eq == NULL) {
+        return ref_eq(l, r);
+    }
+    cache->type = lobj->type;
+    cache->eq = table[lobj->type].f_eq;
+    return cache->eq(lobj, robj);
+}
+
+/*! Cached version of ref_subscr_get. */
+reference_t ref_subscr_get_cached(InlineCache *cache, reference_t r, reference_t subscr) {
+    value_t *obj = deref(r);
+
+    if (obj->type != cache->type) {
+        if (table[obj->type].f_subscr_get == NULL) {
+            return ref_subscr_get(r, subscr);
+        }
+        cache->type = obj->type;
+        cache->subscr_get = table[obj->type].f_subscr_get;
+    }
+    return cache->subscr_get(obj, subscr);
+}
+
+/*! Cached version of ref_subscr_set. */
+void ref_subscr_set_cached(InlineCache *cache, reference_t r, reference_t subscr,
+        reference_t value) {
+    value_t *obj = deref(r);
+
+    if (obj->type != cache->type) {
+        if (table[obj->type].f_subscr_set == NULL) {
+            ref_subscr_set(r, subscr, value);
+            return;
+        }
+        cache->type = obj->type;
+        cache->subscr_set = table[obj->type].f_subscr_set;
+    }
+    cache->subscr_set(obj, subscr, value);
+}
+
 /*!
- * Print the provided reference to the provided stream, recursing to some
- * limited depth.
+ * Write the repr of the provided reference to the provided sink, recursing to
+ * some limited depth.
  */
-void ref_print_repr(reference_t r, FILE *stream, size_t depth) {
+void ref_write_repr(reference_t r, sink_t *sink, size_t depth) {
     /* Attempt to dereference the provided reference. */
     value_t *obj = deref(r);
 
@@ -601,14 +1209,14 @@ void ref_print_repr(reference_t r, FILE *stream, size_t depth) {
     }
 
     /* Otherwise, dispatch to function. */
-    table[obj->type].f_print_repr(obj, stream, depth);
+    table[obj->type].f_print_repr(obj, sink, depth);
 }
 
 /*!
- * Print the provided reference to the provided stream, recursing to some
+ * Write the provided reference to the provided sink, recursing to some
  * limited depth.
  */
-void ref_print(reference_t r, FILE *stream, size_t depth) {
+void ref_write(reference_t r, sink_t *sink, size_t depth) {
     /* Attempt to dereference the provided reference. */
     value_t *obj = deref(r);
 
@@ -621,7 +1229,27 @@ void ref_print(reference_t r, FILE *stream, size_t depth) {
     }
 
     /* Otherwise, dispatch to function. */
-    table[obj->type].f_print(obj, stream, depth);
+    table[obj->type].f_print(obj, sink, depth);
+}
+
+/*!
+ * Print the repr of the provided reference to the provided stream, recursing
+ * to some limited depth.
+ */
+void ref_print_repr(reference_t r, FILE *stream, size_t depth) {
+    sink_t sink;
+    sink_init_stream(&sink, stream);
+    ref_write_repr(r, &sink, depth);
+}
+
+/*!
+ * Print the provided reference to the provided stream, recursing to some
+ * limited depth.
+ */
+void ref_print(reference_t r, FILE *stream, size_t depth) {
+    sink_t sink;
+    sink_init_stream(&sink, stream);
+    ref_write(r, &sink, depth);
 }
 
 /*! Print as in ref_print_repr but with an additional newline. */
@@ -630,7 +1258,7 @@ void ref_println_repr(reference_t r, FILE *stream, size_t depth) {
     ref_print_repr(r, stream, depth);
 
     /* Then a newline. */
-    fprintf(stream, "\n");
+    putc('\n', stream);
 }
 /*! Print as in ref_print but with an additional newline. */
 void ref_println(reference_t r, FILE *stream, size_t depth) {
@@ -638,5 +1266,40 @@ void ref_println(reference_t r, FILE *stream, size_t depth) {
     ref_print(r, stream, depth);
 
     /* Then a newline. */
-    fprintf(stream, "\n");
+    putc('\n', stream);
+}
+
+/*!
+ * Returns a new string reference holding the output of writing r with the
+ * given writer. The text is accumulated in a heap buffer and copied into a
+ * single right-sized string value.
+ */
+static reference_t ref_to_string(reference_t r,
+        void (*writer)(reference_t, sink_t *, size_t)) {
+    sink_t sink;
+    sink_init_buffer(&sink);
+    writer(r, &sink, MAX_DEPTH);
+
+    reference_t result = NULL_REF;
+    if (!exception_occurred()) {
+        result = make_reference_string_buffer(sink.buffer, sink.length);
+    }
+
+    sink_destroy(&sink);
+    return result;
+}
+
+/*! Returns a new reference to the result of calling str() on r. */
+reference_t ref_str(reference_t r) {
+    /* Strings are immutable, so str() of a string can just share it. */
+    if (deref(r)->type == VAL_STRING) {
+        incref(r);
+        return r;
+    }
+    return ref_to_string(r, ref_write);
+}
+
+/*! Returns a new reference to the result of calling repr() on r. */
+reference_t ref_repr(reference_t r) {
+    return ref_to_string(r, ref_write_repr);
 }
@@ -4,15 +4,26 @@
 #include <stdio.h>
 
 #include "ast.h"
+#include "format.h"
 #include "types.h"
 
 /*! Max depth to print to. */
 #define MAX_DEPTH 4
 
+/*!
+ * What compare returns for values that are unordered, such as NaN and any
+ * number. Every comparison operator is false for them. Ordered values
+ * compare as -1, 0 or 1, so this can't be mistaken for an ordering.
+ */
+#define COMPARE_UNORDERED 2
+
 //// TYPE SPECIFIC FUNCTIONS
 
 reference_t singleton_to_ref(SingletonType type);
 reference_t bool_ref(bool value);
+uint64_t hash_bytes(const char *data, size_t length);
+uint64_t hash_string(const char *str);
+double number_to_double(value_t *obj);
 
 //// GENERIC REFERENCE FUNCTIONS ////
 
@@ -35,15 +46,30 @@ reference_t ref_builtin(NodeExprBuiltinType type, reference_t l, reference_t r);
 int compare(reference_t l, reference_t r);
 reference_t ref_compare(NodeExprBuiltinType type, reference_t l, reference_t r);
 bool ref_eq(reference_t l, reference_t r);
+bool ref_contains(reference_t r, reference_t item);
 
 reference_t ref_subscr_get(reference_t r, reference_t subscr);
 void ref_subscr_set(reference_t r, reference_t subscr, reference_t value);
 void ref_subscr_del(reference_t r, reference_t subscr);
 
+reference_t ref_builtin_cached(InlineCache *cache, NodeExprBuiltinType type,
+        reference_t l, reference_t r);
+int compare_cached(InlineCache *cache, reference_t l, reference_t r);
+bool ref_eq_cached(InlineCache *cache, reference_t l, reference_t r);
+reference_t ref_subscr_get_cached(InlineCache *cache, reference_t r, reference_t subscr);
+void ref_subscr_set_cached(InlineCache *cache, reference_t r, reference_t subscr,
+        reference_t value);
+
+void ref_write(reference_t r, sink_t *sink, size_t depth);
+void ref_write_repr(reference_t r, sink_t *sink, size_t depth);
+
 void ref_print(reference_t r, FILE *stream, size_t depth);
 void ref_println(reference_t r, FILE *stream, size_t depth);
 
 void ref_print_repr(reference_t r, FILE *stream, size_t depth);
 void ref_println_repr(reference_t r, FILE *stream, size_t depth);
 
+reference_t ref_str(reference_t r);
+reference_t ref_repr(reference_t r);
+
 #endif /* EVAL_TYPES_H */
@@ -0,0 +1,399 @@
+#include "eval_vector.h"
+
+#include <assert.h>
+#include "eval_refs.h"
+#include "eval_types.h"
+#include "exception.h"
+#include "refs.h"
+
+/*! The number of index bits used at each level of a vector's trie. */
+#define VECTOR_BITS 5
+
+/*! The most children a node of a vector's trie can have. */
+#define VECTOR_BRANCH (1 << VECTOR_BITS)
+
+#define VECTOR_MASK (VECTOR_BRANCH - 1)
+
+static inline vector_value_t *vector_coerce(value_t *obj) {
+    assert(obj->type == VAL_VECTOR);
+    return (vector_value_t *) obj;
+}
+
+static inline ref_array_value_t *vector_node(reference_t node) {
+    value_t *obj = deref(node);
+    assert(obj->type == VAL_REF_ARRAY);
+    return (ref_array_value_t *) obj;
+}
+
+/*!
+ * Turns a subscript into an index into the vector, counting from the end if
+ * it is negative. Sets an exception and returns -1 if it is not a valid index.
+ */
+static int64_t vector_coerce_subscript(vector_value_t *vector, reference_t subscr) {
+    value_t *obj = deref(subscr);
+    if (obj->type != VAL_INTEGER) {
+        exception_set(EXC_TYPE_ERROR, "vector indices must be integers");
+        return -1;
+    }
+
+    int64_t idx = ((integer_value_t *) obj)->integer_value;
+    if (idx < 0) {
+        idx += vector->size;
+    }
+    if (idx < 0 || idx >= vector->size) {
+        exception_set(EXC_INDEX_ERROR, "vector index out of bounds");
+        return -1;
+    }
+    return idx;
+}
+
+/*! Returns a borrowed reference to the element at a valid index. */
+static reference_t vector_peek(vector_value_t *vector, int64_t idx) {
+    ref_array_value_t *node = vector_node(vector->root);
+    for (int64_t shift = vector->shift; shift > 0; shift -= VECTOR_BITS) {
+        node = vector_node(node->values[(idx >> shift) & VECTOR_MASK]);
+    }
+    return node->values[idx & VECTOR_MASK];
+}
+
+/*!
+ * Returns a new reference to a vector with the given trie, which is moved into
+ * it, or NULL_REF on error. The trie is released if the vector can't be
+ * allocated.
+ */
+static reference_t vector_with_root(int64_t size, int64_t shift, reference_t root) {
+    reference_t ref = make_reference_vector();
+    if (ref == NULL_REF) {
+        decref(root);
+        return NULL_REF;
+    }
+
+    vector_value_t *vector = (vector_value_t *) deref(ref);
+    vector->size = size;
+    vector->shift = root == NULL_REF ? 0 : shift;
+    vector->root = root;
+    return ref;
+}
+
+//// PATH COPYING ////
+
+/*!
+ * Returns a new reference to a copy of the subtrie at node, with the element
+ * at idx set to value, or NULL_REF on error. node may be NULL_REF, or have too
+ * few children to contain idx, when idx is one past the end of the vector;
+ * the missing nodes on the path are created. Every other node is shared with
+ * the original subtrie.
+ */
+static reference_t trie_set(reference_t node, int64_t shift, int64_t idx, reference_t value) {
+    size_t slot = (idx >> shift) & VECTOR_MASK;
+    size_t capacity = node == NULL_REF ? 0 : vector_node(node)->capacity;
+
+    reference_t child;
+    if (shift == 0) {
+        incref(value);
+        child = value;
+    } else {
+        child = trie_set(slot < capacity ? vector_node(node)->values[slot] : NULL_REF,
+                shift - VECTOR_BITS, idx, value);
+        if (child == NULL_REF) {
+            return NULL_REF;
+        }
+    }
+
+    reference_t ref = make_reference_refarray(slot < capacity ? capacity : slot + 1);
+    if (ref == NULL_REF) {
+        decref(child);
+        return NULL_REF;
+    }
+
+    ref_array_value_t *copy = vector_node(ref);
+    for (size_t i = 0; i < capacity; i++) {
+        if (i != slot) {
+            copy->values[i] = vector_node(node)->values[i];
+            incref(copy->values[i]);
+        }
+    }
+    copy->values[slot] = child;
+    return ref;
+}
+
+/*!
+ * Returns a new reference to a copy of the subtrie at node without its last
+ * element, which must be at idx. Nodes left without children are dropped, in
+ * which case NULL_REF is returned without an exception.
+ */
+static reference_t trie_pop(reference_t node, int64_t shift, int64_t idx) {
+    size_t slot = (idx >> shift) & VECTOR_MASK;
+    assert(slot == vector_node(node)->capacity - 1);
+
+    reference_t child = NULL_REF;
+    if (shift > 0) {
+        child = trie_pop(vector_node(node)->values[slot], shift - VECTOR_BITS, idx);
+        if (exception_occurred()) {
+            return NULL_REF;
+        }
+    }
+
+    size_t capacity = child == NULL_REF ? slot : slot + 1;
+    if (capacity == 0) {
+        return NULL_REF;
+    }
+
+    reference_t ref = make_reference_refarray(capacity);
+    if (ref == NULL_REF) {
+        decref(child);
+        return NULL_REF;
+    }
+
+    ref_array_value_t *copy = vector_node(ref);
+    for (size_t i = 0; i < slot; i++) {
+        copy->values[i] = vector_node(node)->values[i];
+        incref(copy->values[i]);
+    }
+    if (child != NULL_REF) {
+        copy->values[slot] = child;
+    }
+    return ref;
+}
+
+//// TYPE INTERFACE FUNCTIONS ////
+
+bool vector_bool(value_t *obj) {
+    return vector_len(obj) > 0;
+}
+
+int64_t vector_len(value_t *obj) {
+    return vector_coerce(obj)->size;
+}
+
+bool vector_eq(value_t *l, value_t *r) {
+    vector_value_t *lvector = vector_coerce(l);
+    vector_value_t *rvector = vector_coerce(r);
+
+    if (lvector->size != rvector->size) {
+        return false;
+    }
+
+    /* Versions of the same vector often share the whole trie. */
+    if (lvector->root == rvector->root) {
+        return true;
+    }
+
+    for (int64_t idx = 0; idx < lvector->size; idx++) {
+        bool equals = ref_eq(vector_peek(lvector, idx), vector_peek(rvector, idx));
+        if (exception_occurred() || !equals) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*! Implements membership tests for vectors, comparing elements with ==. */
+bool vector_contains(value_t *obj, reference_t item) {
+    vector_value_t *vector = vector_coerce(obj);
+
+    for (int64_t idx = 0; idx < vector->size; idx++) {
+        if (ref_eq(vector_peek(vector, idx), item)) {
+            return true;
+        }
+        if (exception_occurred()) {
+            return false;
+        }
+    }
+    return false;
+}
+
+/*! Implements subscript access for vectors. */
+reference_t vector_subscr_get(value_t *obj, reference_t subscr) {
+    vector_value_t *vector = vector_coerce(obj);
+
+    int64_t idx = vector_coerce_subscript(vector, subscr);
+    if (idx < 0) {
+        return NULL_REF;
+    }
+
+    reference_t value = vector_peek(vector, idx);
+    incref(value);
+    return value;
+}
+
+/*! Implements printing of vectors, as the call that would build them. */
+void vector_print(value_t *obj, sink_t *sink, size_t depth) {
+    /* If we have reached the maximum recursion depth, print a placeholder. */
+    if (depth == 0) {
+        sink_puts(sink, "...");
+        return;
+    }
+
+    vector_value_t *vector = vector_coerce(obj);
+    if (vector->size == 0) {
+        sink_puts(sink, "vector()");
+        return;
+    }
+
+    sink_puts(sink, "vector([");
+    for (int64_t idx = 0; idx < vector->size; idx++) {
+        if (idx > 0) {
+            sink_puts(sink, ", ");
+        }
+        ref_write_repr(vector_peek(vector, idx), sink, depth - 1);
+    }
+    sink_puts(sink, "])");
+}
+
+//// HELPER FUNCTIONS ////
+
+/*!
+ * Fills a new, empty vector with size elements, building its trie bottom up
+ * with every node full except the last on each level. The elements are
+ * incref'd, not stolen. Returns false and sets an exception on error.
+ */
+bool vector_build(value_t *obj, reference_t *values, size_t size) {
+    vector_value_t *vector = vector_coerce(obj);
+    assert(vector->size == 0 && vector->root == NULL_REF);
+
+    if (size == 0) {
+        return true;
+    }
+
+    /* Build the leaves. */
+    size_t count = (size + VECTOR_MASK) / VECTOR_BRANCH;
+    reference_t nodes[count];
+    for (size_t i = 0; i < count; i++) {
+        size_t start = i * VECTOR_BRANCH;
+        size_t length = size - start < VECTOR_BRANCH ? size - start : VECTOR_BRANCH;
+
+        nodes[i] = make_reference_refarray(length);
+        if (nodes[i] == NULL_REF) {
+            for (size_t j = 0; j < i; j++) {
+                decref(nodes[j]);
+            }
+            return false;
+        }
+
+        ref_array_value_t *leaf = vector_node(nodes[i]);
+        for (size_t j = 0; j < length; j++) {
+            incref(values[start + j]);
+            leaf->values[j] = values[start + j];
+        }
+    }
+
+    /* Then group each level's nodes under parents until one is left. The
+     * parents are written over the start of the level, whose nodes they
+     * have already taken. */
+    int64_t shift = 0;
+    while (count > 1) {
+        size_t parents = (count + VECTOR_MASK) / VECTOR_BRANCH;
+        for (size_t i = 0; i < parents; i++) {
+            size_t start = i * VECTOR_BRANCH;
+            size_t length = count - start < VECTOR_BRANCH ? count - start : VECTOR_BRANCH;
+
+            reference_t parent = make_reference_refarray(length);
+            if (parent == NULL_REF) {
+                for (size_t j = 0; j < i; j++) {
+                    decref(nodes[j]);
+                }
+                for (size_t j = start; j < count; j++) {
+                    decref(nodes[j]);
+                }
+                return false;
+            }
+
+            ref_array_value_t *node = vector_node(parent);
+            for (size_t j = 0; j < length; j++) {
+                node->values[j] = nodes[start + j];
+            }
+            nodes[i] = parent;
+        }
+
+        count = parents;
+        shift += VECTOR_BITS;
+    }
+
+    vector->size = size;
+    vector->shift = shift;
+    vector->root = nodes[0];
+    return true;
+}
+
+/*!
+ * Returns a new reference to a vector like this one, but with the element at
+ * the given index replaced, or NULL_REF on error.
+ */
+reference_t vector_assoc(value_t *obj, reference_t subscr, reference_t value) {
+    vector_value_t *vector = vector_coerce(obj);
+
+    int64_t idx = vector_coerce_subscript(vector, subscr);
+    if (idx < 0) {
+        return NULL_REF;
+    }
+
+    reference_t root = trie_set(vector->root, vector->shift, idx, value);
+    if (root == NULL_REF) {
+        return NULL_REF;
+    }
+    return vector_with_root(vector->size, vector->shift, root);
+}
+
+/*!
+ * Returns a new reference to a vector like this one, but with value appended,
+ * or NULL_REF on error.
+ */
+reference_t vector_push(value_t *obj, reference_t value) {
+    vector_value_t *vector = vector_coerce(obj);
+    int64_t idx = vector->size;
+    int64_t shift = vector->shift;
+    reference_t root = vector->root;
+
+    /* A full trie gets a new root above the old one. */
+    bool grow = root != NULL_REF && idx == (int64_t) VECTOR_BRANCH << shift;
+    if (grow) {
+        reference_t new_root = make_reference_refarray(1);
+        if (new_root == NULL_REF) {
+            return NULL_REF;
+        }
+        incref(root);
+        vector_node(new_root)->values[0] = root;
+
+        root = new_root;
+        shift += VECTOR_BITS;
+    }
+
+    reference_t result = trie_set(root, shift, idx, value);
+    if (grow) {
+        decref(root);
+    }
+    if (result == NULL_REF) {
+        return NULL_REF;
+    }
+    return vector_with_root(idx + 1, shift, result);
+}
+
+/*!
+ * Returns a new reference to a vector like this one, but without its last
+ * element, or NULL_REF on error. Raises an IndexError if the vector is empty.
+ */
+reference_t vector_pop(value_t *obj) {
+    vector_value_t *vector = vector_coerce(obj);
+    if (vector->size == 0) {
+        exception_set(EXC_INDEX_ERROR, "pop from empty vector");
+        return NULL_REF;
+    }
+
+    int64_t shift = vector->shift;
+    reference_t root = trie_pop(vector->root, shift, vector->size - 1);
+    if (exception_occurred()) {
+        return NULL_REF;
+    }
+
+    /* Drop roots that are left with a single child. */
+    while (root != NULL_REF && shift > 0 && vector_node(root)->capacity == 1) {
+        reference_t child = vector_node(root)->values[0];
+        incref(child);
+        decref(root);
+        root = child;
+        shift -= VECTOR_BITS;
+    }
+
+    return vector_with_root(vector->size - 1, shift, root);
+}
@@ -0,0 +1,25 @@
+#ifndef EVAL_VECTOR_H
+#define EVAL_VECTOR_H
+
+#include <stdbool.h>
+
+#include "format.h"
+#include "types.h"
+
+// TYPE INTERFACE FUNCTIONS //
+
+bool vector_bool(value_t *obj);
+int64_t vector_len(value_t *obj);
+bool vector_eq(value_t *l, value_t *r);
+bool vector_contains(value_t *obj, reference_t item);
+reference_t vector_subscr_get(value_t *obj, reference_t subscr);
+void vector_print(value_t *obj, sink_t *sink, size_t depth);
+
+// HELPER FUNCTIONS //
+
+bool vector_build(value_t *obj, reference_t *values, size_t size);
+reference_t vector_assoc(value_t *obj, reference_t subscr, reference_t value);
+reference_t vector_push(value_t *obj, reference_t value);
+reference_t vector_pop(value_t *obj);
+
+#endif /* EVAL_VECTOR_H */
@@ -0,0 +1,307 @@
+#include "eval_weakref.h"
+
+#include <assert.h>
+#include "eval_dict.h"
+#include "eval_refs.h"
+#include "eval_types.h"
+#include "exception.h"
+#include "refs.h"
+
+/*
+ * Weak dicts are hash tables laid out like hash table dicts, sharing their
+ * Robin Hood probing code in eval_dict.c, but with a weak reference to each
+ * value stored in place of the value. When a value is freed, refs.c clears
+ * the weak reference, which hides the entry at once. The entry itself is only
+ * removed by the next purge, since freeing happens in the middle of other
+ * operations, which may include ones on the weak dict itself.
+ */
+
+static inline weakref_value_t *weakref_coerce(value_t *obj) {
+    assert(obj->type == VAL_WEAKREF);
+    return (weakref_value_t *) obj;
+}
+
+static inline weakdict_value_t *weakdict_coerce(value_t *obj) {
+    assert(obj->type == VAL_WEAKDICT);
+    return (weakdict_value_t *) obj;
+}
+
+/*! Returns a weak dict's key array, or NULL if it hasn't allocated one yet. */
+static inline ref_array_value_t *weakdict_keyarray(weakdict_value_t *weakdict) {
+    return weakdict->keys == NULL_REF ? NULL : (ref_array_value_t *) deref(weakdict->keys);
+}
+
+/*! Returns a weak dict's array of weak references, or NULL like the keys. */
+static inline ref_array_value_t *weakdict_valuearray(weakdict_value_t *weakdict) {
+    return weakdict->values == NULL_REF ? NULL : (ref_array_value_t *) deref(weakdict->values);
+}
+
+/*! Returns the target of the weak reference in a slot, or NULL_REF if it died. */
+static inline reference_t weakdict_target(weakdict_value_t *weakdict, int64_t idx) {
+    return weakref_coerce(deref(weakdict_valuearray(weakdict)->values[idx]))->target;
+}
+
+/*!
+ * Returns the slot holding the key, or -1 if the weak dict doesn't contain
+ * it. The slot's value may have died. Sets an exception and returns -1 if the
+ * key is unhashable.
+ */
+static int64_t weakdict_find(weakdict_value_t *weakdict, reference_t key) {
+    uint64_t hash = ref_hash(key);
+    if (exception_occurred()) {
+        return -1;
+    }
+
+    ref_array_value_t *keys = weakdict_keyarray(weakdict);
+    return keys == NULL ? -1 : keys_find(keys, hash, key);
+}
+
+/*! Empties a slot, releasing its key and weak reference. */
+static void weakdict_remove(weakdict_value_t *weakdict, int64_t idx) {
+    ref_array_value_t *keys = weakdict_keyarray(weakdict);
+    ref_array_value_t *values = weakdict_valuearray(weakdict);
+    reference_t key = keys->values[idx];
+    reference_t value = values->values[idx];
+
+    /* Take the entry out before releasing it, in case that frees values
+     * that are in this weak dict too. */
+    keys_remove(keys, values, idx);
+    weakdict->size--;
+    decref(key);
+    decref(value);
+}
+
+/*!
+ * Removes the entries whose values have died, if any weak references have
+ * been cleared since the last purge. Removing entries can free more values,
+ * so this repeats until nothing else has been cleared.
+ */
+static void weakdict_purge(weakdict_value_t *weakdict) {
+    while (weakdict->purged != weakrefs_cleared()) {
+        weakdict->purged = weakrefs_cleared();
+
+        ref_array_value_t *keys = weakdict_keyarray(weakdict);
+        if (keys == NULL) {
+            return;
+        }
+
+        /* Removing a slot shifts the following entries back into it, so
+         * the scan only moves on past live entries. Shifting stops at an
+         * empty slot, so starting at one means no entry is ever shifted
+         * around the end of the table into a slot already scanned. */
+        uint64_t mask = keys->capacity - 1;
+        uint64_t start = 0;
+        while (keys->values[start] != NULL_REF) {
+            start++;
+        }
+        for (uint64_t scanned = 0; scanned < keys->capacity; ) {
+            uint64_t idx = (start + scanned) & mask;
+            if (keys->values[idx] != NULL_REF && weakdict_target(weakdict, idx) == NULL_REF) {
+                weakdict_remove(weakdict, idx);
+            } else {
+                scanned++;
+            }
+        }
+    }
+}
+
+/*!
+ * Makes sure a weak dict has room for size entries without growing its
+ * table, rehashing its entries into a bigger table if needed. Returns false
+ * and sets an exception if the table could not be allocated.
+ */
+static bool weakdict_reserve(weakdict_value_t *weakdict, size_t size) {
+    ref_array_value_t *keys = weakdict_keyarray(weakdict);
+    ref_array_value_t *values = weakdict_valuearray(weakdict);
+
+    size_t capacity = table_capacity(size);
+    if (keys != NULL && capacity <= keys->capacity) {
+        return true;
+    }
+
+    reference_t ref_keys = make_reference_keyarray(capacity);
+    if (exception_occurred()) {
+        return false;
+    }
+    reference_t ref_values = make_reference_refarray(capacity);
+    if (exception_occurred()) {
+        decref(ref_keys);
+        return false;
+    }
+
+    /* The entries move over to the new table, so their counts stay the same
+     * once the old table's slots are cleared. */
+    if (keys != NULL) {
+        ref_array_value_t *new_keys = (ref_array_value_t *) deref(ref_keys);
+        ref_array_value_t *new_values = (ref_array_value_t *) deref(ref_values);
+        for (size_t idx = 0; idx < keys->capacity; idx++) {
+            reference_t key = keys->values[idx];
+            if (key != NULL_REF) {
+                keys_insert(new_keys, new_values, keys_hash(keys, idx), key, values->values[idx]);
+                keys->values[idx] = NULL_REF;
+                values->values[idx] = NULL_REF;
+            }
+        }
+        decref(weakdict->keys);
+        decref(weakdict->values);
+    }
+
+    weakdict->keys = ref_keys;
+    weakdict->values = ref_values;
+    return true;
+}
+
+//// TYPE INTERFACE FUNCTIONS ////
+
+/*! Weak references are only equal to themselves. */
+bool weakref_eq(value_t *l, value_t *r) {
+    return l == r;
+}
+
+/*! Implements printing of weak references, which names their target's type. */
+void weakref_print(value_t *obj, sink_t *sink, size_t depth) {
+    (void) depth;
+    reference_t target = weakref_coerce(obj)->target;
+    if (target == NULL_REF) {
+        sink_puts(sink, "<weakref; dead>");
+        return;
+    }
+
+    sink_puts(sink, "<weakref to '");
+    sink_puts(sink, type_to_str(deref(target)->type));
+    sink_puts(sink, "'>");
+}
+
+bool weakdict_bool(value_t *obj) {
+    return weakdict_len(obj) > 0;
+}
+
+int64_t weakdict_len(value_t *obj) {
+    weakdict_value_t *weakdict = weakdict_coerce(obj);
+    weakdict_purge(weakdict);
+    return weakdict->size;
+}
+
+/*! Implements membership tests for weak dicts, which only see live entries. */
+bool weakdict_contains(value_t *obj, reference_t item) {
+    weakdict_value_t *weakdict = weakdict_coerce(obj);
+    int64_t idx = weakdict_find(weakdict, item);
+    return idx >= 0 && weakdict_target(weakdict, idx) != NULL_REF;
+}
+
+/*! Implements subscript access for weak dicts. */
+reference_t weakdict_subscr_get(value_t *obj, reference_t subscr) {
+    weakdict_value_t *weakdict = weakdict_coerce(obj);
+
+    int64_t idx = weakdict_find(weakdict, subscr);
+    reference_t target = idx < 0 ? NULL_REF : weakdict_target(weakdict, idx);
+    if (target == NULL_REF) {
+        if (!exception_occurred()) {
+            exception_set(EXC_KEY_ERROR, "no value found for key in dictionary");
+        }
+        return NULL_REF;
+    }
+
+    incref(target);
+    return target;
+}
+
+/*!
+ * Implements subscript assignment for weak dicts. The key is held like any
+ * dict's, but the value only through a new weak reference to it.
+ */
+void weakdict_subscr_set(value_t *obj, reference_t subscr, reference_t value) {
+    weakdict_value_t *weakdict = weakdict_coerce(obj);
+
+    /* Clear out dead entries first, so that they don't make the table grow. */
+    weakdict_purge(weakdict);
+    int64_t idx = weakdict_find(weakdict, subscr);
+    if (exception_occurred()) {
+        return;
+    }
+
+    reference_t weakref = make_reference_weakref(value);
+    if (weakref == NULL_REF) {
+        return;
+    }
+
+    if (idx >= 0) {
+        ref_array_value_t *values = weakdict_valuearray(weakdict);
+        reference_t old = values->values[idx];
+        values->values[idx] = weakref;
+        decref(old);
+        return;
+    }
+
+    /* Grow first, so that there is always an empty slot to probe to. */
+    if (!weakdict_reserve(weakdict, weakdict->size + 1)) {
+        decref(weakref);
+        return;
+    }
+
+    incref(subscr);
+    keys_insert(weakdict_keyarray(weakdict), weakdict_valuearray(weakdict),
+            ref_hash(subscr), subscr, weakref);
+    weakdict->size++;
+}
+
+/*! Implements deletion of entries from weak dicts. */
+void weakdict_subscr_del(value_t *obj, reference_t subscr) {
+    weakdict_value_t *weakdict = weakdict_coerce(obj);
+
+    int64_t idx = weakdict_find(weakdict, subscr);
+    if (idx < 0 || weakdict_target(weakdict, idx) == NULL_REF) {
+        if (!exception_occurred()) {
+            exception_set(EXC_KEY_ERROR, "can't delete nonexistant key in dictionary");
+        }
+        return;
+    }
+
+    weakdict_remove(weakdict, idx);
+}
+
+/*! Implements printing of weak dicts, as the call that would build them. */
+void weakdict_print(value_t *obj, sink_t *sink, size_t depth) {
+    /* If we have reached the maximum recursion depth, print a placeholder. */
+    if (depth == 0) {
+        sink_puts(sink, "...");
+        return;
+    }
+
+    weakdict_value_t *weakdict = weakdict_coerce(obj);
+    ref_array_value_t *keys = weakdict_keyarray(weakdict);
+
+    bool comma = false;
+    sink_puts(sink, "weakdict({");
+    for (size_t idx = 0; keys != NULL && idx < keys->capacity; idx++) {
+        reference_t key = keys->values[idx];
+        reference_t target = key == NULL_REF ? NULL_REF : weakdict_target(weakdict, idx);
+        if (target == NULL_REF) {
+            continue;
+        }
+
+        if (comma) {
+            sink_puts(sink, ", ");
+        }
+        ref_write_repr(key, sink, depth - 1);
+        sink_puts(sink, ": ");
+        ref_write_repr(target, sink, depth - 1);
+        comma = true;
+    }
+    sink_puts(sink, "})");
+}
+
+//// HELPER FUNCTIONS ////
+
+/*!
+ * Returns a new reference to the target of a weak reference, or to None if
+ * the target has been freed.
+ */
+reference_t weakref_get(value_t *obj) {
+    reference_t target = weakref_coerce(obj)->target;
+    if (target == NULL_REF) {
+        target = NONE_REF;
+    }
+    incref(target);
+    return target;
+}
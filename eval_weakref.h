@@ -0,0 +1,26 @@
+#ifndef EVAL_WEAKREF_H
+#define EVAL_WEAKREF_H
+
+#include <stdbool.h>
+
+#include "format.h"
+#include "types.h"
+
+// TYPE INTERFACE FUNCTIONS //
+
+bool weakref_eq(value_t *l, value_t *r);
+void weakref_print(value_t *obj, sink_t *sink, size_t depth);
+
+bool weakdict_bool(value_t *obj);
+int64_t weakdict_len(value_t *obj);
+bool weakdict_contains(value_t *obj, reference_t item);
+reference_t weakdict_subscr_get(value_t *obj, reference_t subscr);
+void weakdict_subscr_set(value_t *obj, reference_t subscr, reference_t value);
+void weakdict_subscr_del(value_t *obj, reference_t subscr);
+void weakdict_print(value_t *obj, sink_t *sink, size_t depth);
+
+// HELPER FUNCTIONS //
+
+reference_t weakref_get(value_t *obj);
+
+#endif /* EVAL_WEAKREF_H */
@@ -6,63 +6,240 @@
 #include <stdio.h>
 #include <string.h>
 
-#define INITIAL_FORMAT_BUFSIZE 256
+/*! The most arguments an exception message format may take. */
+#define MAX_FORMAT_ARGS 8
+
+/*! Room for copies of the strings passed to exception_set_format. */
+#define FORMAT_STRINGS_SIZE 256
+
+/*! The longest conversion specification a message format may contain. */
+#define MAX_CONVERSION_SPEC 16
 
 //// GLOBAL ERROR STATE ////
 
+/*! The C type of a captured format argument. */
+typedef enum {
+    ARG_INT,
+    ARG_LONG,
+    ARG_LONG_LONG,
+    ARG_SIZE,
+    ARG_DOUBLE,
+    ARG_STRING,
+    ARG_POINTER
+} format_arg_type_t;
+
+typedef struct {
+    format_arg_type_t type;
+    union {
+        int i;
+        long l;
+        long long ll;
+        size_t z;
+        double d;
+        const char *s;
+        void *p;
+    };
+} format_arg_t;
+
+/*!
+ * The current exception. Raising an exception doesn't format its message:
+ * the format and its arguments are stored, and only rendered if the exception
+ * is printed. Most exceptions raised while probing for a value are cleared
+ * without ever being printed, so this keeps them cheap.
+ */
 static struct {
     exception_t type;
-    char *error;
+
+    /*! The message, or its format if is_format is set. Always a string
+     *  with static storage duration. */
+    const char *format;
+    bool is_format;
+
+    format_arg_t args[MAX_FORMAT_ARGS];
+    size_t num_args;
+
+    /*! Copies of string arguments, which may not outlive the raise. */
+    char strings[FORMAT_STRINGS_SIZE];
+    size_t strings_used;
 } exception;
 
+//// MESSAGE FORMATTING ////
+
+/*!
+ * Finds the end of the conversion specification starting at the '%' at spec,
+ * and determines which type of argument it takes. Returns a pointer just past
+ * the conversion character.
+ */
+static const char *parse_conversion(const char *spec, format_arg_type_t *type) {
+    const char *p = spec + 1;
+
+    /* Flags, field width and precision. */
+    p += strspn(p, "-+ #0");
+    p += strspn(p, "0123456789");
+    if (*p == '.') {
+        p++;
+        p += strspn(p, "0123456789");
+    }
+
+    /* Length modifiers. */
+    *type = ARG_INT;
+    if (*p == 'z') {
+        *type = ARG_SIZE;
+        p++;
+    } else if (p[0] == 'l' && p[1] == 'l') {
+        *type = ARG_LONG_LONG;
+        p += 2;
+    } else if (*p == 'l') {
+        *type = ARG_LONG;
+        p++;
+    }
+
+    switch (*p) {
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+            break;
+        case 'f': case 'g': case 'e':
+            *type = ARG_DOUBLE;
+            break;
+        case 's':
+            *type = ARG_STRING;
+            break;
+        case 'p':
+            *type = ARG_POINTER;
+            break;
+        default:
+            fprintf(stderr, "unsupported conversion in exception message format '%s'\n",
+                    spec);
+            abort();
+    }
+
+    if (p + 1 - spec >= MAX_CONVERSION_SPEC) {
+        fprintf(stderr, "conversion too long in exception message format '%s'\n", spec);
+        abort();
+    }
+    return p + 1;
+}
+
+/*!
+ * Copies a string argument into the exception's string storage, truncating
+ * it if the storage is full, and returns the copy.
+ */
+static const char *capture_string(const char *str) {
+    if (exception.strings_used == FORMAT_STRINGS_SIZE) {
+        return "";
+    }
+
+    size_t length = strnlen(str, FORMAT_STRINGS_SIZE - exception.strings_used - 1);
+    char *copy = exception.strings + exception.strings_used;
+    memcpy(copy, str, length);
+    copy[length] = '\0';
+    exception.strings_used += length + 1;
+    return copy;
+}
+
+/*! Writes a single captured argument using its conversion specification. */
+static void print_arg(FILE *stream, const char *spec, const format_arg_t *arg) {
+    switch (arg->type) {
+        case ARG_INT:       fprintf(stream, spec, arg->i);  break;
+        case ARG_LONG:      fprintf(stream, spec, arg->l);  break;
+        case ARG_LONG_LONG: fprintf(stream, spec, arg->ll); break;
+        case ARG_SIZE:      fprintf(stream, spec, arg->z);  break;
+        case ARG_DOUBLE:    fprintf(stream, spec, arg->d);  break;
+        case ARG_STRING:    fprintf(stream, spec, arg->s);  break;
+        case ARG_POINTER:   fprintf(stream, spec, arg->p);  break;
+    }
+}
+
+/*! Renders the current exception's message to a stream. */
+static void print_message(FILE *stream) {
+    if (!exception.is_format) {
+        fputs(exception.format, stream);
+        return;
+    }
+
+    const char *p = exception.format;
+    size_t next_arg = 0;
+    while (*p) {
+        const char *percent = strchr(p, '%');
+        if (percent == NULL) {
+            fputs(p, stream);
+            break;
+        }
+        fwrite(p, 1, percent - p, stream);
+
+        if (percent[1] == '%') {
+            putc('%', stream);
+            p = percent + 2;
+            continue;
+        }
+
+        format_arg_type_t type;
+        p = parse_conversion(percent, &type);
+
+        char spec[MAX_CONVERSION_SPEC];
+        memcpy(spec, percent, p - percent);
+        spec[p - percent] = '\0';
+        print_arg(stream, spec, &exception.args[next_arg++]);
+    }
+}
+
 //// EVALUATION ERROR HANDLING ////
 
+/*!
+ * Raises an exception. The message is not copied, so it must have static
+ * storage duration, like a string literal.
+ */
 void exception_set(exception_t type, const char *message) {
-    free(exception.error);
-
     exception.type = type;
-    exception.error = strdup(message);
+    exception.format = message;
+    exception.is_format = false;
 }
 
+/*!
+ * Raises an exception whose message is given by a printf-style format. Only
+ * the arguments are captured here; the message is formatted by
+ * exception_print. The format must have static storage duration, while string
+ * arguments are copied and need not outlive the call.
+ */
 void exception_set_format(exception_t type, const char *format, ...) {
-    char initial_buf[INITIAL_FORMAT_BUFSIZE];
     va_list args;
-
     va_start(args, format);
-    int result = vsnprintf(initial_buf, INITIAL_FORMAT_BUFSIZE, format, args);
-    va_end(args);
 
-    if (result < 0) {
-        fprintf(stderr, "failed to format exception message with format '%s'\n", format);
-        abort();
-    }
+    exception.type = type;
+    exception.format = format;
+    exception.is_format = true;
+    exception.num_args = 0;
+    exception.strings_used = 0;
 
-    /* Here, we use malloc and not a string object because we don't want an
-     * exception caused by running out of regular memory to require a new
-     * value to be allocated. */
-    char *buf = malloc(result + 1);
-    if (buf == NULL) {
-        fprintf(stderr, "failed to allocate exception message buffer\n");
-        abort();
-    }
+    for (const char *p = strchr(format, '%'); p; p = strchr(p, '%')) {
+        if (p[1] == '%') {
+            p += 2;
+            continue;
+        }
 
-    if (result <= INITIAL_FORMAT_BUFSIZE) {
-        memcpy(buf, initial_buf, result);
-        buf[result] = '\0';
-    } else {
-        va_start(args, format);
-        vsnprintf(buf, result + 1, format, args);
-        va_end(args);
+        if (exception.num_args == MAX_FORMAT_ARGS) {
+            fprintf(stderr, "too many arguments in exception message format '%s'\n", format);
+            abort();
+        }
+
+        format_arg_t *arg = &exception.args[exception.num_args++];
+        p = parse_conversion(p, &arg->type);
+        switch (arg->type) {
+            case ARG_INT:       arg->i = va_arg(args, int);                 break;
+            case ARG_LONG:      arg->l = va_arg(args, long);                break;
+            case ARG_LONG_LONG: arg->ll = va_arg(args, long long);          break;
+            case ARG_SIZE:      arg->z = va_arg(args, size_t);              break;
+            case ARG_DOUBLE:    arg->d = va_arg(args, double);              break;
+            case ARG_STRING:    arg->s = capture_string(va_arg(args, const char *)); break;
+            case ARG_POINTER:   arg->p = va_arg(args, void *);              break;
+        }
     }
 
-    exception.type = type;
-    exception.error = buf;
+    va_end(args);
 }
-void exception_clear(void) {
-    free(exception.error);
 
+void exception_clear(void) {
     exception.type = EXC_NONE;
-    exception.error = NULL;
+    exception.format = NULL;
 }
 
 static const char *exception_type_to_str(exception_t type) {
@@ -74,6 +251,8 @@ static const char *exception_type_to_str(exception_t type) {
         case EXC_VALUE_ERROR:   return "ValueError";
         case EXC_INDEX_ERROR:   return "IndexError";
         case EXC_KEY_ERROR:     return "KeyError";
+        case EXC_ZERO_DIVISION_ERROR: return "ZeroDivisionError";
+        case EXC_OVERFLOW_ERROR: return "OverflowError";
         case EXC_MEMORY_ERROR:  return "MemoryError";
         case EXC_INTERNAL:      return "<internal>";
     }
@@ -81,8 +260,10 @@ static const char *exception_type_to_str(exception_t type) {
 }
 void exception_print(FILE *stream) {
     if (exception.type) {
-        if (exception.error) {
-            fprintf(stream, "%s: %s\n", exception_type_to_str(exception.type), exception.error);
+        if (exception.format) {
+            fprintf(stream, "%s: ", exception_type_to_str(exception.type));
+            print_message(stream);
+            putc('\n', stream);
         } else {
             fputs(exception_type_to_str(exception.type), stream);
         }
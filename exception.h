@@ -15,13 +15,16 @@ typedef enum {
     EXC_VALUE_ERROR,
     EXC_INDEX_ERROR,
     EXC_KEY_ERROR,
+    EXC_ZERO_DIVISION_ERROR,
+    EXC_OVERFLOW_ERROR,
     EXC_MEMORY_ERROR,
 
     EXC_INTERNAL
 } exception_t;
 
 void exception_set(exception_t type, const char *message);
-void exception_set_format(exception_t type, const char *format, ...);
+void exception_set_format(exception_t type, const char *format, ...)
+    __attribute__((format(printf, 2, 3)));
 void exception_clear(void);
 
 void exception_print(FILE *stream);
@@ -0,0 +1,258 @@
+/*! \file
+ * Formatting kernels used by the print and repr paths of the evaluator.
+ * These avoid going through printf-style format parsing for every value, and
+ * write into a sink_t so the same code can target a stream or a string.
+ */
+
+#include "format.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "exception.h"
+
+/*!
+ * The two-digit decimal representations of 00 through 99, stored back to
+ * back. This lets format_int64 produce two digits per division.
+ */
+static const char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/*!
+ * Writes the decimal representation of value into buf, which must have room
+ * for at least FORMAT_INT64_MAX characters. The result is not '\0'-terminated.
+ * Returns the number of characters written.
+ */
+size_t format_int64(char *buf, int64_t value) {
+    char tmp[FORMAT_INT64_MAX];
+    char *end = tmp + FORMAT_INT64_MAX;
+    char *pos = end;
+
+    /* Work with the magnitude as unsigned so that INT64_MIN doesn't overflow. */
+    uint64_t magnitude = value < 0 ? -(uint64_t) value : (uint64_t) value;
+
+    /* Emit the digits from least to most significant, two at a time. */
+    while (magnitude >= 100) {
+        unsigned pair = (unsigned) (magnitude % 100) * 2;
+        magnitude /= 100;
+        pos -= 2;
+        pos[0] = digit_pairs[pair];
+        pos[1] = digit_pairs[pair + 1];
+    }
+    if (magnitude >= 10) {
+        unsigned pair = (unsigned) magnitude * 2;
+        pos -= 2;
+        pos[0] = digit_pairs[pair];
+        pos[1] = digit_pairs[pair + 1];
+    } else {
+        *--pos = (char) ('0' + magnitude);
+    }
+
+    if (value < 0) {
+        *--pos = '-';
+    }
+
+    size_t length = end - pos;
+    memcpy(buf, pos, length);
+    return length;
+}
+
+/*!
+ * Writes the shortest decimal representation of value that reads back as the
+ * same double into buf, which must have room for at least FORMAT_DOUBLE_MAX
+ * characters, laid out the way Python's repr does it: positional notation for
+ * exponents from -4 up to 15, scientific notation otherwise, and always with
+ * a '.' or an exponent so that it doesn't read as an integer. The result is
+ * not '\0'-terminated. Returns the number of characters written.
+ */
+size_t format_double(char *buf, double value) {
+    if (isnan(value)) {
+        memcpy(buf, "nan", 3);
+        return 3;
+    }
+    if (isinf(value)) {
+        memcpy(buf, value < 0 ? "-inf" : "inf", value < 0 ? 4 : 3);
+        return value < 0 ? 4 : 3;
+    }
+
+    /* Find the fewest significant digits that round-trip. Seventeen always do. */
+    char sci[FORMAT_DOUBLE_MAX];
+    int precision;
+    for (precision = 1; precision < 17; precision++) {
+        snprintf(sci, sizeof(sci), "%.*e", precision - 1, value);
+        if (strtod(sci, NULL) == value) {
+            break;
+        }
+    }
+    if (precision == 17) {
+        snprintf(sci, sizeof(sci), "%.16e", value);
+    }
+
+    /* Split "-d.ddde+XX" into its digits and exponent. */
+    char digits[17];
+    size_t ndigits = 0;
+    const char *pos = sci;
+    if (*pos == '-') {
+        pos++;
+    }
+    for (; *pos != 'e'; pos++) {
+        if (*pos != '.') {
+            digits[ndigits++] = *pos;
+        }
+    }
+    int exponent = atoi(pos + 1);
+    while (ndigits > 1 && digits[ndigits - 1] == '0') {
+        ndigits--;
+    }
+
+    char *out = buf;
+    if (signbit(value)) {
+        *out++ = '-';
+    }
+
+    if (exponent < -4 || exponent >= 16) {
+        *out++ = digits[0];
+        if (ndigits > 1) {
+            *out++ = '.';
+            memcpy(out, digits + 1, ndigits - 1);
+            out += ndigits - 1;
+        }
+        *out++ = 'e';
+        *out++ = exponent < 0 ? '-' : '+';
+        int magnitude = exponent < 0 ? -exponent : exponent;
+        if (magnitude < 10) {
+            *out++ = '0';
+        }
+        out += format_int64(out, magnitude);
+    } else if (exponent < 0) {
+        memcpy(out, "0.", 2);
+        out += 2;
+        memset(out, '0', -exponent - 1);
+        out += -exponent - 1;
+        memcpy(out, digits, ndigits);
+        out += ndigits;
+    } else {
+        /* Integer part, padded with zeros past the significant digits. */
+        for (int i = 0; i <= exponent; i++) {
+            *out++ = (size_t) i < ndigits ? digits[i] : '0';
+        }
+        *out++ = '.';
+        if ((size_t) exponent + 1 < ndigits) {
+            memcpy(out, digits + exponent + 1, ndigits - exponent - 1);
+            out += ndigits - exponent - 1;
+        } else {
+            *out++ = '0';
+        }
+    }
+    return out - buf;
+}
+
+//// SINKS ////
+
+/*! Initializes a sink that forwards all output to the given stream. */
+void sink_init_stream(sink_t *sink, FILE *stream) {
+    *sink = (sink_t) {
+        .stream = stream
+    };
+}
+
+/*! Initializes a sink that accumulates output in a heap buffer. */
+void sink_init_buffer(sink_t *sink) {
+    *sink = (sink_t) {
+        .stream = NULL
+    };
+}
+
+/*! Releases the buffer held by an in-memory sink. */
+void sink_destroy(sink_t *sink) {
+    free(sink->buffer);
+    sink->buffer = NULL;
+    sink->length = 0;
+    sink->capacity = 0;
+}
+
+/*!
+ * Ensures that an in-memory sink has room for `additional` more characters.
+ * Returns false and sets a MemoryError if the buffer could not be grown.
+ */
+static bool sink_reserve(sink_t *sink, size_t additional) {
+    size_t needed = sink->length + additional;
+    if (needed <= sink->capacity) {
+        return true;
+    }
+
+    /* Double the capacity until the request fits, like the other growable
+     * arrays in the interpreter. */
+    size_t capacity = sink->capacity == 0 ? INITIAL_SIZE * 8 : sink->capacity;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+
+    char *buffer = realloc(sink->buffer, capacity);
+    if (buffer == NULL) {
+        exception_set(EXC_MEMORY_ERROR, "could not grow string buffer");
+        return false;
+    }
+    sink->buffer = buffer;
+    sink->capacity = capacity;
+    return true;
+}
+
+/*! Writes length characters from data to the sink. */
+void sink_write(sink_t *sink, const char *data, size_t length) {
+    if (sink->stream) {
+        fwrite(data, 1, length, sink->stream);
+    } else if (sink_reserve(sink, length)) {
+        memcpy(sink->buffer + sink->length, data, length);
+        sink->length += length;
+    }
+}
+
+/*! Writes a single character to the sink. */
+void sink_putc(sink_t *sink, char c) {
+    if (sink->stream) {
+        putc(c, sink->stream);
+    } else if (sink_reserve(sink, 1)) {
+        sink->buffer[sink->length++] = c;
+    }
+}
+
+/*! Writes a '\0'-terminated string to the sink. */
+void sink_puts(sink_t *sink, const char *str) {
+    sink_write(sink, str, strlen(str));
+}
+
+/*! Writes the decimal representation of value to the sink. */
+void sink_int64(sink_t *sink, int64_t value) {
+    char buf[FORMAT_INT64_MAX];
+    sink_write(sink, buf, format_int64(buf, value));
+}
+
+/*! Writes the repr of a double to the sink. */
+void sink_double(sink_t *sink, double value) {
+    char buf[FORMAT_DOUBLE_MAX];
+    sink_write(sink, buf, format_double(buf, value));
+}
+
+/*! Writes a string surrounded by double quotes, as used by repr. */
+void sink_quoted(sink_t *sink, const char *str) {
+    size_t length = strlen(str);
+    if (sink->stream == NULL && !sink_reserve(sink, length + 2)) {
+        return;
+    }
+
+    sink_putc(sink, '"');
+    sink_write(sink, str, length);
+    sink_putc(sink, '"');
+}
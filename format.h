@@ -0,0 +1,48 @@
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*! The maximum number of characters format_int64 will write (sign included). */
+#define FORMAT_INT64_MAX 20
+
+/*! The maximum number of characters format_double will write (sign included). */
+#define FORMAT_DOUBLE_MAX 32
+
+/*!
+ * A destination for formatted output. A sink either forwards everything to a
+ * FILE * stream, or accumulates it in a growable heap buffer so that the
+ * result can be turned into a string value in a single allocation.
+ */
+typedef struct sink {
+    /*! The stream to write to, or NULL if this is an in-memory sink. */
+    FILE *stream;
+
+    /*! The accumulated output of an in-memory sink. Not '\0'-terminated. */
+    char *buffer;
+
+    /*! The number of characters currently stored in buffer. */
+    size_t length;
+
+    /*! The number of characters buffer can hold before it must grow. */
+    size_t capacity;
+} sink_t;
+
+size_t format_int64(char *buf, int64_t value);
+size_t format_double(char *buf, double value);
+
+void sink_init_stream(sink_t *sink, FILE *stream);
+void sink_init_buffer(sink_t *sink);
+void sink_destroy(sink_t *sink);
+
+void sink_write(sink_t *sink, const char *data, size_t length);
+void sink_putc(sink_t *sink, char c);
+void sink_puts(sink_t *sink, const char *str);
+void sink_int64(sink_t *sink, int64_t value);
+void sink_double(sink_t *sink, double value);
+void sink_quoted(sink_t *sink, const char *str);
+
+#endif /* FORMAT_H */
@@ -533,6 +533,7 @@ static const flex_int32_t yy_rule_can_match_eol[46] =
 #line 8 "grammar.l"
     #include <stddef.h>
 
+    #include "exception.h"
     #include "grammar.y.h"
     #include "parser.h"
 
@@ -586,7 +587,7 @@ static const flex_int32_t yy_rule_can_match_eol[46] =
                 } \
             } \
         } while (0)
-#line 589 "grammar.l.c"
+#line 590 "grammar.l.c"
 #line 66 "grammar.l"
  /* This lexer uses the START and INNER states to track the starts of
   * lines. When the lexer first starts or after a newline ('\n') or EOF has
@@ -598,7 +599,7 @@ static const flex_int32_t yy_rule_can_match_eol[46] =
   * whitespace without consuming any input characters, leading to an infinite
   * loop. */
 
-#line 601 "grammar.l.c"
+#line 602 "grammar.l.c"
 
 #define INITIAL 0
 #define START 1
@@ -881,7 +882,7 @@ YY_DECL
     BEGIN(START);
 
 
-#line 884 "grammar.l.c"
+#line 885 "grammar.l.c"
 
 	while ( /*CONSTCOND*/1 )		/* loops until end-of-file is reached */
 		{
@@ -1217,8 +1218,16 @@ case 42:
 YY_RULE_SETUP
 #line 197 "grammar.l"
 {
+    /* Literals are only ever 64-bit integers, so reject any that don't fit
+     * rather than letting strtol clamp them. */
+    errno = 0;
     yylval->int_value = strtol(yytext, NULL, 10);
-    PUSH(INTEGER);
+    if (errno == ERANGE) {
+        exception_set(EXC_OVERFLOW_ERROR, "integer literal is too large");
+        PUSH(INVALID_TOKEN);
+    } else {
+        PUSH(INTEGER);
+    }
 }
 	YY_BREAK
 case 43:
@@ -1242,7 +1251,7 @@ YY_RULE_SETUP
 #line 211 "grammar.l"
 ECHO;
 	YY_BREAK
-#line 1245 "grammar.l.c"
+#line 1254 "grammar.l.c"
 case YY_STATE_EOF(INITIAL):
 	yyterminate();
 
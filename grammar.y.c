@@ -121,11 +121,12 @@ extern int yydebug;
 
     #include "ast.h"
     #include "config.h"
+    #include "exception.h"
     #include "parser.h"
 
     #define YYLTYPE parser_location_t
 
-#line 129 "grammar.y.c"
+#line 130 "grammar.y.c"
 
 /* Token type.  */
 #ifndef YYTOKENTYPE
@@ -204,7 +205,7 @@ union YYSTYPE
     int64_t int_value;
     double float_value;
 
-#line 208 "grammar.y.c"
+#line 209 "grammar.y.c"
 
 };
 typedef union YYSTYPE YYSTYPE;
@@ -244,7 +245,7 @@ void yypstate_delete (yypstate *ps);
 
     void yyerror(YYLTYPE *yylloc, void *scanner, const char* msg);
 
-#line 248 "grammar.y.c"
+#line 249 "grammar.y.c"
 
 #endif /* !YY_YY_GRAMMAR_Y_H_INCLUDED  */
 
@@ -257,7 +258,7 @@ void yypstate_delete (yypstate *ps);
 
     #define yyast (&yyget_extra(scanner)->ast)
 
-#line 261 "grammar.y.c"
+#line 262 "grammar.y.c"
 
 #ifdef short
 # undef short
@@ -1615,342 +1616,342 @@ yyreduce:
   case 2:
 #line 109 "grammar.y"
     { yyast->root = (yyvsp[0].node_value);   YYACCEPT; }
-#line 1619 "grammar.y.c"
+#line 1620 "grammar.y.c"
     break;
 
   case 3:
 #line 110 "grammar.y"
     { yyast->root = NULL; YYACCEPT; }
-#line 1625 "grammar.y.c"
+#line 1626 "grammar.y.c"
     break;
 
   case 4:
 #line 111 "grammar.y"
     { yyast->root = (yyvsp[-1].node_value); YYACCEPT; }
-#line 1631 "grammar.y.c"
+#line 1632 "grammar.y.c"
     break;
 
   case 5:
 #line 113 "grammar.y"
     { (yyval.node_value) = NULL; }
-#line 1637 "grammar.y.c"
+#line 1638 "grammar.y.c"
     break;
 
   case 6:
 #line 114 "grammar.y"
     { yyresult = 3; goto yyreturn; }
-#line 1643 "grammar.y.c"
+#line 1644 "grammar.y.c"
     break;
 
   case 9:
 #line 118 "grammar.y"
     { (yyval.node_value) = ast_alloc_sequence(yyast, (yyvsp[0].node_list)); }
-#line 1649 "grammar.y.c"
+#line 1650 "grammar.y.c"
     break;
 
   case 10:
 #line 119 "grammar.y"
     { (yyval.node_list) = ast_alloc_nodelist(yyast); ast_nodelist_append(yyast, (yyval.node_list), (yyvsp[0].node_value)); }
-#line 1655 "grammar.y.c"
+#line 1656 "grammar.y.c"
     break;
 
   case 11:
 #line 120 "grammar.y"
     { (yyval.node_list) = (yyvsp[-1].node_list); ast_nodelist_append(yyast, (yyvsp[-1].node_list), (yyvsp[0].node_value)); }
-#line 1661 "grammar.y.c"
+#line 1662 "grammar.y.c"
     break;
 
   case 14:
 #line 123 "grammar.y"
     { (yyval.node_value) = ast_alloc_sequence(yyast, (yyvsp[-1].node_list)); }
-#line 1667 "grammar.y.c"
+#line 1668 "grammar.y.c"
     break;
 
   case 15:
 #line 124 "grammar.y"
     { (yyval.node_value) = ast_alloc_sequence(yyast, (yyvsp[-2].node_list)); }
-#line 1673 "grammar.y.c"
+#line 1674 "grammar.y.c"
     break;
 
   case 16:
 #line 125 "grammar.y"
     { (yyval.node_list) = ast_alloc_nodelist(yyast); ast_nodelist_append(yyast, (yyval.node_list), (yyvsp[0].node_value)); }
-#line 1679 "grammar.y.c"
+#line 1680 "grammar.y.c"
     break;
 
   case 17:
 #line 127 "grammar.y"
     { (yyval.node_list) = (yyvsp[-2].node_list); ast_nodelist_append(yyast, (yyvsp[-2].node_list), (yyvsp[0].node_value)); }
-#line 1685 "grammar.y.c"
+#line 1686 "grammar.y.c"
     break;
 
   case 23:
 #line 133 "grammar.y"
     { (yyval.node_value) = (yyvsp[-1].node_value); }
-#line 1691 "grammar.y.c"
+#line 1692 "grammar.y.c"
     break;
 
   case 25:
 #line 136 "grammar.y"
     { (yyval.node_value) = ast_alloc_assign(yyast, (yyvsp[-2].node_value), (yyvsp[0].node_value)); }
-#line 1697 "grammar.y.c"
+#line 1698 "grammar.y.c"
     break;
 
   case 26:
 #line 137 "grammar.y"
     { (yyval.node_value) = ast_alloc_del(yyast, (yyvsp[0].node_value)); }
-#line 1703 "grammar.y.c"
+#line 1704 "grammar.y.c"
     break;
 
   case 27:
 #line 139 "grammar.y"
     { (yyval.node_value) = ast_alloc_if(yyast, (yyvsp[-3].node_value), (yyvsp[-1].node_value), (yyvsp[0].node_value)); }
-#line 1709 "grammar.y.c"
+#line 1710 "grammar.y.c"
     break;
 
   case 28:
 #line 140 "grammar.y"
     { (yyval.node_value) = ast_alloc_if(yyast, (yyvsp[-3].node_value), (yyvsp[-1].node_value), (yyvsp[0].node_value)); }
-#line 1715 "grammar.y.c"
+#line 1716 "grammar.y.c"
     break;
 
   case 29:
 #line 141 "grammar.y"
     { (yyval.node_value) = (yyvsp[0].node_value); }
-#line 1721 "grammar.y.c"
+#line 1722 "grammar.y.c"
     break;
 
   case 30:
 #line 142 "grammar.y"
     { (yyval.node_value) = NULL; }
-#line 1727 "grammar.y.c"
+#line 1728 "grammar.y.c"
     break;
 
   case 31:
 #line 144 "grammar.y"
     { (yyval.node_value) = ast_alloc_while(yyast, (yyvsp[-2].node_value), (yyvsp[0].node_value)); }
-#line 1733 "grammar.y.c"
+#line 1734 "grammar.y.c"
     break;
 
   case 33:
 #line 147 "grammar.y"
     { (yyval.node_value) = ast_alloc_or_test(yyast, (yyvsp[-2].node_value), (yyvsp[0].node_value)); }
-#line 1739 "grammar.y.c"
+#line 1740 "grammar.y.c"
     break;
 
   case 35:
 #line 149 "grammar.y"
     { (yyval.node_value) = ast_alloc_and_test(yyast, (yyvsp[-2].node_value), (yyvsp[0].node_value)); }
-#line 1745 "grammar.y.c"
+#line 1746 "grammar.y.c"
     break;
 
   case 37:
 #line 151 "grammar.y"
     { (yyval.node_value) = ast_alloc_not_test(yyast, (yyvsp[0].node_value)); }
-#line 1751 "grammar.y.c"
+#line 1752 "grammar.y.c"
     break;
 
   case 39:
 #line 153 "grammar.y"
     { (yyval.node_value) = ast_alloc_builtin(yyast, COMP_EQUALS, (yyvsp[-2].node_value), (yyvsp[0].node_value)); }
-#line 1757 "grammar.y.c"
+#line 1758 "grammar.y.c"
     break;
 
   case 40:
 #line 154 "grammar.y"
     { (yyval.node_value) = ast_alloc_builtin(yyast, COMP_LT, (yyvsp[-2].node_value), (yyvsp[0].node_value)); }
-#line 1763 "grammar.y.c"
+#line 1764 "grammar.y.c"
     break;
 
   case 41:
 #line 155 "grammar.y"
     { (yyval.node_value) = ast_alloc_builtin(yyast, COMP_GT, (yyvsp[-2].node_value), (yyvsp[0].node_value)); }
-#line 1769 "grammar.y.c"
+#line 1770 "grammar.y.c"
     break;
 
   case 42:
 #line 156 "grammar.y"
     { (yyval.node_value) = ast_alloc_builtin(yyast, COMP_LE, (yyvsp[-2].node_value), (yyvsp[0].node_value)); }
-#line 1775 "grammar.y.c"
+#line 1776 "grammar.y.c"
     break;
 
   case 43:
 #line 157 "grammar.y"
     { (yyval.node_value) = ast_alloc_builtin(yyast, COMP_GE, (yyvsp[-2].node_value), (yyvsp[0].node_value)); }
-#line 1781 "grammar.y.c"
+#line 1782 "grammar.y.c"
     break;
 
   case 45:
 #line 160 "grammar.y"
     { (yyval.node_value) = ast_alloc_builtin(yyast, OP_ADD, (yyvsp[-2].node_value), (yyvsp[0].node_value)); }
-#line 1787 "grammar.y.c"
+#line 1788 "grammar.y.c"
     break;
 
   case 46:
 #line 161 "grammar.y"
     { (yyval.node_value) = ast_alloc_builtin(yyast, OP_SUBTRACT, (yyvsp[-2].node_value), (yyvsp[0].node_value)); }
-#line 1793 "grammar.y.c"
+#line 1794 "grammar.y.c"
     break;
 
   case 48:
 #line 163 "grammar.y"
     { (yyval.node_value) = ast_alloc_builtin(yyast, OP_MULTIPLY, (yyvsp[-2].node_value), (yyvsp[0].node_value)); }
-#line 1799 "grammar.y.c"
+#line 1800 "grammar.y.c"
     break;
 
   case 49:
 #line 164 "grammar.y"
     { (yyval.node_value) = ast_alloc_builtin(yyast, OP_DIVIDE, (yyvsp[-2].node_value), (yyvsp[0].node_value)); }
-#line 1805 "grammar.y.c"
+#line 1806 "grammar.y.c"
     break;
 
   case 50:
 #line 165 "grammar.y"
     { (yyval.node_value) = ast_alloc_builtin(yyast, OP_MODULO, (yyvsp[-2].node_value), (yyvsp[0].node_value)); }
-#line 1811 "grammar.y.c"
+#line 1812 "grammar.y.c"
     break;
 
   case 52:
 #line 167 "grammar.y"
     { (yyval.node_value) = ast_alloc_builtin(yyast, UOP_IDENTITY, (yyvsp[0].node_value), NULL); }
-#line 1817 "grammar.y.c"
+#line 1818 "grammar.y.c"
     break;
 
   case 53:
 #line 168 "grammar.y"
     { (yyval.node_value) = ast_alloc_builtin(yyast, UOP_NEGATE, (yyvsp[0].node_value), NULL); }
-#line 1823 "grammar.y.c"
+#line 1824 "grammar.y.c"
     break;
 
   case 55:
 #line 170 "grammar.y"
     { (yyval.node_value) = ast_alloc_call(yyast, (yyvsp[-2].node_value), NULL); }
-#line 1829 "grammar.y.c"
+#line 1830 "grammar.y.c"
     break;
 
   case 56:
 #line 171 "grammar.y"
     { (yyval.node_value) = ast_alloc_call(yyast, (yyvsp[-3].node_value), (yyvsp[-1].node_list)); }
-#line 1835 "grammar.y.c"
+#line 1836 "grammar.y.c"
     break;
 
   case 57:
 #line 172 "grammar.y"
     { (yyval.node_value) = ast_alloc_subscript(yyast, (yyvsp[-3].node_value), (yyvsp[-1].node_value)); }
-#line 1841 "grammar.y.c"
+#line 1842 "grammar.y.c"
     break;
 
   case 58:
 #line 173 "grammar.y"
     { (yyval.node_value) = ast_alloc_identifier(yyast, (yyvsp[0].string_value)); }
-#line 1847 "grammar.y.c"
+#line 1848 "grammar.y.c"
     break;
 
   case 60:
 #line 175 "grammar.y"
     { (yyval.node_value) = (yyvsp[-1].node_value); }
-#line 1853 "grammar.y.c"
+#line 1854 "grammar.y.c"
     break;
 
   case 61:
 #line 177 "grammar.y"
     { (yyval.node_list) = ast_alloc_nodelist(yyast); ast_nodelist_append(yyast, (yyval.node_list), (yyvsp[0].node_value)); }
-#line 1859 "grammar.y.c"
+#line 1860 "grammar.y.c"
     break;
 
   case 62:
 #line 178 "grammar.y"
     { (yyval.node_list) = (yyvsp[-2].node_list); ast_nodelist_append(yyast, (yyval.node_list), (yyvsp[0].node_value)); }
-#line 1865 "grammar.y.c"
+#line 1866 "grammar.y.c"
     break;
 
   case 63:
 #line 180 "grammar.y"
     { (yyval.node_list_pair).first = ast_alloc_nodelist(yyast); ast_nodelist_append(yyast, (yyval.node_list_pair).first, (yyvsp[0].node_pair).first);
                                                               (yyval.node_list_pair).second = ast_alloc_nodelist(yyast); ast_nodelist_append(yyast, (yyval.node_list_pair).second, (yyvsp[0].node_pair).second); }
-#line 1872 "grammar.y.c"
+#line 1873 "grammar.y.c"
     break;
 
   case 64:
 #line 182 "grammar.y"
     { (yyval.node_list_pair) = (yyvsp[-2].node_list_pair); ast_nodelist_append(yyast, (yyval.node_list_pair).first, (yyvsp[0].node_pair).first); ast_nodelist_append(yyast, (yyval.node_list_pair).second, (yyvsp[0].node_pair).second); }
-#line 1878 "grammar.y.c"
+#line 1879 "grammar.y.c"
     break;
 
   case 65:
 #line 183 "grammar.y"
     { (yyval.node_pair).first = (yyvsp[-2].node_value); (yyval.node_pair).second = (yyvsp[0].node_value); }
-#line 1884 "grammar.y.c"
+#line 1885 "grammar.y.c"
     break;
 
   case 66:
 #line 185 "grammar.y"
     { (yyval.node_value) = ast_alloc_literal_string(yyast, (yyvsp[0].string_value)); }
-#line 1890 "grammar.y.c"
+#line 1891 "grammar.y.c"
     break;
 
   case 67:
 #line 186 "grammar.y"
     { (yyval.node_value) = ast_alloc_literal_integer(yyast, (yyvsp[0].int_value)); }
-#line 1896 "grammar.y.c"
+#line 1897 "grammar.y.c"
     break;
 
   case 68:
 #line 187 "grammar.y"
     { (yyval.node_value) = ast_alloc_literal_singleton(yyast, S_NONE); }
-#line 1902 "grammar.y.c"
+#line 1903 "grammar.y.c"
     break;
 
   case 69:
 #line 188 "grammar.y"
     { (yyval.node_value) = ast_alloc_literal_singleton(yyast, S_TRUE); }
-#line 1908 "grammar.y.c"
+#line 1909 "grammar.y.c"
     break;
 
   case 70:
 #line 189 "grammar.y"
     { (yyval.node_value) = ast_alloc_literal_singleton(yyast, S_FALSE); }
-#line 1914 "grammar.y.c"
+#line 1915 "grammar.y.c"
     break;
 
   case 71:
 #line 190 "grammar.y"
     { (yyval.node_value) = ast_alloc_literal_list(yyast, (yyvsp[0].node_list)); }
-#line 1920 "grammar.y.c"
+#line 1921 "grammar.y.c"
     break;
 
   case 72:
 #line 191 "grammar.y"
     { (yyval.node_value) = ast_alloc_literal_dict(yyast, (yyvsp[0].node_list_pair).first, (yyvsp[0].node_list_pair).second); }
-#line 1926 "grammar.y.c"
+#line 1927 "grammar.y.c"
     break;
 
   case 73:
 #line 192 "grammar.y"
     { (yyval.node_list) = ast_alloc_nodelist(yyast); }
-#line 1932 "grammar.y.c"
+#line 1933 "grammar.y.c"
     break;
 
   case 74:
 #line 193 "grammar.y"
     { (yyval.node_list) = (yyvsp[-1].node_list); }
-#line 1938 "grammar.y.c"
+#line 1939 "grammar.y.c"
     break;
 
   case 75:
 #line 194 "grammar.y"
     { (yyval.node_list_pair).first = (yyval.node_list_pair).second = ast_alloc_nodelist(yyast); }
-#line 1944 "grammar.y.c"
+#line 1945 "grammar.y.c"
     break;
 
   case 76:
 #line 195 "grammar.y"
     { (yyval.node_list_pair) = (yyvsp[-1].node_list_pair); }
-#line 1950 "grammar.y.c"
+#line 1951 "grammar.y.c"
     break;
 
 
-#line 1954 "grammar.y.c"
+#line 1955 "grammar.y.c"
 
       default: break;
     }
@@ -2204,5 +2205,13 @@ void yyerror(YYLTYPE *yylloc, void *scanner, const char* msg) {
     parser_t *parser = yyget_extra(scanner);
     parser->error_location = *yylloc;
 
-    fprintf(stderr, "<stdin>:%d:%d: %s\n", yylloc->first_line, yylloc->first_column, msg);
+    fprintf(stderr, "<stdin>:%d:%d: ", yylloc->first_line, yylloc->first_column);
+
+    /* The lexer raises its own errors, such as for out of range literals. */
+    if (exception_occurred()) {
+        exception_print(stderr);
+        exception_clear();
+    } else {
+        fprintf(stderr, "%s\n", msg);
+    }
 }
@@ -0,0 +1,650 @@
+/*! \file
+ * A baseline template JIT for hot integer loops. Each supported AST node is
+ * translated to a fixed sequence of x86-64 instructions: expressions leave
+ * their value in rax, using rcx as the second operand and the machine stack
+ * for temporaries, and variables live in the slots array passed in rdi. rbx
+ * holds the stack pointer on entry, so that the code can bail out from the
+ * middle of an expression, and r12 keeps the slots pointer across calls to
+ * helpers.
+ */
+
+#include "jit.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__linux__) && !defined(NJIT)
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "eval_refs.h"
+#include "eval_types.h"
+#include "exception.h"
+#include "refs.h"
+
+/*! The largest number of labels and jumps a single loop may use. */
+#define MAX_LABELS 256
+#define MAX_FIXUPS 512
+
+/*! The registers emit_load_simple can load into. */
+#define RAX 0
+#define RCX 1
+
+/*! x86 condition codes. Flipping the low bit negates a condition. */
+#define CC_O  0x0
+#define CC_BE 0x6
+#define CC_E  0x4
+#define CC_NE 0x5
+#define CC_L  0xC
+#define CC_GE 0xD
+#define CC_LE 0xE
+#define CC_G  0xF
+
+/*! The state of a loop being compiled. */
+typedef struct {
+    /*! The code emitted so far, in a growable heap buffer. */
+    uint8_t *code;
+    size_t length;
+    size_t capacity;
+
+    /*! Set once something unsupported or an allocation failure is hit. */
+    bool failed;
+
+    /*! The loop being compiled, whose variable table is filled in as
+     *  variables are encountered. */
+    jit_loop_t *loop;
+
+    /*! The code offset of each label, or -1 if it hasn't been bound yet. */
+    int64_t labels[MAX_LABELS];
+    size_t num_labels;
+
+    /*! The label of the code that gives up on the loop, returning false. */
+    size_t bailout;
+
+    /*! The rel32 fields of jumps, to be patched once labels are bound. */
+    struct {
+        size_t offset;
+        size_t label;
+    } fixups[MAX_FIXUPS];
+    size_t num_fixups;
+} emitter_t;
+
+static void emit_bytes(emitter_t *e, const void *bytes, size_t n) {
+    if (e->failed) {
+        return;
+    }
+
+    if (e->length + n > e->capacity) {
+        size_t capacity = e->capacity == 0 ? 256 : e->capacity;
+        while (capacity < e->length + n) {
+            capacity *= 2;
+        }
+
+        uint8_t *code = realloc(e->code, capacity);
+        if (code == NULL) {
+            e->failed = true;
+            return;
+        }
+        e->code = code;
+        e->capacity = capacity;
+    }
+
+    memcpy(e->code + e->length, bytes, n);
+    e->length += n;
+}
+
+#define EMIT(e, ...) do { \
+        const uint8_t bytes_[] = { __VA_ARGS__ }; \
+        emit_bytes(e, bytes_, sizeof(bytes_)); \
+    } while (0)
+
+static void emit_i32(emitter_t *e, int32_t value) {
+    emit_bytes(e, &value, sizeof(value));
+}
+
+static void emit_i64(emitter_t *e, int64_t value) {
+    emit_bytes(e, &value, sizeof(value));
+}
+
+//// LABELS ////
+
+static size_t new_label(emitter_t *e) {
+    if (e->num_labels == MAX_LABELS) {
+        e->failed = true;
+        return 0;
+    }
+    e->labels[e->num_labels] = -1;
+    return e->num_labels++;
+}
+
+static void bind_label(emitter_t *e, size_t label) {
+    e->labels[label] = e->length;
+}
+
+/*! Emits a rel32 operand referring to a label, to be patched later. */
+static void emit_label_ref(emitter_t *e, size_t label) {
+    if (e->num_fixups == MAX_FIXUPS) {
+        e->failed = true;
+        return;
+    }
+    e->fixups[e->num_fixups].offset = e->length;
+    e->fixups[e->num_fixups].label = label;
+    e->num_fixups++;
+    emit_i32(e, 0);
+}
+
+/*! jmp label */
+static void emit_jmp(emitter_t *e, size_t label) {
+    EMIT(e, 0xE9);
+    emit_label_ref(e, label);
+}
+
+/*! jcc label */
+static void emit_jcc(emitter_t *e, uint8_t cc, size_t label) {
+    EMIT(e, 0x0F, 0x80 | cc);
+    emit_label_ref(e, label);
+}
+
+/*! Patches every jump now that all the labels are bound. */
+static void resolve_labels(emitter_t *e) {
+    for (size_t i = 0; i < e->num_fixups; i++) {
+        size_t offset = e->fixups[i].offset;
+        int32_t rel = (int32_t) (e->labels[e->fixups[i].label] - (int64_t) (offset + 4));
+        memcpy(e->code + offset, &rel, sizeof(rel));
+    }
+}
+
+//// VARIABLES ////
+
+/*!
+ * Returns the slot of a variable, adding it to the loop if it is new. is_ref
+ * says whether it is used as a container or as an integer; a variable used
+ * as both can't be compiled.
+ */
+static int32_t slot_of(emitter_t *e, const char *name, bool is_ref) {
+    jit_loop_t *loop = e->loop;
+    for (size_t i = 0; i < loop->num_vars; i++) {
+        if (strcmp(loop->vars[i], name) == 0) {
+            if (loop->is_ref[i] != is_ref) {
+                e->failed = true;
+            }
+            return i;
+        }
+    }
+
+    if (loop->num_vars == JIT_MAX_VARS) {
+        e->failed = true;
+        return 0;
+    }
+    loop->vars[loop->num_vars] = name;
+    loop->is_ref[loop->num_vars] = is_ref;
+    return loop->num_vars++;
+}
+
+//// HELPERS ////
+
+/*!
+ * A helper called from compiled code. It is passed a container and an integer
+ * argument, and stores an integer in *result. Returning false makes the code
+ * give up; any exception is cleared, since the interpreter will raise it
+ * again when it runs the loop.
+ */
+typedef bool (*helper_t)(reference_t obj, int64_t arg, int64_t *result);
+
+/*! Stores the value of an integer in *result, or returns false. */
+static bool int_result(reference_t ref, int64_t *result) {
+    value_t *value = deref(ref);
+    if (value->type != VAL_INTEGER) {
+        return false;
+    }
+    *result = ((integer_value_t *) value)->integer_value;
+    return true;
+}
+
+/*! Reads obj[index]. List elements are read directly, without boxing. */
+static bool helper_subscr_get(reference_t obj, int64_t index, int64_t *result) {
+    value_t *value = deref(obj);
+    if (value->type == VAL_LIST) {
+        list_value_t *list = (list_value_t *) value;
+        if (index < 0) {
+            index += list->size;
+        }
+        if (index < 0 || index >= list->size) {
+            return false;
+        }
+        ref_array_value_t *array = (ref_array_value_t *) deref(list->values);
+        return int_result(array->values[index], result);
+    }
+
+    reference_t subscr = make_reference_int(index);
+    if (subscr == NULL_REF) {
+        exception_clear();
+        return false;
+    }
+    reference_t element = ref_subscr_get(obj, subscr);
+    decref(subscr);
+    if (exception_occurred()) {
+        exception_clear();
+        return false;
+    }
+
+    bool ok = int_result(element, result);
+    decref(element);
+    return ok;
+}
+
+/*! Computes len(obj). The argument is unused. */
+static bool helper_len(reference_t obj, int64_t arg, int64_t *result) {
+    (void) arg;
+    *result = ref_len(obj);
+    if (exception_occurred()) {
+        exception_clear();
+        return false;
+    }
+    return true;
+}
+
+//// EXPRESSIONS ////
+
+static void emit_expr(emitter_t *e, Node *node);
+
+/*! The comparison superinstructions are builtins with particular operands. */
+static bool is_builtin(Node *node) {
+    return node->type == EXPR_BUILTIN || node->type == EXPR_BUILTIN_INT ||
+        node->type == EXPR_COMPARE_SUBSCRIPTS || node->type == EXPR_COMPARE_LEN;
+}
+
+/*!
+ * Returns the container variable of `len(x)` or a subscript `x[...]`, or NULL
+ * if node is neither or reads from anything but a variable.
+ */
+static const char *container_of(Node *node) {
+    Node *obj;
+    if (node->type == EXPR_SUBSCRIPT) {
+        obj = ((NodeExprSubscript *) node)->obj;
+    } else if (node->type == EXPR_CALL) {
+        NodeExprCall *call = (NodeExprCall *) node;
+        if (call->func->type != EXPR_IDENTIFIER ||
+                strcmp(((NodeExprIdentifier *) call->func)->name, "len") != 0 ||
+                call->args == NULL || ast_nodelist_length(call->args) != 1) {
+            return NULL;
+        }
+        obj = call->args->head->node;
+    } else {
+        return NULL;
+    }
+
+    return obj->type == EXPR_IDENTIFIER ? ((NodeExprIdentifier *) obj)->name : NULL;
+}
+
+/*!
+ * Emits a call to a helper, passing it the container in a slot and the
+ * integer in rax. Leaves the helper's result in rax, or bails out if it
+ * returns false. The stack is aligned to 16 bytes for the call.
+ */
+static void emit_call_helper(emitter_t *e, helper_t helper, int32_t slot) {
+    EMIT(e, 0x55);                              /* push rbp */
+    EMIT(e, 0x48, 0x89, 0xE5);                  /* mov rbp, rsp */
+    EMIT(e, 0x48, 0x83, 0xE4, 0xF0);            /* and rsp, -16 */
+    EMIT(e, 0x48, 0x83, 0xEC, 0x10);            /* sub rsp, 16 */
+    EMIT(e, 0x48, 0x89, 0xC6);                  /* mov rsi, rax */
+    EMIT(e, 0x48, 0x8B, 0xBF);                  /* mov rdi, [rdi + slot * 8] */
+    emit_i32(e, slot * 8);
+    EMIT(e, 0x48, 0x89, 0xE2);                  /* mov rdx, rsp */
+    EMIT(e, 0x48, 0xB8);                        /* mov rax, helper */
+    emit_i64(e, (int64_t) (uintptr_t) helper);
+    EMIT(e, 0xFF, 0xD0);                        /* call rax */
+    EMIT(e, 0x48, 0x8B, 0x0C, 0x24);            /* mov rcx, [rsp] */
+    EMIT(e, 0x48, 0x89, 0xEC);                  /* mov rsp, rbp */
+    EMIT(e, 0x5D);                              /* pop rbp */
+    EMIT(e, 0x4C, 0x89, 0xE7);                  /* mov rdi, r12 */
+    EMIT(e, 0x84, 0xC0);                        /* test al, al */
+    emit_jcc(e, CC_E, e->bailout);
+    EMIT(e, 0x48, 0x89, 0xC8);                  /* mov rax, rcx */
+}
+
+/*!
+ * If node is an integer literal or a variable, loads it into the register
+ * and returns true. Otherwise emits nothing and returns false.
+ */
+static bool emit_load_simple(emitter_t *e, Node *node, uint8_t reg) {
+    if (node->type == EXPR_LITERAL_INTEGER) {
+        /* mov reg, imm64 */
+        EMIT(e, 0x48, 0xB8 + reg);
+        emit_i64(e, ((NodeExprLiteralInteger *) node)->value);
+        return true;
+    }
+
+    if (node->type == EXPR_IDENTIFIER) {
+        /* mov reg, [rdi + slot * 8] */
+        int32_t slot = slot_of(e, ((NodeExprIdentifier *) node)->name, false);
+        EMIT(e, 0x48, 0x8B, 0x87 | (reg << 3));
+        emit_i32(e, slot * 8);
+        return true;
+    }
+
+    return false;
+}
+
+/*! Evaluates the operands of a binary builtin into rax and rcx. */
+static void emit_operands(emitter_t *e, NodeExprBuiltin *builtin) {
+    emit_expr(e, builtin->left);
+    if (emit_load_simple(e, builtin->right, RCX)) {
+        return;
+    }
+
+    EMIT(e, 0x50);                      /* push rax */
+    emit_expr(e, builtin->right);
+    EMIT(e, 0x48, 0x89, 0xC1);          /* mov rcx, rax */
+    EMIT(e, 0x58);                      /* pop rax */
+}
+
+/*! Emits code that bails out if the divisor in rcx is 0 or -1. */
+static void emit_divisor_check(emitter_t *e) {
+    EMIT(e, 0x48, 0x8D, 0x51, 0x01);            /* lea rdx, [rcx + 1] */
+    EMIT(e, 0x48, 0x83, 0xFA, 0x01);            /* cmp rdx, 1 */
+    emit_jcc(e, CC_BE, e->bailout);
+}
+
+/*! Emits code leaving the value of an integer expression in rax. */
+static void emit_expr(emitter_t *e, Node *node) {
+    if (emit_load_simple(e, node, RAX)) {
+        return;
+    }
+
+    /* Reads from containers call helpers, which check that they produce
+     * integers. */
+    const char *container = container_of(node);
+    if (container != NULL) {
+        if (node->type == EXPR_SUBSCRIPT) {
+            emit_expr(e, ((NodeExprSubscript *) node)->index);
+            emit_call_helper(e, helper_subscr_get, slot_of(e, container, true));
+        } else {
+            emit_call_helper(e, helper_len, slot_of(e, container, true));
+        }
+        return;
+    }
+
+    /* Everything else must be arithmetic; comparisons only appear as
+     * conditions, where emit_cond handles them. */
+    if (!is_builtin(node) || ((NodeExprBuiltin *) node)->builtin_type >= COMP_EQUALS) {
+        e->failed = true;
+        return;
+    }
+
+    NodeExprBuiltin *builtin = (NodeExprBuiltin *) node;
+    if (is_unary_builtin(builtin->builtin_type)) {
+        emit_expr(e, builtin->left);
+        if (builtin->builtin_type == UOP_NEGATE) {
+            EMIT(e, 0x48, 0xF7, 0xD8);  /* neg rax */
+            emit_jcc(e, CC_O, e->bailout);
+        }
+        return;
+    }
+
+    /* Results that overflow need bigints, and division by 0 or -1 may raise
+     * an error or overflow, so those bail out to the interpreter. */
+    emit_operands(e, builtin);
+    switch (builtin->builtin_type) {
+        case OP_ADD:
+            EMIT(e, 0x48, 0x01, 0xC8);          /* add rax, rcx */
+            emit_jcc(e, CC_O, e->bailout);
+            break;
+        case OP_SUBTRACT:
+            EMIT(e, 0x48, 0x29, 0xC8);          /* sub rax, rcx */
+            emit_jcc(e, CC_O, e->bailout);
+            break;
+        case OP_MULTIPLY:
+            EMIT(e, 0x48, 0x0F, 0xAF, 0xC1);    /* imul rax, rcx */
+            emit_jcc(e, CC_O, e->bailout);
+            break;
+        case OP_DIVIDE:
+            emit_divisor_check(e);
+            EMIT(e, 0x48, 0x99);                /* cqo */
+            EMIT(e, 0x48, 0xF7, 0xF9);          /* idiv rcx */
+            break;
+        case OP_MODULO:
+            emit_divisor_check(e);
+            EMIT(e, 0x48, 0x99);                /* cqo */
+            EMIT(e, 0x48, 0xF7, 0xF9);          /* idiv rcx */
+            EMIT(e, 0x48, 0x89, 0xD0);          /* mov rax, rdx */
+            break;
+        default:
+            e->failed = true;
+            break;
+    }
+}
+
+/*! Returns the condition code that is set when a comparison holds. */
+static uint8_t comparison_cc(NodeExprBuiltinType type) {
+    switch (type) {
+        case COMP_EQUALS:  return CC_E;
+        case COMP_LT:      return CC_L;
+        case COMP_GT:      return CC_G;
+        case COMP_LE:      return CC_LE;
+        case COMP_GE:      return CC_GE;
+        default:           return CC_E;
+    }
+}
+
+/*!
+ * Emits code that jumps to target if the truth value of a condition equals
+ * jump_if, and falls through otherwise.
+ */
+static void emit_cond(emitter_t *e, Node *node, bool jump_if, size_t target) {
+    switch (node->type) {
+        case EXPR_NOT_TEST:
+            emit_cond(e, ((NodeExprNotTest *) node)->operand, !jump_if, target);
+            return;
+
+        case EXPR_AND_TEST: {
+            NodeExprAndTest *test = (NodeExprAndTest *) node;
+            if (jump_if) {
+                size_t skip = new_label(e);
+                emit_cond(e, test->left, false, skip);
+                emit_cond(e, test->right, true, target);
+                bind_label(e, skip);
+            } else {
+                emit_cond(e, test->left, false, target);
+                emit_cond(e, test->right, false, target);
+            }
+            return;
+        }
+
+        case EXPR_OR_TEST: {
+            NodeExprOrTest *test = (NodeExprOrTest *) node;
+            if (jump_if) {
+                emit_cond(e, test->left, true, target);
+                emit_cond(e, test->right, true, target);
+            } else {
+                size_t skip = new_label(e);
+                emit_cond(e, test->left, true, skip);
+                emit_cond(e, test->right, false, target);
+                bind_label(e, skip);
+            }
+            return;
+        }
+
+        case EXPR_LITERAL_SINGLETON: {
+            bool truth = ((NodeExprLiteralSingleton *) node)->singleton == S_TRUE;
+            if (truth == jump_if) {
+                emit_jmp(e, target);
+            }
+            return;
+        }
+
+        default:
+            break;
+    }
+
+    if (is_builtin(node) && ((NodeExprBuiltin *) node)->builtin_type >= COMP_EQUALS) {
+        NodeExprBuiltin *builtin = (NodeExprBuiltin *) node;
+        emit_operands(e, builtin);
+        EMIT(e, 0x48, 0x39, 0xC8);              /* cmp rax, rcx */
+
+        uint8_t cc = comparison_cc(builtin->builtin_type);
+        emit_jcc(e, jump_if ? cc : cc ^ 1, target);
+        return;
+    }
+
+    /* Otherwise the condition is an integer, which is true if nonzero. */
+    emit_expr(e, node);
+    EMIT(e, 0x48, 0x85, 0xC0);                  /* test rax, rax */
+    emit_jcc(e, jump_if ? CC_NE : CC_E, target);
+}
+
+//// STATEMENTS ////
+
+static void emit_stmt(emitter_t *e, Node *node) {
+    switch (node->type) {
+        case STMT_SEQUENCE: {
+            NodeList *statements = ((NodeStmtSequence *) node)->statements;
+            for (NodeListEntry *entry = statements->head; entry; entry = entry->next) {
+                emit_stmt(e, entry->node);
+            }
+            break;
+        }
+
+        case STMT_ASSIGN:
+        case STMT_ASSIGN_INCREMENT: {
+            NodeStmtAssign *assign = (NodeStmtAssign *) node;
+            if (assign->left->type != EXPR_IDENTIFIER) {
+                e->failed = true;
+                break;
+            }
+
+            emit_expr(e, assign->right);
+
+            /* mov [rdi + slot * 8], rax */
+            int32_t slot = slot_of(e, ((NodeExprIdentifier *) assign->left)->name, false);
+            EMIT(e, 0x48, 0x89, 0x87);
+            emit_i32(e, slot * 8);
+            break;
+        }
+
+        case STMT_IF: {
+            NodeStmtIf *ifn = (NodeStmtIf *) node;
+            size_t otherwise = new_label(e);
+            emit_cond(e, ifn->cond, false, otherwise);
+            emit_stmt(e, ifn->left);
+
+            if (ifn->right) {
+                size_t end = new_label(e);
+                emit_jmp(e, end);
+                bind_label(e, otherwise);
+                emit_stmt(e, ifn->right);
+                bind_label(e, end);
+            } else {
+                bind_label(e, otherwise);
+            }
+            break;
+        }
+
+        case STMT_WHILE: {
+            NodeStmtWhile *whilen = (NodeStmtWhile *) node;
+            size_t top = new_label(e);
+            size_t exit = new_label(e);
+
+            bind_label(e, top);
+            emit_cond(e, whilen->cond, false, exit);
+            emit_stmt(e, whilen->body);
+            emit_jmp(e, top);
+            bind_label(e, exit);
+            break;
+        }
+
+        default:
+            e->failed = true;
+            break;
+    }
+}
+
+/*!
+ * Compiles a while loop to native code. Returns NULL if the loop uses
+ * anything besides integer arithmetic, comparisons, reads from containers
+ * and assignments to variables, or if compilation fails for any other reason.
+ */
+jit_loop_t *jit_compile_loop(NodeStmtWhile *loop) {
+    jit_loop_t *compiled = calloc(1, sizeof(jit_loop_t));
+    if (compiled == NULL) {
+        return NULL;
+    }
+
+    emitter_t *e = calloc(1, sizeof(emitter_t));
+    if (e == NULL) {
+        free(compiled);
+        return NULL;
+    }
+    e->loop = compiled;
+    e->bailout = new_label(e);
+
+    EMIT(e, 0x53);                              /* push rbx */
+    EMIT(e, 0x41, 0x54);                        /* push r12 */
+    EMIT(e, 0x49, 0x89, 0xFC);                  /* mov r12, rdi */
+    EMIT(e, 0x48, 0x89, 0xE3);                  /* mov rbx, rsp */
+    emit_stmt(e, (Node *) loop);
+    EMIT(e, 0x41, 0x5C);                        /* pop r12 */
+    EMIT(e, 0x5B);                              /* pop rbx */
+    EMIT(e, 0xB8, 0x01, 0x00, 0x00, 0x00);      /* mov eax, 1 */
+    EMIT(e, 0xC3);                              /* ret */
+
+    bind_label(e, e->bailout);
+    EMIT(e, 0x48, 0x89, 0xDC);                  /* mov rsp, rbx */
+    EMIT(e, 0x41, 0x5C);                        /* pop r12 */
+    EMIT(e, 0x5B);                              /* pop rbx */
+    EMIT(e, 0x31, 0xC0);                        /* xor eax, eax */
+    EMIT(e, 0xC3);                              /* ret */
+
+    void *code = MAP_FAILED;
+    size_t size = 0;
+    if (!e->failed) {
+        resolve_labels(e);
+
+        /* Copy the code into its own pages, which are made executable only
+         * once they are no longer writable. */
+        size_t page = sysconf(_SC_PAGESIZE);
+        size = (e->length + page - 1) / page * page;
+        code = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+
+    if (code != MAP_FAILED) {
+        memcpy(code, e->code, e->length);
+        if (mprotect(code, size, PROT_READ | PROT_EXEC) != 0) {
+            munmap(code, size);
+            code = MAP_FAILED;
+        }
+    }
+
+    free(e->code);
+    free(e);
+
+    if (code == MAP_FAILED) {
+        free(compiled);
+        return NULL;
+    }
+    compiled->entry = (bool (*)(int64_t *)) code;
+    compiled->code_size = size;
+    return compiled;
+}
+
+/*! Unmaps a compiled loop's code and frees it. */
+void jit_free_loop(jit_loop_t *loop) {
+    munmap((void *) loop->entry, loop->code_size);
+    free(loop);
+}
+
+#else
+
+jit_loop_t *jit_compile_loop(NodeStmtWhile *loop) {
+    (void) loop;
+    return NULL;
+}
+
+void jit_free_loop(jit_loop_t *loop) {
+    (void) loop;
+}
+
+#endif
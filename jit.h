@@ -0,0 +1,65 @@
+/*! \file
+ * A baseline template JIT for hot integer loops on x86-64 Linux.
+ *
+ * A while loop whose condition and body only do integer arithmetic on global
+ * variables is compiled to native code that keeps every variable unboxed in
+ * an array of slots. The evaluator checks that all of the variables hold
+ * integers before entering the code. Inside the loop, only arithmetic that
+ * overflows into a bigint, or divides by zero, can make a variable hold
+ * anything else; the code gives up as soon as that happens, before any of
+ * the slots are stored back, and the evaluator interprets the loop instead.
+ *
+ * The loop may also read from containers it never assigns, through
+ * subscripts and len(). Those compile to calls to helpers in C, and each
+ * call gives up unless it produces an integer. Nothing else is compiled,
+ * subscript assignments and other calls included: giving up runs the loop
+ * again in the interpreter from where it was entered, which is only correct
+ * if the compiled code had no side effects.
+ *
+ * Building with NJIT defined, or for another platform, leaves the JIT out;
+ * jit_compile_loop then always fails and loops are interpreted.
+ */
+
+#ifndef JIT_H
+#define JIT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ast.h"
+
+/*! The largest number of distinct variables a compiled loop may use. */
+#define JIT_MAX_VARS 32
+
+/*!
+ * A compiled loop. It belongs to the AST of its while statement, and is
+ * freed with jit_free_loop when that AST is destroyed.
+ */
+typedef struct jit_loop {
+    /*! The names of the variables the loop uses, in slot order. */
+    const char *vars[JIT_MAX_VARS];
+    size_t num_vars;
+
+    /*!
+     * Whether each variable is a container the loop reads from, rather than
+     * an integer. Its slot holds the variable's reference, and the loop
+     * never assigns it.
+     */
+    bool is_ref[JIT_MAX_VARS];
+
+    /*!
+     * Runs the loop to completion. slots holds the value of each variable on
+     * entry, and is updated with their values on exit. Returns false if the
+     * loop had to give up, leaving slots in an unspecified state.
+     */
+    bool (*entry)(int64_t *slots);
+
+    /*! The size of the pages mapped for the code. */
+    size_t code_size;
+} jit_loop_t;
+
+jit_loop_t *jit_compile_loop(NodeStmtWhile *loop);
+void jit_free_loop(jit_loop_t *loop);
+
+#endif /* JIT_H */
@@ -13,6 +13,7 @@
 #include "refs.h"
 #include "eval.h"
 #include "exception.h"
+#include "shape.h"
 
 /*! The number of bytes in the memory pool. */
 static size_t memory_size;
@@ -158,6 +159,23 @@ void mem_dump() {
                     ((integer_value_t *) value)->integer_value);
                 break;
 
+            case VAL_BIGINT: {
+                bigint_value_t *bigint = (bigint_value_t *) value;
+                fprintf(stdout, "type = VAL_BIGINT; negative = %s; length = %zu\n",
+                    bigint->negative ? "true" : "false", bigint->length);
+                break;
+            }
+
+            case VAL_FLOAT:
+                fprintf(stdout, "type = VAL_FLOAT; value = %g\n",
+                    ((float_value_t *) value)->float_value);
+                break;
+
+            case VAL_FLOAT_ARRAY:
+                fprintf(stdout, "type = VAL_FLOAT_ARRAY; size = %" PRIi64 "\n",
+                    ((float_array_value_t *) value)->size);
+                break;
+
             case VAL_STRING:
                 fprintf(stdout, "type = VAL_STRING; value = \"%s\"\n",
                     ((string_value_t *) value)->string_value);
@@ -170,9 +188,107 @@ void mem_dump() {
 
             case VAL_DICT: {
                 dict_value_t *dict = (dict_value_t *) value;
+                if (dict->keys == NULL_REF) {
+                    fprintf(stdout,
+                        "type = VAL_DICT; shape = %p; values = %d\n",
+                        (void *) dict->shape, dict->values);
+                } else {
+                    fprintf(stdout,
+                        "type = VAL_DICT; keys = %d; values = %d\n",
+                        dict->keys, dict->values);
+                }
+                break;
+            }
+
+            case VAL_RECORD: {
+                record_value_t *record = (record_value_t *) value;
+                fprintf(stdout, "type = VAL_RECORD; fields = [");
+                for (size_t i = 0; i < record->shape->num_keys; i++) {
+                    if (i > 0) {
+                        fprintf(stdout, ", ");
+                    }
+                    fprintf(stdout, "%s: %d", record->shape->keys[i], record->values[i]);
+                }
+                fprintf(stdout, "]\n");
+                break;
+            }
+
+            case VAL_BYTES:
+            case VAL_BYTEARRAY: {
+                bytes_value_t *bytes = (bytes_value_t *) value;
                 fprintf(stdout,
-                    "type = VAL_DICT; keys = %d; values = %d\n",
-                    dict->keys, dict->values);
+                    "type = %s; buffer = %d; start = %" PRIi64 "; length = %" PRIi64 "\n",
+                    value->type == VAL_BYTES ? "VAL_BYTES" : "VAL_BYTEARRAY",
+                    bytes->buffer, bytes->start, bytes->length);
+                break;
+            }
+
+            case VAL_BYTE_BUFFER:
+                fprintf(stdout, "type = VAL_BYTE_BUFFER; capacity = %zu\n",
+                    ((byte_buffer_value_t *) value)->capacity);
+                break;
+
+            case VAL_TUPLE: {
+                tuple_value_t *tuple = (tuple_value_t *) value;
+                fprintf(stdout, "type = VAL_TUPLE; values = (");
+                for (int64_t i = 0; i < tuple->size; i++) {
+                    if (i > 0) {
+                        fprintf(stdout, ", ");
+                    }
+                    fprintf(stdout, "%d", tuple->values[i]);
+                }
+                fprintf(stdout, ")\n");
+                break;
+            }
+
+            case VAL_SET: {
+                set_value_t *set = (set_value_t *) value;
+                fprintf(stdout, "type = VAL_SET; keys = %d\n", set->keys);
+                break;
+            }
+
+            case VAL_WEAKREF: {
+                weakref_value_t *weakref = (weakref_value_t *) value;
+                fprintf(stdout, "type = VAL_WEAKREF; target = %d; next = %d\n",
+                        weakref->target, weakref->next);
+                break;
+            }
+
+            case VAL_WEAKDICT: {
+                weakdict_value_t *weakdict = (weakdict_value_t *) value;
+                fprintf(stdout, "type = VAL_WEAKDICT; keys = %d; values = %d\n",
+                        weakdict->keys, weakdict->values);
+                break;
+            }
+
+            case VAL_VECTOR: {
+                vector_value_t *vector = (vector_value_t *) value;
+                fprintf(stdout, "type = VAL_VECTOR; size = %" PRIi64 "; root = %d\n",
+                        vector->size, vector->root);
+                break;
+            }
+
+            case VAL_PMAP: {
+                pmap_value_t *pmap = (pmap_value_t *) value;
+                fprintf(stdout, "type = VAL_PMAP; size = %" PRIi64 "; root = %d\n",
+                        pmap->size, pmap->root);
+                break;
+            }
+
+            case VAL_HAMT_NODE: {
+                hamt_node_value_t *node = (hamt_node_value_t *) value;
+                size_t num_entries =
+                    2 * __builtin_popcount(node->datamap) + __builtin_popcount(node->nodemap);
+                fprintf(stdout, "type = VAL_HAMT_NODE; datamap = %08" PRIx32
+                        "; nodemap = %08" PRIx32 "; entries = [",
+                        node->datamap, node->nodemap);
+                for (size_t i = 0; i < num_entries; i++) {
+                    if (i > 0) {
+                        fprintf(stdout, ", ");
+                    }
+                    fprintf(stdout, "%d", node->entries[i]);
+                }
+                fprintf(stdout, "]\n");
                 break;
             }
 
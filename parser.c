@@ -1,6 +1,7 @@
 #include "parser.h"
 
 #include "grammar.h"
+#include "repl_history.h"
 
 static void parser_init(parser_t *obj, bool interactive, FILE *stream) {
     assert(obj != NULL);
@@ -111,13 +112,11 @@ int parser_input_wrap(parser_input_t *input) {
         size_t length = strlen(input->buffer);
 
         if (length) {
-            /* Not a blank line, so record it in history. */
+            /* Not a blank line, so record it in history. The history file
+             * is appended to in the background so that a slow home
+             * directory doesn't stall the prompt. */
             add_history(input->buffer);
-
-            /* This is wasteful; we'd prefer to just write the most recent
-             * command to history, but append_history() isn't always
-             * available. */
-            write_history(SUBPYTHON_HISTORY);
+            history_writer_append(input->buffer);
         }
 
         input->buffer[length] = '\n';
@@ -16,6 +16,7 @@
 #include "config.h"
 #include "eval.h"
 #include "mm.h"
+#include "shape.h"
 
 /*! The alignment of value_t structs in the memory pool. */
 #define ALIGNMENT 8
@@ -125,6 +126,7 @@ reference_t make_ref(value_type_t type, size_t size) {
     /* Initialize the value. */
     assert(value->type == VAL_FREE);
     value->type = type;
+    value->weakrefs = NULL_REF;
     value->ref_count = 1; // this is the first reference to the value
 
     /* Set the data area to a pattern so that it's easier to debug. */
@@ -184,6 +186,40 @@ void apply_to_neighbors(void (*f)(reference_t ref), value_t *val) {
         dict_value_t *dict = (dict_value_t *) val;
         f(dict->keys);
         f(dict->values);
+    } else if (val->type == VAL_RECORD) {
+        record_value_t *record = (record_value_t *) val;
+        size_t num_fields = record->shape->num_keys;
+        for (size_t i = 0; i < num_fields; i++) {
+            f(record->values[i]);
+        }
+    } else if (val->type == VAL_BYTES || val->type == VAL_BYTEARRAY) {
+        bytes_value_t *bytes = (bytes_value_t *) val;
+        f(bytes->buffer);
+    } else if (val->type == VAL_TUPLE) {
+        tuple_value_t *tuple = (tuple_value_t *) val;
+        for (int64_t i = 0; i < tuple->size; i++) {
+            f(tuple->values[i]);
+        }
+    } else if (val->type == VAL_SET) {
+        set_value_t *set = (set_value_t *) val;
+        f(set->keys);
+    } else if (val->type == VAL_WEAKDICT) {
+        weakdict_value_t *weakdict = (weakdict_value_t *) val;
+        f(weakdict->keys);
+        f(weakdict->values);
+    } else if (val->type == VAL_VECTOR) {
+        vector_value_t *vector = (vector_value_t *) val;
+        f(vector->root);
+    } else if (val->type == VAL_PMAP) {
+        pmap_value_t *pmap = (pmap_value_t *) val;
+        f(pmap->root);
+    } else if (val->type == VAL_HAMT_NODE) {
+        hamt_node_value_t *node = (hamt_node_value_t *) val;
+        size_t num_entries =
+            2 * __builtin_popcount(node->datamap) + __builtin_popcount(node->nodemap);
+        for (size_t i = 0; i < num_entries; i++) {
+            f(node->entries[i]);
+        }
     } else if (val->type == VAL_REF_ARRAY) {
         ref_array_value_t *ref_array = (ref_array_value_t *) val;
         size_t array_size = ref_array->capacity;
@@ -193,6 +229,53 @@ void apply_to_neighbors(void (*f)(reference_t ref), value_t *val) {
     }
 }
 
+//// WEAK REFERENCES ////
+
+/*
+ * A weak reference's target isn't one of its neighbors, so it neither holds a
+ * count on the target nor keeps it alive through a collection. Instead, every
+ * value that is freed clears the weak references in its list, which is also
+ * what keeps a weak reference from seeing a later value that reuses the
+ * target's reference.
+ */
+
+/*! The number of weak references that have been cleared so far. */
+static uint64_t num_weakrefs_cleared;
+
+/*! Returns the number of weak references that have been cleared so far. */
+uint64_t weakrefs_cleared(void) {
+    return num_weakrefs_cleared;
+}
+
+/*! Clears the weak references to a value that is being freed. */
+static void clear_weakrefs(value_t *val) {
+    reference_t ref = val->weakrefs;
+    while (ref != NULL_REF) {
+        weakref_value_t *weakref = (weakref_value_t *) deref(ref);
+        ref = weakref->next;
+        weakref->target = NULL_REF;
+        weakref->next = NULL_REF;
+        num_weakrefs_cleared++;
+    }
+    val->weakrefs = NULL_REF;
+}
+
+/*! Removes a weak reference that is being freed from its target's list. */
+static void unlink_weakref(value_t *val) {
+    weakref_value_t *weakref = (weakref_value_t *) val;
+    if (weakref->target == NULL_REF) {
+        return;
+    }
+
+    reference_t *link = &deref(weakref->target)->weakrefs;
+    while (deref(*link) != val) {
+        link = &((weakref_value_t *) deref(*link))->next;
+    }
+    *link = weakref->next;
+}
+
+//// END WEAK REFERENCES ////
+
 //// REFERENCE COUNTING ////
 
 /*! Increases the reference count of the value at the given reference. */
@@ -209,10 +292,14 @@ void incref(reference_t ref) {
  * by the value must be decrefed once its freed.
  */
 void decref(reference_t ref) {
-    if (ref != TOMBSTONE_REF && ref != NULL_REF) {
+    if (ref != NULL_REF) {
         value_t *val = deref(ref);
         val->ref_count--;
         if (val->ref_count == 0) {
+            clear_weakrefs(val);
+            if (val->type == VAL_WEAKREF) {
+                unlink_weakref(val);
+            }
             apply_to_neighbors(decref, val);
             mm_free(val);
             ref_table[ref] = NULL;
@@ -230,7 +317,7 @@ void decref(reference_t ref) {
  * Updates reference table and reference counters accordingly.
  */
 void move(reference_t ref) {
-    if (ref != NULL_REF && ref != TOMBSTONE_REF) {
+    if (ref != NULL_REF) {
         value_t *val = deref(ref);
         /* If the value hasn't been moved, move it. */
         if (!is_pool_address(val)) {
@@ -265,6 +352,18 @@ void stop_and_copy(const char *name, reference_t ref) {
  * that have not been moved to the to_space.
  */
 void clean_cycles() {
+    /* The garbage is still intact in the from space, so first detach it from
+     * weak references, before any of their references are reused. */
+    for (int i = 0; i < num_refs; i++) {
+        value_t *val = ref_table[i];
+        if (val != NULL && !is_pool_address(val)) {
+            clear_weakrefs(val);
+            if (val->type == VAL_WEAKREF) {
+                unlink_weakref(val);
+            }
+        }
+    }
+
     for (int i = 0; i < num_refs; i++) {
         if (!is_pool_address(ref_table[i])) {
             ref_table[i] = NULL;
@@ -37,6 +37,9 @@ void incref(reference_t ref);
 /* Decreases the reference count of the value at the given reference. */
 void decref(reference_t ref);
 
+/* Returns the number of weak references that have been cleared so far. */
+uint64_t weakrefs_cleared(void);
+
 /* Runs the garbage collector to reclaim unused space. */
 void collect_garbage(void);
 
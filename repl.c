@@ -18,6 +18,7 @@
 #include "mm.h"
 #include "parser.h"
 #include "refs.h"
+#include "repl_history.h"
 
 #define DEFAULT_MEMORY_SIZE 1024
 
@@ -39,6 +40,8 @@ bool eval(Node *node) {
         /* Check if there is an exception. */
         if (exception_occurred()) {
             completed = false;
+            /* Flush first, so the error comes after any earlier output. */
+            fflush(stdout);
             exception_print(stderr);
             exception_clear();
         } else if (!ref_is_none(result)) {
@@ -112,6 +115,9 @@ void read_eval_print_loop(FILE *input) {
     /* Load command history, if any exists. */
     read_history(SUBPYTHON_HISTORY);
 
+    /* Append new entries to the history file as they are entered. */
+    history_writer_start(SUBPYTHON_HISTORY);
+
     /* Disable filename auto-complete on TAB key. */
     rl_bind_key('\t', rl_insert);
 #endif
@@ -119,6 +125,11 @@ void read_eval_print_loop(FILE *input) {
     /* Continue consuming input until we are told to exit. */
     while (try_parse(input) != REPL_ACTION_EXIT);
 
+#ifndef NREADLINE
+    /* Make sure the last entries have been written out. */
+    history_writer_stop();
+#endif
+
     /* Output a nice exit message. */
     fprintf(stderr, "\nQuitting, goodbye.\n");
 }
@@ -133,6 +144,8 @@ void usage(FILE *stream, char *program) {
     fprintf(stream, " -d             run in debug mode:\n");
     fprintf(stream, "                  the REPL will printing out the current bindings and\n");
     fprintf(stream, "                  memory contents after every evaluation\n");
+    fprintf(stream, " -p             print the most frequently evaluated pairs of AST\n");
+    fprintf(stream, "                  node types on exit\n");
 }
 
 
@@ -146,7 +159,7 @@ int main(int argc, char **argv) {
 
     size_t memory_size = DEFAULT_MEMORY_SIZE;
     int c;
-    while ((c = getopt(argc, argv, "hm:d")) != -1) {
+    while ((c = getopt(argc, argv, "hm:dp")) != -1) {
         switch (c) {
             case 'h':
                 usage(stdout, argv[0]);
@@ -165,6 +178,10 @@ int main(int argc, char **argv) {
                 debug = 1;
                 break;
 
+            case 'p':
+                eval_profile_start();
+                break;
+
             case '?':
                 usage(stderr, argv[0]);
                 exit(1);
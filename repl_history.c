@@ -0,0 +1,154 @@
+/*! \file
+ * Persists REPL command history without blocking the interactive loop.
+ * New entries are appended to the history file by a background thread.
+ * Entries that arrive while a write is in progress are coalesced, so the
+ * file is touched at most once per batch instead of being rewritten in full
+ * after every line.
+ */
+
+#include "repl_history.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+
+static struct {
+    /*! Whether the writer thread is currently running. */
+    bool running;
+
+    /*! Set when the writer thread should flush what it has and exit. */
+    bool stopping;
+
+    /*! The file that history entries are appended to. */
+    const char *path;
+
+    /*! Newline-separated entries that have not been written yet. */
+    char *pending;
+    size_t length;
+    size_t capacity;
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+} writer = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER
+};
+
+/*!
+ * The body of the writer thread. Waits for entries to be queued, then takes
+ * the whole batch and appends it to the history file with the lock released.
+ */
+static void *history_writer_main(void *arg) {
+    (void) arg;
+
+    pthread_mutex_lock(&writer.lock);
+    while (true) {
+        while (writer.length == 0 && !writer.stopping) {
+            pthread_cond_wait(&writer.wake, &writer.lock);
+        }
+        if (writer.length == 0 && writer.stopping) {
+            break;
+        }
+
+        /* Take ownership of everything queued so far. */
+        char *batch = writer.pending;
+        size_t length = writer.length;
+        writer.pending = NULL;
+        writer.length = 0;
+        writer.capacity = 0;
+        pthread_mutex_unlock(&writer.lock);
+
+        FILE *file = fopen(writer.path, "a");
+        if (file != NULL) {
+            fwrite(batch, 1, length, file);
+            fclose(file);
+        }
+        free(batch);
+
+        pthread_mutex_lock(&writer.lock);
+    }
+    pthread_mutex_unlock(&writer.lock);
+
+    return NULL;
+}
+
+/*!
+ * Starts the background writer that appends entries to the file at path.
+ * The writer is stopped automatically when the process exits.
+ */
+void history_writer_start(const char *path) {
+    if (writer.running) {
+        return;
+    }
+
+    writer.path = path;
+    writer.stopping = false;
+    if (pthread_create(&writer.thread, NULL, history_writer_main, NULL) != 0) {
+        /* History is a convenience; carry on without it. */
+        fprintf(stderr, "could not start history writer\n");
+        return;
+    }
+    writer.running = true;
+
+    /* exit() can be called from within the evaluator, so make sure that
+     * queued entries still reach the file in that case. */
+    static bool registered = false;
+    if (!registered) {
+        atexit(history_writer_stop);
+        registered = true;
+    }
+}
+
+/*! Queues a single history entry to be appended to the history file. */
+void history_writer_append(const char *line) {
+    if (!writer.running) {
+        return;
+    }
+
+    size_t line_length = strlen(line);
+
+    pthread_mutex_lock(&writer.lock);
+    size_t needed = writer.length + line_length + 1;
+    if (needed > writer.capacity) {
+        size_t capacity = writer.capacity == 0 ? INITIAL_SIZE * 16 : writer.capacity;
+        while (capacity < needed) {
+            capacity *= 2;
+        }
+
+        char *pending = realloc(writer.pending, capacity);
+        if (pending == NULL) {
+            /* Drop the entry rather than fail the interactive session. */
+            pthread_mutex_unlock(&writer.lock);
+            return;
+        }
+        writer.pending = pending;
+        writer.capacity = capacity;
+    }
+
+    memcpy(writer.pending + writer.length, line, line_length);
+    writer.pending[writer.length + line_length] = '\n';
+    writer.length = needed;
+
+    pthread_cond_signal(&writer.wake);
+    pthread_mutex_unlock(&writer.lock);
+}
+
+/*! Flushes any queued entries and stops the background writer. */
+void history_writer_stop(void) {
+    if (!writer.running) {
+        return;
+    }
+
+    pthread_mutex_lock(&writer.lock);
+    writer.stopping = true;
+    pthread_cond_signal(&writer.wake);
+    pthread_mutex_unlock(&writer.lock);
+
+    pthread_join(writer.thread, NULL);
+    writer.running = false;
+}
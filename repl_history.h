@@ -0,0 +1,8 @@
+#ifndef REPL_HISTORY_H
+#define REPL_HISTORY_H
+
+void history_writer_start(const char *path);
+void history_writer_append(const char *line);
+void history_writer_stop(void);
+
+#endif /* REPL_HISTORY_H */
@@ -0,0 +1,98 @@
+/*! \file
+ * Implements the shape tree shared by values with string-named slots.
+ */
+
+#include "shape.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "exception.h"
+
+/*! The shape with no keys, from which all other shapes are derived. */
+static shape_t root_shape;
+
+/*! Returns the shape with no keys. */
+shape_t *shape_root(void) {
+    return &root_shape;
+}
+
+/*!
+ * Returns the shape reached by adding key to shape if that transition has
+ * been taken before, or NULL otherwise.
+ */
+shape_t *shape_transition(const shape_t *shape, const char *key) {
+    for (size_t i = 0; i < shape->num_transitions; i++) {
+        shape_t *child = shape->transitions[i];
+        if (strcmp(child->keys[child->num_keys - 1], key) == 0) {
+            return child;
+        }
+    }
+    return NULL;
+}
+
+/*!
+ * Returns the shape reached by adding key to shape, creating it if this
+ * transition hasn't been taken before. The key must not already be in shape.
+ * Returns NULL and sets a MemoryError if the shape could not be allocated.
+ */
+shape_t *shape_add_key(shape_t *shape, const char *key) {
+    /* Follow an existing transition if there is one. */
+    shape_t *existing = shape_transition(shape, key);
+    if (existing != NULL) {
+        return existing;
+    }
+
+    /* Otherwise, build the new shape. Each shape owns its own key table so
+     * that slot lookups don't have to walk the parent chain. The key strings
+     * themselves are shared with the parent. */
+    shape_t *child = malloc(sizeof(shape_t));
+    const char **keys = malloc(sizeof(const char *[shape->num_keys + 1]));
+    char *new_key = strdup(key);
+    if (child == NULL || keys == NULL || new_key == NULL) {
+        free(child);
+        free(keys);
+        free(new_key);
+        exception_set(EXC_MEMORY_ERROR, "could not allocate shape");
+        return NULL;
+    }
+
+    if (shape->num_keys > 0) {
+        memcpy(keys, shape->keys, sizeof(const char *[shape->num_keys]));
+    }
+    keys[shape->num_keys] = new_key;
+
+    *child = (shape_t) {
+        .parent = shape,
+        .num_keys = shape->num_keys + 1,
+        .keys = keys
+    };
+
+    /* Record the transition so that later values reuse this shape. */
+    if (shape->num_transitions == shape->max_transitions) {
+        size_t max_transitions = shape->max_transitions == 0 ?
+            INITIAL_SIZE : shape->max_transitions * 2;
+        shape_t **transitions = realloc(shape->transitions,
+                sizeof(shape_t *[max_transitions]));
+        if (transitions == NULL) {
+            /* The shape is still usable, it just won't be shared. */
+            return child;
+        }
+        shape->transitions = transitions;
+        shape->max_transitions = max_transitions;
+    }
+    shape->transitions[shape->num_transitions++] = child;
+
+    return child;
+}
+
+/*! Returns the slot of key in shape, or -1 if the shape has no such key. */
+int64_t shape_find(const shape_t *shape, const char *key) {
+    for (size_t i = 0; i < shape->num_keys; i++) {
+        if (strcmp(shape->keys[i], key) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
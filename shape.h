@@ -0,0 +1,42 @@
+#ifndef SHAPE_H
+#define SHAPE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*!
+ * A shape (sometimes called a hidden class) describes the layout of a value
+ * whose fields are named by strings. Each key is assigned a fixed slot, so a
+ * value with a shape only needs to store a dense array of field values.
+ *
+ * Shapes form a tree: the root shape has no keys, and adding a key to a shape
+ * follows (or creates) a transition to a child shape. Values that are built by
+ * adding the same keys in the same order therefore share one shape, and with
+ * it one copy of the key table.
+ *
+ * Shapes are allocated with malloc() rather than from the memory pool, and
+ * live for the remainder of the program.
+ */
+typedef struct shape shape_t;
+struct shape {
+    /*! The shape this one was derived from, or NULL for the root shape. */
+    shape_t *parent;
+
+    /*! The number of keys (and therefore slots) in this shape. */
+    size_t num_keys;
+
+    /*! The keys of this shape in slot order. The last one is the newest. */
+    const char **keys;
+
+    /*! The shapes reachable by adding a single key to this shape. */
+    shape_t **transitions;
+    size_t num_transitions;
+    size_t max_transitions;
+};
+
+shape_t *shape_root(void);
+shape_t *shape_transition(const shape_t *shape, const char *key);
+shape_t *shape_add_key(shape_t *shape, const char *key);
+int64_t shape_find(const shape_t *shape, const char *key);
+
+#endif /* SHAPE_H */
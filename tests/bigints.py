@@ -0,0 +1,68 @@
+# -m 100000
+
+# Integers that overflow 64 bits turn into bigints, and back again once
+# they fit.
+big = 9223372036854775807 + 1
+# output 9223372036854775808 -9223372036854775809 9223372036854775807
+print(big, -big - 1, big - 1)
+m = -9223372036854775807 - 1
+# output 9223372036854775808 0 9223372036854775808 -9223372036854775808
+print(m / -1, m % -1, -m, -(-m))
+
+# Bigints mix with integers in arithmetic and comparisons.
+p = 1
+i = 0
+while i < 100:
+    p = p * 3
+    i = i + 1
+# output 515377520732011331036461129765621272702107522001 100
+print(p, i)
+# output 171792506910670443678820376588540424234035840667 4 True True False
+print(p / 3, p % 7, p > 1, -p < 0, p == p + 1)
+# output 0 515377520732011331036461129765621272702107522001 True
+print(p - p, p * p / p, p * 2 == p + p)
+# output -171792506910670443678820376588540424234035840667 -4
+print(-p / 3, -p % 7)
+
+# Division truncates toward zero, and the remainder takes the dividend's sign,
+# as it does for small integers.
+q = p * p
+# output 1 -1 3
+print(q / (q - 1), -q / (q - 1), (q + 2) % (q / 2))
+
+# Bigints hash by value, so equal ones find the same dict entry.
+d = {p: "p", p * p: "q"}
+# output p q True
+print(d[3 * (p / 3)], d[q], contains(d, p * 2 / 2))
+
+# Factorials exercise long multiplication.
+f = 1
+n = 1
+while n <= 60:
+    f = f * n
+    n = n + 1
+# output 8320987112741390144276341183223364380754172606361245952449277696409600000000000000
+print(f)
+
+# A compiled loop gives up when it overflows, and the rest of it is
+# interpreted with bigints.
+s = 0
+j = 0
+while j < 20000:
+    s = s + 1000000000000000
+    j = j + 1
+# output 20000000000000000000 20000
+print(s, j)
+
+del big
+del m
+del p
+del i
+del q
+del d
+del f
+del n
+del s
+del j
+# output 72 bytes in use; 3 refs in use
+mem()
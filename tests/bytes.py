@@ -0,0 +1,61 @@
+# -m 100000
+
+# There is no b"..." syntax, so bytes are made from strings, counts and lists.
+a = bytes("hello, world")
+# output b"hello, world" 12 104 100
+print(a, len(a), a[0], a[-1])
+# output b"\x00\x00\x00" b"\x00\x01\"\\A\xff" b"" bytearray(b"")
+print(bytes(3), bytes([0, 1, 34, 92, 65, 255]), bytes(), bytearray())
+
+# Slices clamp their bounds like Python, and share the original's buffer.
+# output b"world" b"worl" b"" b""
+print(slice(a, 7), slice(a, -5, -1), slice(a, 20, 30), slice(a, 3, 1))
+
+# Bytearrays copy a shared buffer before writing to it.
+s = slice(a, 7)
+b = bytearray(a)
+b[0] = 72
+c = bytearray(s)
+c[0] = 87
+# output bytearray(b"Hello, world") b"hello, world" bytearray(b"World") b"world"
+print(b, a, c, s)
+
+append(b, 33)
+# output bytearray(b"Hello, world!") b"hello, world!" bytearray(b"Hello, world!\x0a")
+print(b, a + bytes("!"), b + bytearray([10]))
+
+# output True True False True False
+print(contains(a, 104), contains(a, bytes("world")), contains(a, bytes("worlds")), contains(a, bytes()), contains(a, 0))
+# output True False True False True
+print(a == bytes("hello, world"), a < bytes("hello"), bytes("abc") < bytes("abd"), bool(bytes()), bool(a))
+
+# Bytes are hashable, bytearrays are not.
+d = {a: 1, s: 2}
+# output 1 2
+print(d[bytes("hello, world")], d[bytes("world")])
+
+# Appending grows the buffer geometrically.
+e = bytearray()
+i = 0
+while i < 1000:
+    append(e, i % 256)
+    i = i + 1
+# output 1000 bytearray(b"\xe3\xe4\xe5\xe6\xe7")
+print(len(e), slice(e, 995))
+
+# A slice keeps the whole buffer alive after the original is gone.
+f = slice(e, 0, 3)
+del e
+gc()
+# output bytearray(b"\x00\x01\x02")
+print(f)
+
+del a
+del s
+del b
+del c
+del d
+del f
+del i
+# output 72 bytes in use; 3 refs in use
+mem()
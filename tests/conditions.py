@@ -0,0 +1,64 @@
+# -m 100000
+
+# Conditions with and, or and not short-circuit like any other expression.
+a = [5, 3, 8, 1]
+i = 0
+n = 0
+while i < len(a) and not a[i] == 8:
+    n = n + a[i]
+    i = i + 1
+# output 2 8
+print(i, n)
+
+# Comparisons that have been quickened for integers stay exact in conditions.
+hits = 0
+j = 0
+while j < 50:
+    if j % 7 == 0 or j > 45 and not j == 48:
+        hits = hits + 1
+    j = j + 1
+# output 10
+print(hits)
+
+# Mixed types fall back to the generic comparison.
+x = 0
+while x < 3 or x < float(4):
+    x = x + 1
+# output 4
+print(x)
+k = 0
+m = 0
+while k < 60:
+    if k < 30 or "b" < "a":
+        m = m + 1
+    k = k + 1
+# output 30
+print(m)
+
+# Subscripts, variables and other values are tested for their truth value.
+b = [1, 2]
+empty = []
+# output yes
+if empty or b[0] < b[1] and b:
+    print("yes")
+# output still yes
+if not empty and not b[1] < b[0]:
+    print("still yes")
+flag = not b
+# output False True
+print(flag, not flag)
+
+# No references are left behind by conditions.
+del a
+del b
+del empty
+del flag
+del i
+del n
+del hits
+del j
+del x
+del k
+del m
+# output 72 bytes in use; 3 refs in use
+mem()
@@ -0,0 +1,51 @@
+# -m 60000
+
+# Copies are independent once either side is modified.
+a = [1, 2, [3]]
+b = copy(a)
+b[0] = 10
+# output [1, 2, [3]] [10, 2, [3]]
+print(a, b)
+del a[1]
+# output [1, [3]] [10, 2, [3]]
+print(a, b)
+
+# Copies are shallow, so nested containers are still shared.
+b[2][0] = 30
+# output [1, [30]] [10, 2, [30]]
+print(a, b)
+
+# Shaped and hash table dicts can both be copied.
+p = {"x": 1, "y": 2}
+q = copy(p)
+q["z"] = 3
+p["x"] = 0
+# output {"x": 0, "y": 2} {"x": 1, "y": 2, "z": 3}
+print(p, q)
+
+h = {1: "one", 2: "two"}
+g = copy(copy(h))
+del g[1]
+# output 2 1 True False
+print(len(h), len(g), contains(h, 1), contains(g, 1))
+# output True
+print(copy([]) == [] and copy({}) == {})
+
+# Copying a large list takes no more memory until the copy is modified.
+del a
+del b
+del p
+del q
+del h
+del g
+big = [0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15]
+# output 744 bytes in use; 21 refs in use
+mem()
+snapshot = copy(big)
+# output 784 bytes in use; 22 refs in use
+mem()
+snapshot[0] = -1
+# output 920 bytes in use; 24 refs in use
+mem()
+# output 0 -1
+print(big[0], snapshot[0])
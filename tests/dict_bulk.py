@@ -0,0 +1,35 @@
+# -m 60000
+
+# Literals that need a hash table are built in one pass. Repeated keys keep
+# the last value, as if the pairs were assigned in order.
+d = {1: "a", 2: "b", 1: "c", "x": 3, 2: "d", "x": 4}
+# output 3 c d 4
+print(len(d), d[1], d[2], d["x"])
+
+big = {"k0": 0, "k1": 1, "k2": 2, "k3": 3, "k4": 4, "k5": 5, "k6": 6, "k7": 7,
+       "k8": 8, "k9": 9, "k10": 10, "k11": 11, "k12": 12, "k13": 13, "k14": 14,
+       "k15": 15, "k16": 16, "k0": 100}
+# output 17 100 16
+print(len(big), big["k0"], big["k16"])
+
+# dict(n) presizes a dict that is about to be filled in a loop.
+e = dict(200)
+i = 0
+while i < 200:
+    e[i * 7] = i
+    i = i + 1
+# output 200 199 {} {}
+print(len(e), e[1393], dict(), dict(3))
+
+f = dict(3)
+f["a"] = 1
+# output {"a": 1}
+print(f)
+
+del d
+del big
+del e
+del f
+del i
+# output 72 bytes in use; 3 refs in use
+mem()
@@ -0,0 +1,52 @@
+# -m 200000
+
+# Deleting keys shifts the following ones back, so lookups keep working
+# after lots of churn.
+d = {}
+seed = 12345
+step = 0
+while step < 20000:
+    seed = (seed * 1103515245 + 12345) % 2147483648
+    k = seed % 512
+    if seed / 512 % 3 == 0:
+        if contains(d, k):
+            del d[k]
+    else:
+        d[k] = step
+    step = step + 1
+
+total = 0
+count = 0
+k = 0
+while k < 512:
+    v = get(d, k, -1)
+    if v > -1:
+        total = total + v
+        count = count + 1
+    k = k + 1
+# output 363 363 7163377
+print(len(d), count, total)
+
+# String keys behave the same once the dict is a hash table.
+s = {"a": 1}
+del s["a"]
+i = 0
+while i < 300:
+    s["key" + str(i % 40)] = i
+    if i % 3 == 0:
+        del s["key" + str(i % 40)]
+    i = i + 1
+# output 27 299 298 None
+print(len(s), s["key19"], s["key18"], get(s, "key39"))
+
+del d
+del s
+del seed
+del step
+del total
+del count
+del k
+del v
+del i
+# output 72 bytes in use; 3 refs in use
+mem()
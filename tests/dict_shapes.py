@@ -0,0 +1,43 @@
+# -m 10000
+
+# Dicts with only string keys share a shape and keep insertion order.
+a = {"x": 1, "y": 2}
+b = {}
+b["x"] = 3
+b["y"] = 4
+b["z"] = 5
+# output {"x": 1, "y": 2} {"x": 3, "y": 4, "z": 5}
+print(a, b)
+b["x"] = b["z"]
+# output 5 3 2
+print(b["x"], len(b), len(a))
+
+# Dicts in different representations still compare by contents.
+c = {"y": 2}
+c["x"] = 1
+# output True False
+print(a == c, a == b)
+
+# Adding a non-string key or deleting a key switches to a hash table.
+c[1] = "one"
+del b["y"]
+# output one 2 5
+print(c[1], len(b), b["z"])
+# output False True
+print(a == c, b == {"x": 5, "z": 5})
+del a
+del b
+del c
+
+# Very large dicts also fall back to the hash table.
+d = {}
+i = 0
+while i < 40:
+    d["k" + str(i)] = i
+    i = i + 1
+# output 40 0 39
+print(len(d), d["k0"], d["k39"])
+del d
+del i
+# output 72 bytes in use; 3 refs in use
+mem()
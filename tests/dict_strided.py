@@ -0,0 +1,40 @@
+# -m 2000000
+
+# Integer keys that are all multiples of a large power of two still spread
+# across the table, so this finishes quickly.
+d = {}
+i = 0
+while i < 3000:
+    d[i * 4096] = i
+    i = i + 1
+
+total = 0
+i = 0
+while i < 3000:
+    total = total + d[i * 4096]
+    i = i + 1
+# output 3000 4498500
+print(len(d), total)
+
+# Missing keys with the same stride are found to be absent.
+misses = 0
+i = 3000
+while i < 6000:
+    if not contains(d, i * 4096):
+        misses = misses + 1
+    i = i + 1
+# output 3000
+print(misses)
+
+# Negative strided keys work the same way.
+e = {-65536: "a", -131072: "b", 65536: "c"}
+# output a b c
+print(e[-65536], e[-131072], e[65536])
+
+del d
+del e
+del i
+del total
+del misses
+# output 72 bytes in use; 3 refs in use
+mem()
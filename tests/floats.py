@@ -0,0 +1,93 @@
+# -m 100000
+
+# There is no float literal syntax, so floats are made with float().
+half = float("0.5")
+# output 0.5 3.0 -2.5 1e+16 1.5e-05 0.0001
+print(half, float(3), float(" -2.5 "), float("1e16"), float("1.5e-5"), float("0.0001"))
+# output inf -inf nan -0.0
+print(float("inf"), float("-inf"), float("nan"), -float(0))
+
+# Floats print as the shortest decimal that reads back as the same float.
+# output 0.30000000000000004 0.3333333333333333 100.0
+print(float("0.1") + float("0.2"), 1 / float(3), float(10) * 10)
+
+# Integers and bigints mix with floats, which compare with them exactly.
+big = 1000000000000 * 1000000000000 * 1000000000000
+# output 3.5 -0.5 1.5 4.0 1.5
+print(half + 3, half - 1, 3 * half, 2 / half, float("7.5") % 2)
+# output 1e+36 1e+36 5e+35
+print(float(big), float(big) + 1, big * half)
+# output True False True True False False
+print(1 == float(1), float(big) == big, float(2) < 3, 3 > float("2.5"), half == 1, float("nan") == float("nan"))
+
+# NaN is unordered, so every comparison with it is false.
+nan = float("nan")
+# output False False False False False False False False
+print(nan == nan, nan <= nan, nan >= half, half <= nan, nan < 1, 1 >= nan, nan <= big, big > nan)
+# output False False
+print([nan] < [half], tuple(nan, 1) >= tuple(half, 1))
+unordered = 0
+i = 0
+while i < 20:
+    if nan <= half or nan >= half:
+        unordered = unordered + 1
+    i = i + 1
+# output 0
+print(unordered)
+del nan
+del unordered
+
+# Equal numbers find the same dict entry.
+d = {1: "one", 2: "two"}
+d[float(2)] = "two again"
+# output one {1: "one", 2: "two again"}
+print(d[float(1)], d)
+
+# int() truncates floats towards zero.
+# output 2 -2 1000000000000000042420637374017961984
+print(int(float("2.9")), int(float("-2.9")), int(float(big)))
+
+# Arrays hold unboxed floats, and arithmetic on them is elementwise.
+a = array([1, 2, 3, 4, 5])
+b = a * 2 + 1
+# output array([1.0, 2.0, 3.0, 4.0, 5.0]) array([3.0, 5.0, 7.0, 9.0, 11.0]) 5
+print(a, b, len(b))
+# output array([4.0, 7.0, 10.0, 13.0, 16.0]) array([-2.0, -3.0, -4.0, -5.0, -6.0])
+print(a + b, a - b)
+# output array([1.0, 0.5, 0.25, 0.2, 0.125]) array([-1.0, -2.0, -3.0, -4.0, -5.0])
+print(1 / array([1, 2, 4, 5, 8]), -a)
+
+# Division by zero gives infinities instead of an error.
+# output array([inf, -inf, 0.0])
+print(array([1, -1, 0]) / array([0, 0, 1]))
+
+# Arrays can be indexed and assigned, and convert what's stored to floats.
+a[0] = 10
+a[-1] = half
+# output array([10.0, 2.0, 3.0, 4.0, 0.5]) 10.0 0.5 True False
+print(a, a[0], a[-1], contains(a, 10), contains(a, 7))
+# output array([0.0, 0.0, 0.0]) True False
+print(array(3), array(a) == a, a == b)
+
+# sum() adds up lists and tuples too.
+# output 15.0 6 3.5
+print(sum(b - a + a - 1 - b + 4), sum([1, 2, 3]), sum(tuple(1, 2, half)))
+
+# Long arrays fill whole vectors with a few elements left over.
+n = 1003
+z = array(n)
+i = 0
+while i < n:
+    z[i] = i
+    i = i + 1
+# output 502503.0 335839505.0 1003
+print(sum(z), sum(z * z), len(z))
+
+# output 8792 bytes in use; 17 refs in use
+mem()
+
+# An array too big to address raises a MemoryError rather than wrapping
+# around to a small allocation. The error ends the program.
+# output MemoryError: cannot allocate an array of 2305843009213693952 floats
+# output exit status 1
+array(2305843009213693952)
@@ -0,0 +1,46 @@
+# -m 4000
+
+# The same operator and subscript nodes see different types in turn, so
+# their inline caches have to be refilled.
+items = [1, "a", 2, "b"]
+containers = [[10, 20], {1: "x"}, [30], {1: "y"}]
+# output 2 True False 1
+# output aa False False a
+# output 4 False False 2
+# output bb False False b
+# output 2 True False 1
+# output aa False False a
+# output 4 False False 2
+# output bb False False b
+i = 0
+while i < 8:
+    x = items[i % 4]
+    c = containers[i % 4]
+    c[0] = x
+    print(x + x, x == 1, x < x, c[0])
+    i = i + 1
+
+# Operators that have only seen integers are quickened, and have to fall back
+# to generic dispatch when that changes.
+values = [1, 2, 3, 4, 5, 6, "s", 8]
+# output 2 False True
+# output 4 False True
+# output 6 False True
+# output 8 False True
+# output 10 False True
+# output 12 False True
+# output ss False True
+# output 16 False True
+i = 0
+while i < len(values):
+    x = values[i]
+    print(x + x, x < x, x == x)
+    i = i + 1
+del values
+del items
+del containers
+del i
+del x
+del c
+# output 72 bytes in use; 3 refs in use
+mem()
@@ -0,0 +1,8 @@
+# -m 1000
+
+# An integer literal too large for 64 bits is rejected before anything runs,
+# rather than being clamped.
+# output <stdin>:8:7: OverflowError: integer literal is too large
+# output exit status 1
+print(9223372036854775807)
+print(100000000000000000000)
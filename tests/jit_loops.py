@@ -0,0 +1,99 @@
+# -m 4000
+
+# Long integer loops are compiled to native code once they get hot.
+total = 0
+i = 0
+while i < 100000:
+    if i % 3 == 0 or i % 5 == 0:
+        total = total + i
+    i = i + 1
+# output 2333316668 100000
+print(total, i)
+
+# Nested loops, else branches and negative division.
+count = 0
+acc = 0
+a = 0
+while a < 300:
+    b = 0
+    while b < 300:
+        if a * b % 7 == 3 and not b > a:
+            count = count + 1
+        else:
+            acc = acc + (a - b) / 3 - (b - a) % 4
+        b = b + 1
+    a = a + 1
+# output 5504 -189746 300 300
+print(count, acc, a, b)
+
+# A variable that is shared with another is not updated in place.
+n = 1000
+m = n
+k = 0
+while n > 0:
+    n = n - 1
+    k = k + 2
+# output 0 1000 2000
+print(n, m, k)
+
+# Loops over values other than integers are still interpreted.
+s = "x"
+j = 0
+while j < 200:
+    if j > 196:
+        s = s + "y"
+    j = j + 1
+# output xyyy 200
+print(s, j)
+
+# Loops can read lists and dicts they don't assign, and take their lengths.
+a = [3, 1, 4, 1, 5, 9, 2, 6]
+d = {1: 10, 2: 20, 3: 30}
+total = 0
+i = 0
+while i < 10000:
+    total = total + a[i % len(a)] * a[-1] - d[i % 3 + 1]
+    i = i + 1
+# output 32510 10000
+print(total, i)
+
+# Comparisons between elements, as when sorting.
+count = 0
+j = 0
+while j < 2000:
+    k = 0
+    while k < len(a) - 1:
+        if a[k] > a[k + 1]:
+            count = count + 1
+        k = k + 1
+    j = j + 1
+# output 6000 2000 7
+print(count, j, k)
+
+# An element that isn't an integer sends the loop back to the interpreter.
+a = [1, 2, float(3)]
+total = 0
+i = 0
+while i < 1000:
+    if i < 990:
+        total = total + a[i % 2]
+    else:
+        total = total + a[2]
+    i = i + 1
+# output 1515.0 1000
+print(total, i)
+
+del total
+del i
+del count
+del acc
+del a
+del b
+del n
+del m
+del k
+del d
+del s
+del j
+# output 72 bytes in use; 3 refs in use
+mem()
@@ -7,10 +7,10 @@ c = {"value": "three", "prev": b, "next": None}
 b["next"] = c
 d = {"value": [4, 5], "prev": c, "next": None}
 c["next"] = d
-# output 1624 bytes in use; 33 refs in use
+# output 664 bytes in use; 17 refs in use
 mem()
 gc()
-# output 1624 bytes in use; 33 refs in use
+# output 664 bytes in use; 17 refs in use
 mem()
 # output 1 True three [4, 5]
 print(a["value"], a["next"]["value"], a["next"]["next"]["value"], a["next"]["next"]["next"]["value"])
@@ -21,10 +21,10 @@ print(d["prev"]["prev"]["prev"]["value"], d["prev"]["prev"]["value"], d["prev"][
 del b
 a["next"] = c
 c["prev"] = a
-# output 1288 bytes in use; 27 refs in use
+# output 568 bytes in use; 15 refs in use
 mem()
 gc()
-# output 1288 bytes in use; 27 refs in use
+# output 568 bytes in use; 15 refs in use
 mem()
 # output 1 three [4, 5]
 print(a["value"], a["next"]["value"], a["next"]["next"]["value"])
@@ -34,20 +34,20 @@ print(d["prev"]["prev"]["value"], d["prev"]["value"], d["value"])
 # Remove references to head and tail
 del a
 gc()
-# output 1288 bytes in use; 27 refs in use
+# output 568 bytes in use; 15 refs in use
 mem()
 # output 1 three [4, 5]
 print(c["prev"]["value"], c["value"], c["next"]["value"])
 del d
 gc()
-# output 1288 bytes in use; 27 refs in use
+# output 568 bytes in use; 15 refs in use
 mem()
 # output 1 three [4, 5]
 print(c["prev"]["value"], c["value"], c["next"]["value"])
 
 # Remove remaining reference to list
 del c
-# output 1288 bytes in use; 27 refs in use
+# output 568 bytes in use; 15 refs in use
 mem()
 gc()
 # output 72 bytes in use; 3 refs in use
@@ -68,10 +68,10 @@ del a
 del b
 del d
 del e
-# output 1912 bytes in use; 38 refs in use
+# output 712 bytes in use; 18 refs in use
 mem()
 gc()
-# output 1912 bytes in use; 38 refs in use
+# output 712 bytes in use; 18 refs in use
 mem()
 # output 1 2 3 4 5
 print(c["prev"]["prev"]["value"], c["prev"]["value"], c["value"], c["next"]["value"], c["next"]["next"]["value"])
@@ -79,13 +79,13 @@ c["prev"]["next"] = None
 c["next"]["prev"] = None
 # output 1 2 3 4 5
 print(c["prev"]["prev"]["value"], c["prev"]["value"], c["value"], c["next"]["value"], c["next"]["next"]["value"])
-# output 1912 bytes in use; 38 refs in use
+# output 712 bytes in use; 18 refs in use
 mem()
 gc()
-# output 1912 bytes in use; 38 refs in use
+# output 712 bytes in use; 18 refs in use
 mem()
 del c
-# output 1544 bytes in use; 31 refs in use
+# output 584 bytes in use; 15 refs in use
 mem()
 gc()
 # output 72 bytes in use; 3 refs in use
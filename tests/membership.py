@@ -0,0 +1,37 @@
+# -m 4000
+
+# contains() tests dict keys, list items and substrings.
+d = {"a": 1, "b": 2}
+h = {1: "one", 2: "two", "x": None}
+l = [1, "two", [3], None]
+# output True False True False
+print(contains(d, "a"), contains(d, "z"), contains(h, 2), contains(h, 3))
+# output True True True False
+print(contains(l, "two"), contains(l, [3]), contains(l, None), contains(l, 3))
+# output True True False
+print(contains("hello", "ell"), contains("hello", ""), contains("hello", "lo!"))
+
+# get() falls back to a default instead of raising a KeyError.
+# output 1 None 0 one -1
+print(get(d, "a"), get(d, "z"), get(d, "z", 0), get(h, 1), get(h, 5, -1))
+
+# Counting with get() probes each key once.
+counts = {}
+words = ["a", "b", "a", "c", "b", "a"]
+i = 0
+while i < len(words):
+    w = words[i]
+    counts[w] = get(counts, w, 0) + 1
+    i = i + 1
+# output {"a": 3, "b": 2, "c": 1}
+print(counts)
+
+del d
+del h
+del l
+del counts
+del words
+del i
+del w
+# output 72 bytes in use; 3 refs in use
+mem()
@@ -0,0 +1,58 @@
+# -m 1000000
+
+# Updating a vector makes a new version and leaves the old one alone.
+v = vector([1, 2, 3])
+w = assoc(push(v, 4), 0, "one")
+# output vector([1, 2, 3]) vector(["one", 2, 3, 4])
+print(v, w)
+# output 3 4 3 4 True False
+print(v[-1], w[-1], len(v), len(w), contains(w, 4), contains(v, 4))
+# output vector([1, 2]) vector() True
+print(pop(v), pop(pop(pop(v))), pop(w) == vector(["one", 2, 3]))
+
+# Maps work the same way.
+m = assoc(assoc(pmap(), "a", 1), "b", 2)
+n = dissoc(assoc(m, "c", 3), "a")
+# output 2 2 1 None 3
+print(len(m), len(n), m["a"], get(n, "a"), get(n, "c", 0))
+# output True False True
+print(n == assoc(assoc(pmap(), "c", 3), "b", 2), contains(n, "a"), dissoc(m, "z") == m)
+# output pmap({"a": 1}) pmap()
+print(dissoc(m, "b"), dissoc(dissoc(m, "a"), "b"))
+
+# Keep every version of a growing vector. Each push only copies the path to
+# the new element, so all 1000 versions fit where 1000 lists couldn't.
+versions = {}
+v = vector()
+i = 0
+while i < 1000:
+    versions[i] = v
+    v = push(v, i)
+    i = i + 1
+# output 1000 0 499 999
+print(len(v), v[0], v[499], v[-1])
+# output 0 1 500 999
+print(len(versions[0]), len(versions[1]), len(versions[500]), len(versions[999]))
+# output 302520 bytes in use; 3992 refs in use
+mem()
+
+# Likewise for a map with many keys.
+m = pmap()
+i = 0
+while i < 1000:
+    m = assoc(m, i * 7, i)
+    i = i + 1
+old = m
+m = dissoc(assoc(m, 7, "seven"), 14)
+# output 1000 999 1 seven False True
+print(len(old), len(m), old[7], m[7], contains(m, 14), contains(old, 14))
+
+del v
+del w
+del n
+del i
+del old
+del m
+del versions
+# output 72 bytes in use; 3 refs in use
+mem()
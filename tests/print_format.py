@@ -0,0 +1,12 @@
+# -m 2000
+
+# output 0 7 -7 10 -10 99 100 -100 1000000007
+print(0, 7, -7, 10, -10, 99, 100, -100, 1000000007)
+# output 9223372036854775807 -9223372036854775808
+print(9223372036854775807, -9223372036854775807 - 1)
+# output [0, -1, 12, -123, 1234, -12345]
+print([0, -1, 12, -123, 1234, -12345])
+# output {10: ["c", -5]}
+print({10: ["c", -5]})
+# output 6 plain [""]
+print(6, "plain", [""])
@@ -0,0 +1,32 @@
+# -m 10000
+
+# Records store their fields inline, named by a shared shape.
+left = record({"value": 5, "children": []})
+right = record({"value": 11, "children": []})
+node = record({"value": 6, "children": [left, right]})
+# output record(value=6, children=[record(value=5, children=[]), record(value=11, children=[])])
+print(node)
+# output 6 2 2
+print(node["value"], len(node["children"]), len(node))
+# output 512 bytes in use; 15 refs in use
+mem()
+
+# Fields can be reassigned, through literal and computed names.
+node["value"] = node["value"] + 1
+key = "val" + "ue"
+node[key] = node[key] * 2
+# output 14
+print(node["value"])
+del key
+
+# Records with the same fields compare equal, regardless of order.
+# output True False
+print(record({"a": 1, "b": 2}) == record({"b": 2, "a": 1}), left == right)
+
+# Records can also be built from existing dicts.
+d = {"x": 1, "x": 2}
+r = record(d)
+# output record(x=2) True
+print(r, r == record({"x": 2}))
+del d
+del r
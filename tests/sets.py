@@ -0,0 +1,57 @@
+# -m 100000
+
+# Sets hold each member once.
+s = set([3, 1, 3, "a", 1])
+# output 3 True True False
+print(len(s), contains(s, 1), contains(s, "a"), contains(s, 2))
+# output set() False {5}
+e = set()
+print(e, bool(e), set([5]))
+
+add(s, 2)
+add(s, 2)
+remove(s, 3)
+# output 3 True False
+print(len(s), contains(s, 2), contains(s, 3))
+# output True
+print(s == set(["a", 2, 1]))
+
+# Union and intersection build new sets.
+evens = set()
+odds = set()
+squares = set()
+i = 0
+while i < 200:
+    if i % 2 == 0:
+        add(evens, i)
+    else:
+        add(odds, i)
+    add(squares, i * i)
+    i = i + 1
+both = union(evens, odds)
+common = intersection(squares, evens)
+# output 200 0 8
+print(len(both), len(intersection(evens, odds)), len(common))
+# output True True False
+print(contains(both, 199), contains(common, 196), contains(common, 14))
+# output True True
+print(union(evens, set()) == evens, intersection(set(), odds) == set())
+
+# Removing every member leaves the set empty.
+i = 0
+while i < 200:
+    remove(both, i)
+    i = i + 1
+# output 0 set()
+print(len(both), both)
+
+del s
+del e
+del evens
+del odds
+del squares
+del both
+del common
+del i
+# output 72 bytes in use; 3 refs in use
+mem()
@@ -15,25 +15,25 @@ g = [[0]]
 f[0][0] = g
 g[0][0] = f
 
-# output 904 bytes in use; 21 refs in use
+# output 872 bytes in use; 21 refs in use
 mem()
 gc()
-# output 904 bytes in use; 21 refs in use
+# output 872 bytes in use; 21 refs in use
 mem()
 del f
 del g
-# output 904 bytes in use; 21 refs in use
+# output 872 bytes in use; 21 refs in use
 mem()
 gc()
-# output 584 bytes in use; 13 refs in use
+# output 552 bytes in use; 13 refs in use
 mem()
 del b
 gc()
-# output 584 bytes in use; 13 refs in use
+# output 552 bytes in use; 13 refs in use
 mem()
 del d
 gc()
-# output 584 bytes in use; 13 refs in use
+# output 552 bytes in use; 13 refs in use
 mem()
 del e
 # output 312 bytes in use; 9 refs in use
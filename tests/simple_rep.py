@@ -10,44 +10,44 @@ d = {0: b}
 e = d
 f = [[0]]
 f[0][0] = f
-# output 744 bytes in use; 17 refs in use
+# output 712 bytes in use; 17 refs in use
 mem()
 gc()
-# output 744 bytes in use; 17 refs in use
+# output 712 bytes in use; 17 refs in use
 mem()
 gc()
-# output 744 bytes in use; 17 refs in use
+# output 712 bytes in use; 17 refs in use
 mem()
 gc()
-# output 744 bytes in use; 17 refs in use
+# output 712 bytes in use; 17 refs in use
 mem()
 gc()
-# output 744 bytes in use; 17 refs in use
+# output 712 bytes in use; 17 refs in use
 mem()
 gc()
-# output 744 bytes in use; 17 refs in use
+# output 712 bytes in use; 17 refs in use
 mem()
 gc()
-# output 744 bytes in use; 17 refs in use
+# output 712 bytes in use; 17 refs in use
 mem()
 gc()
-# output 744 bytes in use; 17 refs in use
+# output 712 bytes in use; 17 refs in use
 mem()
 gc()
-# output 744 bytes in use; 17 refs in use
+# output 712 bytes in use; 17 refs in use
 mem()
 gc()
-# output 744 bytes in use; 17 refs in use
+# output 712 bytes in use; 17 refs in use
 mem()
 gc()
-# output 744 bytes in use; 17 refs in use
+# output 712 bytes in use; 17 refs in use
 mem()
 gc()
-# output 744 bytes in use; 17 refs in use
+# output 712 bytes in use; 17 refs in use
 mem()
 gc()
-# output 744 bytes in use; 17 refs in use
+# output 712 bytes in use; 17 refs in use
 mem()
 gc()
-# output 744 bytes in use; 17 refs in use
+# output 712 bytes in use; 17 refs in use
 mem()
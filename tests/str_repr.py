@@ -0,0 +1,26 @@
+# -m 4000
+
+# output 42 -7 None True
+print(str(42), str(-7), str(None), str(True))
+# output "abc" abc
+print(repr("abc"), str("abc"))
+# output [1, "two", [3]] [1, "two", [3]]
+print(str([1, "two", [3]]), repr([1, "two", [3]]))
+# output 12
+print(len(str(123456789012)))
+
+# Building a report by formatting values into strings.
+report = ""
+i = 0
+while i < 5:
+    report = report + str(i * i) + ";"
+    i = i + 1
+# output 0;1;4;9;16;
+print(report)
+# output "0;1;4;9;16;"
+print(repr(report))
+# output 3
+print(len(repr(7) + repr("")))
+del report
+# output 104 bytes in use; 4 refs in use
+mem()
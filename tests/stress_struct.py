@@ -8,7 +8,7 @@ while i < 10000:
     b[i % 4] = i
     i = i + 1
 
-# output [9996, 9997, 9998, 9999] {0: 9996, 1: 9997, 2: 9998, 3: 9999} 10000
+# output [9996, 9997, 9998, 9999] {0: 9996, 1: 9997, 3: 9999, 2: 9998} 10000
 print(a, b, i)
-# output 688 bytes in use; 17 refs in use
+# output 656 bytes in use; 17 refs in use
 mem()
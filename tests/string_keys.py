@@ -0,0 +1,32 @@
+# -m 4000
+
+# Lengths are right whatever padding the string's value has.
+s = ""
+lens = ""
+while len(s) < 20:
+    lens = lens + str(len(s)) + " "
+    s = s + "x"
+# output 0 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20
+print(lens + str(len(s)))
+
+# Comparisons look at the length as well as the contents.
+# output False False True True False
+print("abc" == "abcd", "abcd" == "abc", "abc" < "abcd", "abcd" > "abc", "" == "a")
+# output True True False
+print("abcdefghijklmnopq" == "abcdefgh" + "ijklmnopq", "b" > "abcdefghijk", "x" < "")
+
+# Long keys that differ only near the end hash apart.
+d = {1: 0}
+d["a long key that has a common prefix 1"] = 1
+d["a long key that has a common prefix 2"] = 2
+d["a long key that has a common prefix 3"] = 3
+k = "a long key that has a common prefix "
+# output 1 2 3 4
+print(d[k + "1"], d[k + "2"], d[k + "3"], len(d))
+
+del s
+del lens
+del d
+del k
+# output 72 bytes in use; 3 refs in use
+mem()
@@ -0,0 +1,39 @@
+# -m 4000
+
+# Increments update the variable without touching other references.
+x = 5
+y = x
+x = x + 1
+x = x - 3
+# output 3 5
+print(x, y)
+l = [x]
+x = x + 10
+# output 13 [3]
+print(x, l)
+
+# Comparisons between subscripts work on any subscriptable value.
+a = [3, 1, "s"]
+d = {"k": 1, "j": 3}
+# output True False True
+print(a[0] > a[1], a[1] == a[-2] + 1, d["k"] == a[1])
+# output True True False
+print(a[2] == a[2], d["j"] >= a[0], a[1] < a[1])
+
+# Comparisons against len() give the same answers as the general path.
+i = 0
+n = 0
+while i < len(a):
+    n = n + a[0]
+    i = i + 1
+# output 3 9 True False
+print(i, n, i == len(a), x <= len(d))
+del x
+del y
+del l
+del a
+del d
+del i
+del n
+# output 72 bytes in use; 3 refs in use
+mem()
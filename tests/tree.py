@@ -11,31 +11,31 @@ right = {"value": 4, "children": []}
 right = {"value": 9, "children": [right]}
 right = {"value": 5, "children": [right]}
 tree = {"value": 2, "children": [left, right]}
-# output {"children": [{"children": [..., ...], "value": 7}, {"children": [...], "value": 5}], "value": 2}
+# output {"value": 2, "children": [{"value": 7, "children": [..., ...]}, {"value": 5, "children": [...]}]}
 print(tree)
-# output 3856 bytes in use; 75 refs in use
+# output 1840 bytes in use; 48 refs in use
 mem()
 
 # No freeing should occur
 del left
 del right
-# output 3856 bytes in use; 75 refs in use
+# output 1840 bytes in use; 48 refs in use
 mem()
-# output {"children": [{"children": [..., ...], "value": 7}, {"children": [...], "value": 5}], "value": 2}
+# output {"value": 2, "children": [{"value": 7, "children": [..., ...]}, {"value": 5, "children": [...]}]}
 print(tree)
 
 # Prune an inner node
 del tree["children"][0]["children"][1]
-# output 2600 bytes in use; 51 refs in use
+# output 1256 bytes in use; 33 refs in use
 mem()
-# output {"children": [{"children": [], "value": 2}], "value": 7}
+# output {"value": 7, "children": [{"value": 2, "children": []}]}
 print(tree["children"][0])
 
 # Move the root to its right child
 tree = tree["children"][1]
-# output 1336 bytes in use; 27 refs in use
+# output 664 bytes in use; 18 refs in use
 mem()
-# output 5 {"children": [{"children": [], "value": 4}], "value": 9}
+# output 5 {"value": 9, "children": [{"value": 4, "children": []}]}
 print(tree["value"], tree["children"][0])
 
 # Remove the tree
@@ -0,0 +1,37 @@
+# -m 400000
+
+# Tuples are built by tuple(), since there is no tuple syntax.
+t = tuple(1, "two", [3])
+# output (1, "two", [3]) (5,) () 3
+print(t, tuple(5), tuple(), len(t))
+# output two [3] True False
+print(t[1], t[-1], contains(t, 1), contains(t, 3))
+
+# They compare element by element.
+# output True True True False
+print(tuple(1, 2) == tuple(1, 2), tuple(1, 2) < tuple(1, 3), tuple(1) < tuple(1, 0), tuple(1, 2) == tuple(2, 1))
+
+# Tuples of hashable values make composite dict keys.
+grid = {}
+x = 0
+while x < 30:
+    y = 0
+    while y < 30:
+        grid[tuple(x, y)] = x * y
+        y = y + 1
+    x = x + 1
+# output 900 56 True False
+print(len(grid), grid[tuple(7, 8)], contains(grid, tuple(29, 29)), contains(grid, tuple(30, 0)))
+# output 1
+print(get({tuple("a", tuple(1, 2)): 1}, tuple("a", tuple(1, 2))))
+s = set([tuple(1, 2), tuple(1, 2), tuple(2, 1)])
+# output 2
+print(len(s))
+
+del t
+del grid
+del x
+del y
+del s
+# output 72 bytes in use; 3 refs in use
+mem()
@@ -0,0 +1,32 @@
+# -m 4000
+
+# Quickened integer expressions are computed without boxing temporaries.
+a = [1, 2, 3, 4]
+x = 0
+y = 0
+i = 0
+while i < 20:
+    x = x * 3 + i % 7 + len(a)
+    y = (y + x) % 1000
+    i = i + 1
+# output 7839682215 254 20
+print(x, y, i)
+
+# A value that is shared is not updated in place.
+z = x
+x = x * 2 - 1
+# output 15679364429 7839682215
+print(x, z)
+
+# Expressions that stop being integers still work.
+a = "abc"
+x = "s"
+# output sss 3
+print(x + x + x, len(a))
+del a
+del x
+del y
+del z
+del i
+# output 72 bytes in use; 3 refs in use
+mem()
@@ -0,0 +1,93 @@
+# -m 100000
+
+# A weak reference doesn't keep its target alive.
+x = [1, 2, 3]
+w = weakref(x)
+# output <weakref to 'list'> [1, 2, 3]
+print(w, deref(w))
+del x
+# output <weakref; dead> None
+print(w, deref(w))
+
+# A new value that reuses the target's reference isn't seen through it.
+y = [4]
+# output None [4]
+print(deref(w), y)
+
+# Entries that wrap around the end of the table are purged like any other.
+# 2, 8 and 22 all hash to the last slot of the table, and 30 to the first,
+# so 8, 22 and 30 sit after the end of the table in slot order.
+wrapped = weakdict()
+two = [2]
+eight = [8]
+twenty_two = [22]
+thirty = [30]
+wrapped[2] = two
+wrapped[8] = eight
+wrapped[22] = twenty_two
+wrapped[30] = thirty
+# output weakdict({8: [8], 22: [22], 30: [30], 2: [2]})
+print(wrapped)
+del two
+del twenty_two
+del thirty
+# output 1 weakdict({8: [8]}) [8] True False
+print(len(wrapped), wrapped, wrapped[8], contains(wrapped, 8), contains(wrapped, 22))
+del wrapped
+del eight
+
+# Weak dicts hide an entry as soon as its value is freed.
+cache = weakdict()
+a = [1]
+b = "bee"
+cache["a"] = a
+cache[2] = b
+cache["tmp"] = [9]
+# output weakdict({"a": [1], 2: "bee"}) 2 True False
+print(cache, len(cache), contains(cache, "a"), contains(cache, "tmp"))
+del a
+# output weakdict({2: "bee"}) 1 bee
+print(cache, len(cache), cache[2])
+
+# Values kept alive only by a cycle go when the collector drops the cycle.
+c = {"self": 0}
+c["self"] = c
+wc = weakref(c)
+cache["cycle"] = c
+del c
+# output 2 False
+print(len(cache), deref(wc) == None)
+gc()
+# output 1 None
+print(len(cache), deref(wc))
+
+# Weak references inside garbage cycles are dropped too, while their target
+# lives on.
+t = [7]
+cyc = [0, weakref(t)]
+cyc[0] = cyc
+del cyc
+gc()
+# output [7]
+print(t)
+cache["t"] = t
+del t
+# output weakdict({2: "bee"})
+print(cache)
+
+# Dead entries are purged instead of growing the table.
+i = 0
+while i < 100:
+    cache[i] = [i]
+    i = i + 1
+# output 0 False
+print(len(cache), bool(cache))
+
+del w
+del y
+del b
+del wc
+del cache
+del i
+# output 72 bytes in use; 3 refs in use
+mem()
@@ -1,6 +1,7 @@
 #ifndef TYPES_H
 #define TYPES_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -20,12 +21,6 @@ typedef int32_t reference_t;
  */
 #define NULL_REF ((reference_t) (-1))
 
-/*!
- * An invalid reference that is used to mark dict key slots that were deleted.
- * Linear probing will continue past a TOMBSTONE_REF,
- * so we don't need to rearrange dict elements during deletion.
- */
-#define TOMBSTONE_REF ((reference_t) (-2))
 
 
 /*!
@@ -38,10 +33,24 @@ typedef enum {
     VAL_STRING,         /*!< A string value. */
     VAL_LIST,           /*!< A list value. */
     VAL_DICT,           /*!< A dictionary value. */
+    VAL_RECORD,         /*!< A record with a fixed set of string-named fields. */
+    VAL_SET,            /*!< A set value. */
+    VAL_VECTOR,         /*!< A persistent (immutable) vector value. */
+    VAL_PMAP,           /*!< A persistent (immutable) map value. */
+    VAL_TUPLE,          /*!< A tuple value. */
+    VAL_BYTES,          /*!< An immutable string of bytes. */
+    VAL_BYTEARRAY,      /*!< A mutable, growable string of bytes. */
+    VAL_BIGINT,         /*!< An integer too large to fit in an integer value. */
+    VAL_FLOAT,          /*!< A double-precision floating point value. */
+    VAL_FLOAT_ARRAY,    /*!< A fixed-length array of unboxed floats. */
+    VAL_WEAKREF,        /*!< A reference that doesn't keep its target alive. */
+    VAL_WEAKDICT,       /*!< A dict whose values are only weakly referenced. */
 
     NUM_TYPES,          /*!< The number of different value types. */
 
     VAL_REF_ARRAY,      /*!< A value used internally to store an array of references. */
+    VAL_HAMT_NODE,      /*!< A value used internally as a node of a persistent map. */
+    VAL_BYTE_BUFFER,    /*!< A value used internally to store the contents of bytes. */
 
     VAL_FREE            /*!< Used to indicate that a slot in the memory pool is free. */
 } value_type_t;
@@ -51,18 +60,44 @@ typedef enum {
  * If a value has additional data, it is stored immediately after this struct.
  *
  *  - None and bool types do not contain any data and therefore just use value_t
- *  - Integers are 64-bit and use integer_value_t
+ *  - Integers are 64-bit and use integer_value_t. Results that overflow 64
+ *    bits are bigint_value_t instead, which is still an int to scripts.
+ *  - Floats are doubles and use float_value_t. Arrays of floats
+ *    (float_array_value_t) store them unboxed, so they can be processed a
+ *    vector at a time.
  *  - Strings use string_value_t and are '\0'-terminated
  *  - Lists (list_value_t) are represented as fixed-length arrays of references,
  *    stored in a ref_array_value_t that is allocated from the memory pool
- *  - Dictionaries (dict_value_t) use a linear probing hash table.
+ *  - Dictionaries (dict_value_t) with only string keys share their key layout
+ *    through a shape_t. Otherwise they use a Robin Hood hash table.
  *    Both keys and values are stored as arrays of references,
  *    using ref_array_value_t structs allocated from the memory pool.
+ *  - Records (record_value_t) store their field values inline, and name their
+ *    fields through a shared shape_t descriptor.
+ *  - Sets (set_value_t) use the same hash table as dicts, with keys only.
+ *  - Bytes and bytearrays (bytes_value_t) are a range of a byte_buffer_value_t,
+ *    which may be shared with the values they were sliced from
+ *  - Tuples (tuple_value_t) store their elements inline, and are never
+ *    modified after they are built
+ *  - Persistent vectors (vector_value_t) and maps (pmap_value_t) are tries
+ *    of ref_array_value_t and hamt_node_value_t nodes, which are shared
+ *    between versions and freed by reference counting like any other value.
+ *  - Weak references (weakref_value_t) don't count towards their target's
+ *    ref_count. Every value keeps a list of the weak references to it, so
+ *    that they can be cleared when it is freed. Weak dicts
+ *    (weakdict_value_t) are hash tables whose values are weak references.
  */
 typedef struct {
     /*! This specifies what kind of value is actually represented. */
     value_type_t type;
 
+    /*!
+     * The most recently made weak reference to this value, or NULL_REF if
+     * there are none. The rest follow through each weakref_value_t's next.
+     * This fits in the padding after type, so values are no bigger for it.
+     */
+    reference_t weakrefs;
+
     /*!
      * The number of places this value is currently referenced.
      * Every time a new value refers to this value, ref_count is incremented.
@@ -93,6 +128,76 @@ typedef struct {
     int64_t integer_value;
 } integer_value_t;
 
+/*!
+ * A "big integer value" type that represents integers outside the range of
+ * integer_value_t, as a sign and a magnitude in base 2^64.
+ * If the type of a value_t* is VAL_BIGINT,
+ * it can be cast to a bigint_value_t*.
+ *
+ * Bigints are only ever created for values that don't fit in an int64_t, so
+ * a bigint never equals an integer_value_t.
+ */
+typedef struct {
+    value_t base;
+
+    /*! Whether the integer is negative. */
+    bool negative;
+
+    /*! The number of limbs in use. The most significant one is nonzero. */
+    size_t length;
+
+    /*! The limbs of the magnitude, least significant first. */
+    uint64_t limbs[];
+} bigint_value_t;
+
+/*!
+ * A "float value" type that represents floating point numbers.
+ * If the type of a value_t* is VAL_FLOAT,
+ * it can be cast to a float_value_t*.
+ */
+typedef struct {
+    value_t base;
+
+    /*! The number this float_value_t represents. */
+    double float_value;
+} float_value_t;
+
+/*!
+ * A "float array value" type that represents arrays of floats.
+ * If the type of a value_t* is VAL_FLOAT_ARRAY,
+ * it can be cast to a float_array_value_t*.
+ *
+ * The elements are stored inline as doubles rather than as references, and
+ * an array's length is fixed when it is created.
+ */
+typedef struct {
+    value_t base;
+
+    /*! The number of elements. */
+    int64_t size;
+
+    /*! The elements. */
+    double values[];
+} float_array_value_t;
+
+/*!
+ * A "weak reference value" type that refers to a value without keeping it
+ * alive. If the type of a value_t* is VAL_WEAKREF,
+ * it can be cast to a weakref_value_t*.
+ */
+typedef struct {
+    value_t base;
+
+    /*!
+     * The value this refers to, which this doesn't hold a count on, or
+     * NULL_REF once that value has been freed.
+     */
+    reference_t target;
+
+    /*! The next weak reference to the same target, or NULL_REF. */
+    reference_t next;
+} weakref_value_t;
+
 /*!
  * A "string value" type that represents strings.
  * If the type of a value_t* is VAL_STRING, it can be cast to a string_value_t*.
@@ -103,7 +208,9 @@ typedef struct {
     /*!
      * The string value this string_value_t represents.
      * The characters are stored immediately following the value_t struct.
-     * The string is '\0'-terminated.
+     * The string is '\0'-terminated, and every byte after the terminator up
+     * to value_size is also '\0', so that string_length can find the end
+     * from value_size without scanning the whole string.
      */
     char string_value[];
 } string_value_t;
@@ -129,9 +236,19 @@ typedef struct {
 } list_value_t;
 
 
+/* Declared in shape.h. */
+struct shape;
+
 /*!
  * A "dictionary value" type that represents dictionaries.
  * If the type of a value_t* is VAL_DICT, it can be cast to a dict_value_t*.
+ *
+ * Dicts have two representations. A dict whose keys are all strings starts
+ * out "shaped": its keys are described by a shape_t shared with every other
+ * dict that had the same keys added in the same order, and its values are
+ * stored densely in slot order. Adding a non-string key, deleting a key, or
+ * growing too large switches the dict to a Robin Hood hash table.
+ * A dict is shaped exactly when its keys are NULL_REF.
  */
 typedef struct {
     value_t base;
@@ -142,29 +259,258 @@ typedef struct {
     int64_t size;
 
     /*!
-     * The number of key slots currently occupied in the dict.
-     * This can be greater than size if there are tombstones.
+     * The shape describing the keys of a shaped dict. Unused by hash table
+     * dicts. This is not a reference.
      */
-    int64_t occupied;
+    struct shape *shape;
 
     /*!
-     * The reference to the ref_array_value_t containing the dictionary's keys.
-     * Used to implement O(1) lookup.
-     * Deleting keys from dictionaries sets their slots to TOMBSTONE_REF,
-     * so TOMBSTONE_REF should be treated as NULL_REF in the reference graph.
+     * The reference to the ref_array_value_t containing the dictionary's keys,
+     * or NULL_REF for shaped dicts. Used to implement O(1) lookup.
      */
     reference_t keys;
 
     /*!
      * The reference to the ref_array_value_t containing the dictionary's values.
+     * Shaped dicts store their values in slot order, and may use NULL_REF
+     * when they are empty.
      */
     reference_t values;
 } dict_value_t;
 
+/*!
+ * A "record value" type that represents records.
+ * If the type of a value_t* is VAL_RECORD, it can be cast to a record_value_t*.
+ */
+typedef struct {
+    value_t base;
+
+    /*!
+     * The shape naming this record's fields. This is not a reference: shapes
+     * are shared between records and are not allocated from the memory pool.
+     */
+    struct shape *shape;
+
+    /*!
+     * The field values, stored immediately following the struct.
+     * There is one value per key of the shape, in slot order.
+     */
+    reference_t values[];
+} record_value_t;
+
+/*!
+ * A "set value" type that represents sets.
+ * If the type of a value_t* is VAL_SET, it can be cast to a set_value_t*.
+ */
+typedef struct {
+    value_t base;
+
+    /*!
+     * The number of members currently stored in the set.
+     */
+    int64_t size;
+
+    /*!
+     * The reference to the ref_array_value_t holding the set's members, laid
+     * out like a hash table dict's keys. Empty sets may use NULL_REF.
+     */
+    reference_t keys;
+} set_value_t;
+
+/*!
+ * A "weak dict value" type that represents dicts which don't keep their
+ * values alive. If the type of a value_t* is VAL_WEAKDICT,
+ * it can be cast to a weakdict_value_t*.
+ *
+ * Entries whose value has been freed still occupy the table until the next
+ * purge, but are never visible to scripts.
+ */
+typedef struct {
+    value_t base;
+
+    /*!
+     * The number of entries in the table, including any that have died
+     * since the last purge.
+     */
+    int64_t size;
+
+    /*!
+     * The reference to the ref_array_value_t holding the keys, laid out like
+     * a hash table dict's keys. Empty weak dicts may use NULL_REF.
+     */
+    reference_t keys;
+
+    /*!
+     * The reference to the ref_array_value_t holding a weakref_value_t for
+     * each key's value, at the same index as the key.
+     */
+    reference_t values;
+
+    /*!
+     * The value of weakrefs_cleared() when dead entries were last purged.
+     * No entries can have died since unless it has changed.
+     */
+    uint64_t purged;
+} weakdict_value_t;
+
+/*!
+ * A "vector value" type that represents persistent vectors.
+ * If the type of a value_t* is VAL_VECTOR, it can be cast to a vector_value_t*.
+ *
+ * Vectors are never modified. Their elements are stored in a trie of
+ * ref_array_value_t nodes with up to 32 children each, indexed by successive
+ * 5-bit digits of the element index. Updates copy only the nodes on the path
+ * to the element they change, and share the rest with the old version.
+ */
+typedef struct {
+    value_t base;
+
+    /*!
+     * The number of elements in the vector.
+     */
+    int64_t size;
+
+    /*!
+     * The number of index bits consumed below the root. This is 0 when the
+     * root is itself a leaf holding the elements.
+     */
+    int64_t shift;
+
+    /*!
+     * The reference to the root node of the trie, or NULL_REF when empty.
+     * Nodes only have as many slots as they have children.
+     */
+    reference_t root;
+} vector_value_t;
+
+/*!
+ * A "persistent map value" type that represents persistent maps.
+ * If the type of a value_t* is VAL_PMAP, it can be cast to a pmap_value_t*.
+ *
+ * Like vectors, maps are never modified: updates path-copy a hash array
+ * mapped trie of hamt_node_value_t nodes, indexed by successive 5-bit digits
+ * of the key's hash.
+ */
+typedef struct {
+    value_t base;
+
+    /*!
+     * The number of keys in the map.
+     */
+    int64_t size;
+
+    /*!
+     * The reference to the root hamt_node_value_t, or NULL_REF when empty.
+     */
+    reference_t root;
+} pmap_value_t;
+
+/*!
+ * A node of a persistent map's trie.
+ * If the type of a value_t* is VAL_HAMT_NODE,
+ * it can be cast to a hamt_node_value_t*.
+ *
+ * Each bit of the two maps stands for one value of the hash digit at this
+ * level. A bit set in datamap means that a key with that digit is stored in
+ * this node; a bit set in nodemap means that the keys with that digit are
+ * stored in a child node. The entries array holds the key/value pairs for
+ * datamap in bit order, followed by the children for nodemap in bit order.
+ *
+ * Keys whose hashes are entirely equal end up below the last digit, in a
+ * ref_array_value_t holding their key/value pairs.
+ */
+typedef struct {
+    value_t base;
+
+    uint32_t datamap;
+    uint32_t nodemap;
+
+    /*!
+     * The pairs and children, stored immediately following the struct.
+     */
+    reference_t entries[];
+} hamt_node_value_t;
+
+/*!
+ * A "tuple value" type that represents tuples.
+ * If the type of a value_t* is VAL_TUPLE, it can be cast to a tuple_value_t*.
+ */
+typedef struct {
+    value_t base;
+
+    /*!
+     * The number of elements in the tuple.
+     */
+    int64_t size;
+
+    /*!
+     * The tuple's hash, which is only valid if hashed is set. Tuples are
+     * immutable, so the hash is computed at most once.
+     */
+    uint64_t hash;
+    bool hashed;
+
+    /*!
+     * The elements, stored immediately following the struct.
+     */
+    reference_t values[];
+} tuple_value_t;
+
+/*!
+ * A "bytes value" type that represents bytes and bytearrays.
+ * If the type of a value_t* is VAL_BYTES or VAL_BYTEARRAY,
+ * it can be cast to a bytes_value_t*.
+ *
+ * Unlike strings, bytes are length-prefixed and may contain '\0'. Slicing
+ * doesn't copy: the slice refers to a range of the same buffer. A bytearray
+ * copies its buffer before modifying it if anything else refers to it.
+ */
+typedef struct {
+    value_t base;
+
+    /*!
+     * The reference to the byte_buffer_value_t holding the contents, or
+     * NULL_REF if the value is empty.
+     */
+    reference_t buffer;
+
+    /*!
+     * The offset of the first byte within the buffer.
+     */
+    int64_t start;
+
+    /*!
+     * The number of bytes.
+     */
+    int64_t length;
+} bytes_value_t;
+
+/*!
+ * A "byte buffer" value that is used within the evaluator to hold the
+ * contents of bytes and bytearrays.
+ * If the type of a value_t* is VAL_BYTE_BUFFER,
+ * it can be cast to a byte_buffer_value_t*.
+ */
+typedef struct {
+    value_t base;
+
+    /*!
+     * The number of bytes that can be stored in this buffer.
+     */
+    size_t capacity;
+
+    /*!
+     * The bytes, stored immediately following the struct.
+     */
+    uint8_t data[];
+} byte_buffer_value_t;
+
 /*!
  * A "ref array" value that is used within the evaluator to hold lists of
  * reference. This is used by list_value_t to store the elements of the list
  * and by dict_value_t to store the both the lists of key and values.
+ * The keys of a hash table are a key array, which also stores each slot's
+ * hash after the references (see make_reference_keyarray).
  * If the type of a value_t* is VAL_REF_ARRAY,
  * it can be cast to a ref_array_value_t*.
  */